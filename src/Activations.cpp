@@ -0,0 +1,123 @@
+// clang-format off
+#include "Activations.h"
+#include "Kernels.h"
+#include <algorithm>
+#include <cmath>
+// clang-format on
+
+namespace Engine {
+
+const char* activationName(Activation activation)
+{
+    switch (activation)
+    {
+    case Activation::Tanh:
+        return "tanh";
+    case Activation::FastTanh:
+        return "tanh (fast)";
+    case Activation::Sigmoid:
+        return "sigmoid";
+    case Activation::FastSigmoid:
+        return "sigmoid (fast)";
+    case Activation::Relu:
+        return "ReLU";
+    case Activation::LeakyRelu:
+        return "leaky ReLU";
+    case Activation::Linear:
+        return "linear";
+    case Activation::Softmax:
+        return "softmax";
+    }
+
+    return "unknown";
+}
+
+template <typename T>
+static void softmax(T* values, unsigned long n)
+{
+    // Shifting by the maximum keeps exp() from overflowing without changing the result
+    const auto max = *std::max_element(values, values + n);
+
+    T sum = 0;
+    for (auto i = 0ul; i < n; ++i)
+    {
+        values[i] = std::exp(values[i] - max);
+        sum += values[i];
+    }
+
+    for (auto i = 0ul; i < n; ++i)
+        values[i] /= sum;
+}
+
+template <typename T>
+void activate(Activation activation, T* values, unsigned long rows, unsigned long width)
+{
+    const auto n = rows * width;
+
+    switch (activation)
+    {
+    case Activation::Tanh:
+        for (auto i = 0ul; i < n; ++i)
+            values[i] = std::tanh(values[i]);
+        break;
+    case Activation::FastTanh:
+        Kernels::tanhApprox(values, n);
+        break;
+    case Activation::Sigmoid:
+        for (auto i = 0ul; i < n; ++i)
+            values[i] = T(1) / (T(1) + std::exp(-values[i]));
+        break;
+    case Activation::FastSigmoid:
+        // sigmoid(x) = tanh(x / 2) / 2 + 1 / 2
+        Kernels::tanhApprox(values, n, T(0.5), T(0.5), T(0.5));
+        break;
+    case Activation::Relu:
+        Kernels::leakyRelu(values, T(0), n);
+        break;
+    case Activation::LeakyRelu:
+        Kernels::leakyRelu(values, static_cast<T>(s_leakySlope), n);
+        break;
+    case Activation::Linear:
+        break;
+    case Activation::Softmax:
+        for (auto r = 0ul; r < rows; ++r)
+            softmax(values + r * width, width);
+        break;
+    }
+}
+
+template <typename T>
+void multiplyDerivative(Activation activation, const T* outputs, T* gradients, unsigned long n)
+{
+    switch (activation)
+    {
+    case Activation::Tanh:
+    case Activation::FastTanh:
+        for (auto i = 0ul; i < n; ++i)
+            gradients[i] *= T(1) - outputs[i] * outputs[i];
+        break;
+    case Activation::Sigmoid:
+    case Activation::FastSigmoid:
+        for (auto i = 0ul; i < n; ++i)
+            gradients[i] *= outputs[i] * (T(1) - outputs[i]);
+        break;
+    case Activation::Relu:
+        for (auto i = 0ul; i < n; ++i)
+            gradients[i] = outputs[i] > T(0) ? gradients[i] : T(0);
+        break;
+    case Activation::LeakyRelu:
+        for (auto i = 0ul; i < n; ++i)
+            gradients[i] *= outputs[i] > T(0) ? T(1) : static_cast<T>(s_leakySlope);
+        break;
+    case Activation::Linear:
+    case Activation::Softmax:
+        break;
+    }
+}
+
+template void activate(Activation, double*, unsigned long, unsigned long);
+template void activate(Activation, float*, unsigned long, unsigned long);
+template void multiplyDerivative(Activation, const double*, double*, unsigned long);
+template void multiplyDerivative(Activation, const float*, float*, unsigned long);
+
+} // namespace Engine
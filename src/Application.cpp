@@ -1,8 +1,10 @@
 // clang-format off
 #include "Application.h"
 #include "Logging.h"
+#include "Profiler.h"
 #include "Events/WindowEvents.h"
 #include "Layers/MainLayer.h"
+#include "Layers/MetricsLayer.h"
 #include "Layers/NetworkLayer.h"
 #include "GLFW/glfw3.h"
 // clang-format on
@@ -18,7 +20,10 @@ Application::Application()
 {
     m_mainWindow->setCallbackFunction(BIND(onEvent));
     m_layers.pushLayer(new MainLayer);
-    m_layers.pushOverlay(new NetworkLayer);
+
+    auto* network = new NetworkLayer;
+    m_layers.pushOverlay(network);
+    m_layers.pushOverlay(new MetricsLayer(network->metrics()));
 }
 
 Application::~Application()
@@ -35,26 +40,70 @@ Application& Application::instance()
 
 void Application::run()
 {
+    // Profiling builds record the whole run, the trace keeps each thread's latest events
+    ENGINE_PROFILE_THREAD("main");
+    if constexpr (Profiler::s_enabled)
+        Profiler::start();
+
     m_imgui->onAttach();
 
     while (m_running)
     {
+        ENGINE_PROFILE_SCOPE("frame");
         auto currentFrame = glfwGetTime();
         m_frameTime = currentFrame - m_lastFrame;
+
+        // A frame's phases are known once it has been swapped, it is added as the next one
+        // starts. The first frame has no start to measure from.
+        if (m_lastFrame > 0)
+        {
+            m_timing.frame = m_frameTime;
+            m_frameStats.add(m_timing);
+        }
         m_lastFrame = currentFrame;
 
-        m_imgui->runImGui();
-        m_imgui->onUpdate(m_frameTime);
+        {
+            ENGINE_PROFILE_SCOPE("ImGui begin");
+            m_imgui->runImGui();
+        }
+        {
+            ENGINE_PROFILE_SCOPE(m_imgui->name());
+            m_imgui->onUpdate(m_frameTime);
+        }
 
         for (auto* i : m_layers)
+        {
+            ENGINE_PROFILE_SCOPE(i->name());
             i->onUpdate(m_frameTime);
+        }
+
+        const auto renderStart = glfwGetTime();
+        m_timing.update = renderStart - currentFrame;
+        {
+            ENGINE_PROFILE_SCOPE("ImGui end");
+            m_imgui->endImGui();
+        }
 
-        m_imgui->endImGui();
+        const auto swapStart = glfwGetTime();
+        m_timing.render = swapStart - renderStart;
+        m_mainWindow->swapBuffers();
 
-        m_mainWindow->update();
+        const auto eventsStart = glfwGetTime();
+        m_timing.swap = eventsStart - swapStart;
+        m_mainWindow->pollEvents();
+        m_timing.events = glfwGetTime() - eventsStart;
     }
 
     m_imgui->onDetach();
+
+    // Layers own threads that log, they are stopped before main() shuts the logger down
+    m_layers.clear();
+
+    if constexpr (Profiler::s_enabled)
+    {
+        Profiler::stop();
+        Profiler::write("profile.json");
+    }
 }
 
 void Application::onEvent(Event& event)
@@ -1,6 +1,7 @@
 #pragma once
 
 // clang-format off
+#include "FrameStats.h"
 #include "Window.h"
 #include "Layers/ImGuiLayer.h"
 #include "Layers/LayerStack.h"
@@ -21,12 +22,15 @@ public:
     bool onWindowClosedEvent(Event& event);
 
     inline Window* window() { return m_mainWindow; }
+    inline const FrameStats& frameStats() const { return m_frameStats; }
     inline void close() { m_running = false; }
 
 private:
     bool m_running = true;
     double m_frameTime = 0;
     double m_lastFrame = 0;
+    FrameTiming m_timing;
+    FrameStats m_frameStats;
 
     Window* m_mainWindow;
     ImGuiLayer* m_imgui;
@@ -0,0 +1,253 @@
+// clang-format off
+#include "BinaryDataset.h"
+#include "Logging.h"
+#include "TrainingData.h"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+static constexpr std::uint64_t s_alignment = 64;
+
+static std::uint64_t alignUp(std::uint64_t offset)
+{
+    return (offset + s_alignment - 1) / s_alignment * s_alignment;
+}
+
+static std::uint64_t dtypeSize(BinaryDataset::DType dtype)
+{
+    return dtype == BinaryDataset::DType::Float32 ? sizeof(float) : sizeof(double);
+}
+
+template <typename T>
+static constexpr BinaryDataset::DType dtypeOf()
+{
+    return sizeof(T) == sizeof(float) ? BinaryDataset::DType::Float32
+                                      : BinaryDataset::DType::Float64;
+}
+
+BinaryDataset::BinaryDataset(std::string_view path)
+{
+    const std::string file(path);
+    const auto fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        ENGINE_ERROR("Could not open dataset {}", file);
+        return;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<std::uint64_t>(info.st_size) < sizeof(Header))
+    {
+        ENGINE_ERROR("Dataset {} is too small to hold a header", file);
+        ::close(fd);
+        return;
+    }
+
+    const auto size = static_cast<unsigned long>(info.st_size);
+    auto* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        ENGINE_ERROR("Could not map dataset {}", file);
+        return;
+    }
+
+    // Batches are mostly read front to back
+    ::madvise(mapping, size, MADV_SEQUENTIAL);
+
+    const auto* header = static_cast<const Header*>(mapping);
+
+    // A section has to be aligned and hold samples x width values inside the file. The bound is
+    // divided down rather than the counts multiplied up, so huge counts cannot wrap past it.
+    auto fits = [&](std::uint64_t offset, std::uint64_t width) {
+        if (offset % s_alignment != 0 || offset > size)
+            return false;
+
+        const auto values = (size - offset) / dtypeSize(header->dtype);
+        return width == 0 || (width <= values && header->samples <= values / width);
+    };
+
+    const auto valid = std::memcmp(header->magic, s_magic, sizeof(s_magic)) == 0 &&
+                       header->version == s_version &&
+                       (header->dtype == DType::Float64 || header->dtype == DType::Float32) &&
+                       fits(header->inputsOffset, header->inputWidth) &&
+                       fits(header->targetsOffset, header->targetWidth);
+
+    if (!valid)
+    {
+        ENGINE_ERROR("{} is not a valid version {} dataset", file, s_version);
+        ::munmap(mapping, size);
+        return;
+    }
+
+    m_header = header;
+    m_data = static_cast<const unsigned char*>(mapping);
+    m_size = size;
+}
+
+BinaryDataset::~BinaryDataset()
+{
+    if (m_data)
+        ::munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+
+template <typename T>
+std::span<const T> BinaryDataset::section(std::uint64_t offset, unsigned long width,
+                                          unsigned long first, unsigned long count) const
+{
+    assert(isOpen());
+    assert(dtype() == dtypeOf<T>());
+    assert(first + count <= samples());
+
+    const auto* base = reinterpret_cast<const T*>(m_data + offset);
+    return {base + first * width, count * width};
+}
+
+template <typename T>
+std::span<const T> BinaryDataset::inputs(unsigned long first, unsigned long count) const
+{
+    return section<T>(m_header->inputsOffset, inputWidth(), first, count);
+}
+
+template <typename T>
+std::span<const T> BinaryDataset::targets(unsigned long first, unsigned long count) const
+{
+    return section<T>(m_header->targetsOffset, targetWidth(), first, count);
+}
+
+template std::span<const float> BinaryDataset::inputs(unsigned long, unsigned long) const;
+template std::span<const double> BinaryDataset::inputs(unsigned long, unsigned long) const;
+template std::span<const float> BinaryDataset::targets(unsigned long, unsigned long) const;
+template std::span<const double> BinaryDataset::targets(unsigned long, unsigned long) const;
+
+// -----------------------------------------------------------------------------
+static void writeValues(std::ofstream& out, const std::vector<double>& values,
+                        BinaryDataset::DType dtype)
+{
+    if (dtype == BinaryDataset::DType::Float64)
+    {
+        out.write(reinterpret_cast<const char*>(values.data()),
+                  static_cast<std::streamsize>(values.size() * sizeof(double)));
+        return;
+    }
+
+    for (auto v : values)
+    {
+        const auto f = static_cast<float>(v);
+        out.write(reinterpret_cast<const char*>(&f), sizeof(f));
+    }
+}
+
+static void pad(std::ofstream& out, std::uint64_t offset)
+{
+    static constexpr char zeros[s_alignment] = {};
+    const auto position = static_cast<std::uint64_t>(out.tellp());
+    out.write(zeros, static_cast<std::streamsize>(offset - position));
+}
+
+static bool writeDataset(std::ofstream& out, std::string_view textPath,
+                         BinaryDataset::DType dtype, std::string& error)
+{
+    using Header = BinaryDataset::Header;
+
+    Header header{};
+    std::memcpy(header.magic, BinaryDataset::s_magic, sizeof(BinaryDataset::s_magic));
+    header.version = BinaryDataset::s_version;
+    header.dtype = dtype;
+    header.inputsOffset = alignUp(sizeof(Header));
+
+    // The text is streamed twice, once per plane, so memory use does not grow with the dataset.
+    // The first sample sets the widths every other sample is checked against.
+    std::vector<double> inputs;
+    std::vector<double> targets;
+    {
+        TrainingData text(textPath);
+        if (text.getNextInputs(inputs) == 0 || text.getTargetOutputs(targets) == 0)
+        {
+            error = text.hasError() ? text.error() : "no samples found in " + std::string(textPath);
+            return false;
+        }
+
+        header.inputWidth = inputs.size();
+        header.targetWidth = targets.size();
+        out.seekp(static_cast<std::streamoff>(header.inputsOffset));
+
+        do
+        {
+            writeValues(out, inputs, dtype);
+            ++header.samples;
+        } while (text.readSample(inputs, targets));
+
+        if (text.hasError())
+        {
+            error = text.error();
+            return false;
+        }
+    }
+
+    header.targetsOffset =
+        alignUp(header.inputsOffset + header.samples * header.inputWidth * dtypeSize(dtype));
+    pad(out, header.targetsOffset);
+
+    {
+        TrainingData text(textPath);
+        for (auto s = 0ul; s < header.samples; ++s)
+        {
+            text.readSample(inputs, targets);
+            writeValues(out, targets, dtype);
+        }
+    }
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return true;
+}
+
+bool BinaryDataset::fromText(std::string_view textPath, std::string_view binaryPath, DType dtype,
+                             std::string& error)
+{
+    // Written next to the target and renamed over it once complete, so a failed conversion
+    // never leaves a truncated dataset behind
+    const auto target = std::string(binaryPath);
+    const auto temporary = target + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            error = "could not create " + temporary;
+            return false;
+        }
+
+        const auto written = writeDataset(out, textPath, dtype, error);
+        out.flush();
+        if (!written || !out)
+        {
+            if (written)
+                error = "failed writing " + temporary;
+            out.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(temporary.c_str(), target.c_str()) != 0)
+    {
+        error = "could not replace " + target;
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Engine
@@ -0,0 +1,80 @@
+/* Packed binary training data, read through a read-only memory map.
+ *
+ * Layout (little endian):
+ *   Header         64 bytes, see BinaryDataset::Header
+ *   Inputs         samples x inputWidth values, row-major
+ *   Targets        samples x targetWidth values, row-major
+ *
+ * Both sections start on a 64 byte boundary. Keeping inputs and targets in separate planes means
+ * any run of consecutive samples is already a contiguous batch block, so the network reads
+ * batches straight out of the mapping without copying. */
+#pragma once
+
+// clang-format off
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+// clang-format on
+
+namespace Engine {
+
+class BinaryDataset
+{
+public:
+    enum class DType : std::uint32_t { Float64 = 0, Float32 = 1 };
+
+    struct Header
+    {
+        char magic[8];
+        std::uint32_t version;
+        DType dtype;
+        std::uint64_t samples;
+        std::uint64_t inputWidth;
+        std::uint64_t targetWidth;
+        std::uint64_t inputsOffset;
+        std::uint64_t targetsOffset;
+        std::uint8_t reserved[8];
+    };
+
+    static_assert(sizeof(Header) == 64);
+    static constexpr char s_magic[8] = {'C', 'N', 'N', 'D', 'A', 'T', 'A', '\0'};
+    static constexpr std::uint32_t s_version = 1;
+
+public:
+    explicit BinaryDataset(std::string_view path);
+    ~BinaryDataset();
+
+    BinaryDataset(const BinaryDataset&) = delete;
+    BinaryDataset& operator=(const BinaryDataset&) = delete;
+
+public:
+    inline bool isOpen() const { return m_header != nullptr; }
+    inline unsigned long samples() const { return m_header->samples; }
+    inline unsigned long inputWidth() const { return m_header->inputWidth; }
+    inline unsigned long targetWidth() const { return m_header->targetWidth; }
+    inline DType dtype() const { return m_header->dtype; }
+
+    // Zero-copy views of `count` consecutive samples starting at `first`. T has to match dtype().
+    template <typename T>
+    std::span<const T> inputs(unsigned long first, unsigned long count = 1) const;
+    template <typename T>
+    std::span<const T> targets(unsigned long first, unsigned long count = 1) const;
+
+    // Converts the whitespace separated text format (one line of inputs followed by one line of
+    // targets per sample) into the binary format. Widths are taken from the first sample.
+    static bool fromText(std::string_view textPath, std::string_view binaryPath, DType dtype,
+                         std::string& error);
+
+private:
+    template <typename T>
+    std::span<const T> section(std::uint64_t offset, unsigned long width, unsigned long first,
+                               unsigned long count) const;
+
+private:
+    const Header* m_header = nullptr;
+    const unsigned char* m_data = nullptr;
+    unsigned long m_size = 0;
+};
+
+} // namespace Engine
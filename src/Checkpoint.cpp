@@ -0,0 +1,476 @@
+// clang-format off
+#include "Checkpoint.h"
+#include "Logging.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+// clang-format on
+
+namespace Engine {
+
+static constexpr std::uint64_t s_alignment = 64;
+
+static std::uint64_t alignUp(std::uint64_t offset)
+{
+    return (offset + s_alignment - 1) / s_alignment * s_alignment;
+}
+
+static std::uint64_t dtypeSize(Checkpoint::DType dtype)
+{
+    return dtype == Checkpoint::DType::Float32 ? sizeof(float) : sizeof(double);
+}
+
+template <typename T>
+static constexpr Checkpoint::DType dtypeOf()
+{
+    return sizeof(T) == sizeof(float) ? Checkpoint::DType::Float32 : Checkpoint::DType::Float64;
+}
+
+template <typename T>
+static void copyBytes(std::span<const T> values, std::vector<unsigned char>& bytes)
+{
+    const auto* data = reinterpret_cast<const unsigned char*>(values.data());
+    bytes.assign(data, data + values.size_bytes());
+}
+
+Checkpoint::Checkpoint(std::string_view path)
+{
+    const std::string file(path);
+    const auto fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        ENGINE_ERROR("Could not open checkpoint {}", file);
+        return;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<std::uint64_t>(info.st_size) < sizeof(Header))
+    {
+        ENGINE_ERROR("Checkpoint {} is too small to hold a header", file);
+        ::close(fd);
+        return;
+    }
+
+    // Private and writable: pages are only copied once something writes to them
+    const auto size = static_cast<unsigned long>(info.st_size);
+    auto* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        ENGINE_ERROR("Could not map checkpoint {}", file);
+        return;
+    }
+
+    const auto* data = static_cast<const unsigned char*>(mapping);
+    const auto* header = static_cast<const Header*>(mapping);
+
+    // Every section has to be aligned and inside the file, optional ones may be absent
+    auto fits = [&](std::uint64_t offset, std::uint64_t bytes, bool optional) {
+        if (optional && offset == 0)
+            return true;
+        return offset != 0 && offset % s_alignment == 0 && offset <= size && bytes <= size - offset;
+    };
+
+    auto valid = std::memcmp(header->magic, s_magic, sizeof(s_magic)) == 0 &&
+                 header->version == s_version &&
+                 (header->dtype == DType::Float64 || header->dtype == DType::Float32) &&
+                 header->shells >= 2 && header->shells <= size / sizeof(ShellRecord);
+
+    if (valid)
+    {
+        const auto parameterBytes = header->parameters * dtypeSize(header->dtype);
+        valid = header->parameters <= size &&
+                fits(header->shellsOffset, header->shells * sizeof(ShellRecord), false) &&
+                fits(header->optimizerOffset, sizeof(OptimizerRecord), false) &&
+                fits(header->cursorOffset, sizeof(TrainingCursor), false) &&
+                fits(header->parametersOffset, parameterBytes, false) &&
+                fits(header->firstStateOffset, parameterBytes, true) &&
+                fits(header->secondStateOffset, parameterBytes, true);
+    }
+
+    if (valid)
+    {
+        // The parameter count has to follow from the topology, activations have to be known
+        const auto* shells = reinterpret_cast<const ShellRecord*>(data + header->shellsOffset);
+        auto parameters = 0ul;
+        for (auto l = 0ul; l < header->shells && valid; ++l)
+        {
+            const auto& shell = shells[l];
+            const auto last = l + 1 == header->shells;
+            valid = shell.size > 0 && shell.activation < s_activations.size() &&
+                    (last || shell.activation != static_cast<std::uint32_t>(Activation::Softmax));
+            if (l > 0)
+                parameters += shell.size * (shells[l - 1].size + 1);
+
+            m_topology.push_back(shell.size);
+        }
+
+        const auto* optimizer =
+            reinterpret_cast<const OptimizerRecord*>(data + header->optimizerOffset);
+        valid = valid && parameters == header->parameters &&
+                optimizer->type <= static_cast<std::uint32_t>(OptimizerType::Adam) &&
+                optimizer->schedule <=
+                    static_cast<std::uint32_t>(LearningRateSchedule::Type::Cosine);
+    }
+
+    if (!valid)
+    {
+        ENGINE_ERROR("{} is not a valid version {} checkpoint", file, s_version);
+        m_topology.clear();
+        ::munmap(mapping, size);
+        return;
+    }
+
+    m_header = header;
+    m_data = static_cast<unsigned char*>(mapping);
+    m_size = size;
+}
+
+Checkpoint::~Checkpoint()
+{
+    if (m_data)
+        ::munmap(m_data, m_size);
+}
+
+Activation Checkpoint::activation(unsigned long shell) const
+{
+    assert(isOpen() && shell < m_topology.size());
+
+    const auto* shells = reinterpret_cast<const ShellRecord*>(m_data + m_header->shellsOffset);
+    return static_cast<Activation>(shells[shell].activation);
+}
+
+OptimizerOptions Checkpoint::optimizerOptions() const
+{
+    assert(isOpen());
+
+    const auto& record = optimizer();
+    OptimizerOptions options;
+    options.type = static_cast<OptimizerType>(record.type);
+    options.learningRate = record.learningRate;
+    options.momentum = record.momentum;
+    options.decay = record.decay;
+    options.beta1 = record.beta1;
+    options.beta2 = record.beta2;
+    options.epsilon = record.epsilon;
+    options.schedule.type = static_cast<LearningRateSchedule::Type>(record.schedule);
+    options.schedule.warmupSteps = record.warmupSteps;
+    options.schedule.decaySteps = record.decaySteps;
+    options.schedule.decayRate = record.decayRate;
+    options.schedule.minRate = record.minRate;
+
+    return options;
+}
+
+template <typename T>
+std::span<T> Checkpoint::parameters()
+{
+    assert(isOpen());
+    assert(dtype() == dtypeOf<T>());
+
+    return {reinterpret_cast<T*>(m_data + m_header->parametersOffset), m_header->parameters};
+}
+
+template <typename T>
+std::span<const T> Checkpoint::parameters() const
+{
+    return state<T>(m_header->parametersOffset);
+}
+
+template <typename T>
+std::span<const T> Checkpoint::state(std::uint64_t offset) const
+{
+    assert(isOpen());
+    assert(dtype() == dtypeOf<T>());
+
+    if (offset == 0)
+        return {};
+
+    return {reinterpret_cast<const T*>(m_data + offset), m_header->parameters};
+}
+
+template <typename T>
+std::span<const T> Checkpoint::firstState() const
+{
+    return state<T>(m_header->firstStateOffset);
+}
+
+template <typename T>
+std::span<const T> Checkpoint::secondState() const
+{
+    return state<T>(m_header->secondStateOffset);
+}
+
+template <typename T, typename Acc>
+bool Checkpoint::restore(BasicNetwork<T, Acc>& network) const
+{
+    if (!isOpen())
+        return false;
+
+    if (dtype() != dtypeOf<T>() || network.topology() != m_topology)
+    {
+        ENGINE_ERROR("Checkpoint does not match the network's topology or precision");
+        return false;
+    }
+
+    const auto parameters = this->parameters<T>();
+    std::copy(parameters.begin(), parameters.end(), network.parameters().begin());
+
+    for (auto l = 1ul; l < m_topology.size(); ++l)
+        network.setActivation(l, activation(l));
+
+    network.optimizer().restore(optimizerOptions(), optimizerSteps(), firstState<T>(),
+                                secondState<T>());
+    return true;
+}
+
+template <typename T, typename Acc>
+void Checkpoint::capture(const BasicNetwork<T, Acc>& network, const TrainingCursor& cursor,
+                         Snapshot& snapshot)
+{
+    const auto& topology = network.topology();
+    snapshot.dtype = dtypeOf<T>();
+    snapshot.shells.resize(topology.size());
+    for (auto l = 0ul; l < topology.size(); ++l)
+    {
+        const auto activation = l > 0 ? network.activation(l) : Activation::Linear;
+        snapshot.shells[l] = {topology[l], static_cast<std::uint32_t>(activation), 0};
+    }
+
+    const auto& optimizer = network.optimizer();
+    const auto& options = optimizer.options();
+    auto& record = snapshot.optimizer;
+    record.type = static_cast<std::uint32_t>(options.type);
+    record.schedule = static_cast<std::uint32_t>(options.schedule.type);
+    record.steps = optimizer.steps();
+    record.learningRate = options.learningRate;
+    record.momentum = options.momentum;
+    record.decay = options.decay;
+    record.beta1 = options.beta1;
+    record.beta2 = options.beta2;
+    record.epsilon = options.epsilon;
+    record.warmupSteps = options.schedule.warmupSteps;
+    record.decaySteps = options.schedule.decaySteps;
+    record.decayRate = options.schedule.decayRate;
+    record.minRate = options.schedule.minRate;
+
+    snapshot.cursor = cursor;
+    copyBytes(network.parameters(), snapshot.parameters);
+    copyBytes(optimizer.firstState(), snapshot.firstState);
+    copyBytes(optimizer.secondState(), snapshot.secondState);
+}
+
+static void pad(std::ofstream& out, std::uint64_t offset)
+{
+    static constexpr char zeros[s_alignment] = {};
+    const auto position = static_cast<std::uint64_t>(out.tellp());
+    out.write(zeros, static_cast<std::streamsize>(offset - position));
+}
+
+static void writeSection(std::ofstream& out, std::uint64_t offset, const void* data,
+                         std::uint64_t bytes)
+{
+    pad(out, offset);
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+}
+
+bool Checkpoint::write(const Snapshot& snapshot, std::string_view path, std::string& error)
+{
+    assert(snapshot.shells.size() >= 2);
+
+    const auto parameterBytes = snapshot.parameters.size();
+    assert(snapshot.firstState.empty() || snapshot.firstState.size() == parameterBytes);
+    assert(snapshot.secondState.empty() || snapshot.secondState.size() == parameterBytes);
+
+    Header header{};
+    std::memcpy(header.magic, s_magic, sizeof(s_magic));
+    header.version = s_version;
+    header.dtype = snapshot.dtype;
+    header.shells = snapshot.shells.size();
+    header.parameters = parameterBytes / dtypeSize(snapshot.dtype);
+    header.shellsOffset = alignUp(sizeof(Header));
+    header.optimizerOffset = alignUp(header.shellsOffset + header.shells * sizeof(ShellRecord));
+    header.cursorOffset = alignUp(header.optimizerOffset + sizeof(OptimizerRecord));
+    header.parametersOffset = alignUp(header.cursorOffset + sizeof(TrainingCursor));
+
+    auto end = header.parametersOffset + parameterBytes;
+    if (!snapshot.firstState.empty())
+    {
+        header.firstStateOffset = alignUp(end);
+        end = header.firstStateOffset + parameterBytes;
+    }
+
+    if (!snapshot.secondState.empty())
+        header.secondStateOffset = alignUp(end);
+
+    // Written next to the target and renamed over it once complete
+    const auto target = std::string(path);
+    const auto temporary = target + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            error = "could not create " + temporary;
+            return false;
+        }
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeSection(out, header.shellsOffset, snapshot.shells.data(),
+                     header.shells * sizeof(ShellRecord));
+        writeSection(out, header.optimizerOffset, &snapshot.optimizer, sizeof(OptimizerRecord));
+        writeSection(out, header.cursorOffset, &snapshot.cursor, sizeof(TrainingCursor));
+        writeSection(out, header.parametersOffset, snapshot.parameters.data(), parameterBytes);
+        if (header.firstStateOffset)
+            writeSection(out, header.firstStateOffset, snapshot.firstState.data(),
+                         parameterBytes);
+        if (header.secondStateOffset)
+            writeSection(out, header.secondStateOffset, snapshot.secondState.data(),
+                         parameterBytes);
+
+        out.flush();
+        if (!out)
+        {
+            error = "could not write " + temporary;
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(temporary.c_str(), target.c_str()) != 0)
+    {
+        error = "could not replace " + target;
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+template <typename T, typename Acc>
+bool Checkpoint::save(const BasicNetwork<T, Acc>& network, const TrainingCursor& cursor,
+                      std::string_view path, std::string& error)
+{
+    Snapshot snapshot;
+    capture(network, cursor, snapshot);
+    return write(snapshot, path, error);
+}
+
+// -----------------------------------------------------------------------------
+CheckpointWriter::CheckpointWriter(std::string path)
+    : m_path(std::move(path))
+    , m_thread(&CheckpointWriter::run, this)
+{
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+
+    // A checkpoint still pending is written before the thread exits
+    m_changed.notify_all();
+    m_thread.join();
+}
+
+template <typename T, typename Acc>
+bool CheckpointWriter::trySave(const BasicNetwork<T, Acc>& network, const TrainingCursor& cursor)
+{
+    std::unique_lock lock(m_mutex, std::try_to_lock);
+    if (!lock.owns_lock() || m_busy)
+    {
+        m_skipped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Checkpoint::capture(network, cursor, m_snapshot);
+    m_busy = true;
+    lock.unlock();
+    m_changed.notify_all();
+
+    return true;
+}
+
+template <typename T, typename Acc>
+void CheckpointWriter::save(const BasicNetwork<T, Acc>& network, const TrainingCursor& cursor)
+{
+    std::unique_lock lock(m_mutex);
+    m_changed.wait(lock, [this] { return !m_busy; });
+
+    Checkpoint::capture(network, cursor, m_snapshot);
+    m_busy = true;
+    lock.unlock();
+    m_changed.notify_all();
+}
+
+void CheckpointWriter::wait()
+{
+    std::unique_lock lock(m_mutex);
+    m_changed.wait(lock, [this] { return !m_busy; });
+}
+
+void CheckpointWriter::run()
+{
+    ENGINE_PROFILE_THREAD("checkpoint writer");
+    while (true)
+    {
+        std::unique_lock lock(m_mutex);
+        m_changed.wait(lock, [this] { return m_busy || m_stop; });
+        if (!m_busy)
+            return;
+
+        // The snapshot is not touched by anyone else until m_busy is cleared
+        lock.unlock();
+        ENGINE_PROFILE_SCOPE("write checkpoint");
+        std::string error;
+        if (Checkpoint::write(m_snapshot, m_path, error))
+        {
+            m_written.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            m_failed.fetch_add(1, std::memory_order_relaxed);
+            ENGINE_ERROR("Checkpoint failed: {}", error);
+        }
+
+        lock.lock();
+        m_busy = false;
+        lock.unlock();
+        m_changed.notify_all();
+    }
+}
+
+template std::span<double> Checkpoint::parameters();
+template std::span<float> Checkpoint::parameters();
+template std::span<const double> Checkpoint::parameters() const;
+template std::span<const float> Checkpoint::parameters() const;
+template std::span<const double> Checkpoint::firstState() const;
+template std::span<const float> Checkpoint::firstState() const;
+template std::span<const double> Checkpoint::secondState() const;
+template std::span<const float> Checkpoint::secondState() const;
+
+#define ENGINE_CHECKPOINT_INSTANTIATE(T, Acc)                                                     \
+    template bool Checkpoint::restore(BasicNetwork<T, Acc>&) const;                               \
+    template void Checkpoint::capture(const BasicNetwork<T, Acc>&, const TrainingCursor&,         \
+                                      Snapshot&);                                                 \
+    template bool Checkpoint::save(const BasicNetwork<T, Acc>&, const TrainingCursor&,            \
+                                   std::string_view, std::string&);                               \
+    template bool CheckpointWriter::trySave(const BasicNetwork<T, Acc>&, const TrainingCursor&);  \
+    template void CheckpointWriter::save(const BasicNetwork<T, Acc>&, const TrainingCursor&);
+
+ENGINE_CHECKPOINT_INSTANTIATE(double, double)
+ENGINE_CHECKPOINT_INSTANTIATE(float, float)
+ENGINE_CHECKPOINT_INSTANTIATE(float, double)
+
+#undef ENGINE_CHECKPOINT_INSTANTIATE
+
+} // namespace Engine
@@ -0,0 +1,217 @@
+/* Network checkpoints: topology, activations, parameters, optimizer state and the training
+ * cursor in one versioned binary file, read back through a private memory map.
+ *
+ * Layout (little endian):
+ *   Header         128 bytes, see Checkpoint::Header
+ *   Shells         one ShellRecord per shell, the input shell included
+ *   Optimizer      OptimizerRecord
+ *   Cursor         TrainingCursor
+ *   Parameters     the network's flat parameter buffer
+ *   First state    the optimizer's first moment buffer, same length and layout
+ *   Second state   the optimizer's second moment buffer, Adam only
+ *
+ * Every section starts on a 64 byte boundary, so the parameters can be used in place: a network
+ * can shareParameters() with parameters() and run forward() on the mapping without copying or
+ * parsing anything. The mapping is copy-on-write, pages stay shared with the page cache, and
+ * with every other process mapping the same file, until they are written to.
+ *
+ * Files are written to a temporary name and renamed over the target, so a reader never sees a
+ * partly written checkpoint and a process still mapping the previous one keeps its copy. */
+#pragma once
+
+// clang-format off
+#include "BinaryDataset.h"
+#include "Network.h"
+#include "Optimizer.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+// Where training stands, so it can pick up where a checkpoint left off
+struct TrainingCursor
+{
+    std::uint64_t epoch = 0;  // next epoch to train, one cut short by the checkpoint included
+    std::uint64_t passes = 0; // samples trained on so far
+    double recentAvgError = 0.0;
+    std::uint8_t reserved[8] = {};
+};
+
+static_assert(sizeof(TrainingCursor) == 32);
+
+class Checkpoint
+{
+public:
+    using DType = BinaryDataset::DType;
+
+    struct Header
+    {
+        char magic[8];
+        std::uint32_t version;
+        DType dtype;
+        std::uint64_t shells;
+        std::uint64_t parameters;
+        std::uint64_t shellsOffset;
+        std::uint64_t optimizerOffset;
+        std::uint64_t cursorOffset;
+        std::uint64_t parametersOffset;
+        std::uint64_t firstStateOffset;  // 0 without optimizer state
+        std::uint64_t secondStateOffset; // 0 unless the optimizer keeps a second moment
+        std::uint8_t reserved[48];
+    };
+
+    struct ShellRecord
+    {
+        std::uint64_t size;
+        std::uint32_t activation; // Activation, unused for the input shell
+        std::uint32_t reserved;
+    };
+
+    struct OptimizerRecord
+    {
+        std::uint32_t type; // OptimizerType
+        std::uint32_t schedule; // LearningRateSchedule::Type
+        std::uint64_t steps;
+        double learningRate;
+        double momentum;
+        double decay;
+        double beta1;
+        double beta2;
+        double epsilon;
+        std::uint64_t warmupSteps;
+        std::uint64_t decaySteps;
+        double decayRate;
+        double minRate;
+    };
+
+    static_assert(sizeof(Header) == 128);
+    static_assert(sizeof(ShellRecord) == 16);
+    static_assert(sizeof(OptimizerRecord) == 96);
+    static constexpr char s_magic[8] = {'C', 'N', 'N', 'C', 'K', 'P', 'T', '\0'};
+    static constexpr std::uint32_t s_version = 1;
+
+    // Everything a checkpoint holds, copied out of a network. Capturing is a few flat copies,
+    // writing the file can then happen on any thread while the network trains on.
+    struct Snapshot
+    {
+        DType dtype = DType::Float64;
+        std::vector<ShellRecord> shells;
+        OptimizerRecord optimizer{};
+        TrainingCursor cursor;
+        std::vector<unsigned char> parameters;
+        std::vector<unsigned char> firstState;
+        std::vector<unsigned char> secondState;
+    };
+
+public:
+    explicit Checkpoint(std::string_view path);
+    ~Checkpoint();
+
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+
+public:
+    inline bool isOpen() const { return m_header != nullptr; }
+    inline DType dtype() const { return m_header->dtype; }
+    inline const std::vector<unsigned long>& topology() const { return m_topology; }
+    Activation activation(unsigned long shell) const;
+    OptimizerOptions optimizerOptions() const;
+    inline unsigned long optimizerSteps() const { return optimizer().steps; }
+    inline const TrainingCursor& cursor() const
+    {
+        return *reinterpret_cast<const TrainingCursor*>(m_data + m_header->cursorOffset);
+    }
+
+    // Views straight into the mapping. T has to match dtype().
+    template <typename T>
+    std::span<T> parameters();
+    template <typename T>
+    std::span<const T> parameters() const;
+    template <typename T>
+    std::span<const T> firstState() const;
+    template <typename T>
+    std::span<const T> secondState() const;
+
+    // Copies parameters, activations and optimizer state into a network with the same topology
+    // and scalar type
+    template <typename T, typename Acc>
+    bool restore(BasicNetwork<T, Acc>& network) const;
+
+    template <typename T, typename Acc>
+    static void capture(const BasicNetwork<T, Acc>& network, const TrainingCursor& cursor,
+                        Snapshot& snapshot);
+    static bool write(const Snapshot& snapshot, std::string_view path, std::string& error);
+
+    template <typename T, typename Acc>
+    static bool save(const BasicNetwork<T, Acc>& network, const TrainingCursor& cursor,
+                     std::string_view path, std::string& error);
+
+private:
+    inline const OptimizerRecord& optimizer() const
+    {
+        return *reinterpret_cast<const OptimizerRecord*>(m_data + m_header->optimizerOffset);
+    }
+
+    template <typename T>
+    std::span<const T> state(std::uint64_t offset) const;
+
+private:
+    const Header* m_header = nullptr;
+    unsigned char* m_data = nullptr;
+    unsigned long m_size = 0;
+    std::vector<unsigned long> m_topology;
+};
+
+// Writes checkpoints on a thread of its own. The network is captured on the calling thread,
+// which costs a copy of its flat buffers, the file is written in the background. trySave()
+// never waits: while the previous checkpoint is still being written the new one is skipped.
+class CheckpointWriter
+{
+public:
+    explicit CheckpointWriter(std::string path);
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+public:
+    template <typename T, typename Acc>
+    bool trySave(const BasicNetwork<T, Acc>& network, const TrainingCursor& cursor);
+
+    // Waits for the previous checkpoint to be written first
+    template <typename T, typename Acc>
+    void save(const BasicNetwork<T, Acc>& network, const TrainingCursor& cursor);
+
+    // Blocks until nothing is left to write
+    void wait();
+
+    inline const std::string& path() const { return m_path; }
+    inline unsigned long written() const { return m_written.load(std::memory_order_relaxed); }
+    inline unsigned long skipped() const { return m_skipped.load(std::memory_order_relaxed); }
+    inline unsigned long failed() const { return m_failed.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+private:
+    std::string m_path;
+    Checkpoint::Snapshot m_snapshot; // owned by the writer thread while m_busy
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    bool m_busy = false;
+    bool m_stop = false;
+    std::atomic<unsigned long> m_written = 0;
+    std::atomic<unsigned long> m_skipped = 0;
+    std::atomic<unsigned long> m_failed = 0;
+    std::thread m_thread; // last, it starts once everything above is constructed
+};
+
+} // namespace Engine
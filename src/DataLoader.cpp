@@ -0,0 +1,288 @@
+// clang-format off
+#include "DataLoader.h"
+#include "BinaryDataset.h"
+#include "Profiler.h"
+#include "TrainingData.h"
+#include <algorithm>
+#include <cassert>
+// clang-format on
+
+namespace Engine {
+
+DataLoader::DataLoader(TrainingData& data, unsigned long inputWidth, unsigned long targetWidth,
+                       Options options)
+    : DataLoader([&data](std::span<double> inputs,
+                         std::span<double> targets) { return data.readSample(inputs, targets); },
+                 [&data] { return data.error(); }, inputWidth, targetWidth, std::move(options))
+{
+}
+
+DataLoader::DataLoader(const BinaryDataset& data, Options options)
+    : DataLoader(
+          [&data, next = 0ul](std::span<double> inputs, std::span<double> targets) mutable {
+              if (next == data.samples())
+                  return false;
+
+              // Float32 datasets are widened here, off the training thread
+              auto copy = [&](auto in, auto target) {
+                  std::copy(in.begin(), in.end(), inputs.begin());
+                  std::copy(target.begin(), target.end(), targets.begin());
+              };
+
+              if (data.dtype() == BinaryDataset::DType::Float32)
+                  copy(data.inputs<float>(next), data.targets<float>(next));
+              else
+                  copy(data.inputs<double>(next), data.targets<double>(next));
+              ++next;
+              return true;
+          },
+          nullptr, data.inputWidth(), data.targetWidth(), std::move(options))
+{
+}
+
+DataLoader::DataLoader(const IndexedDataset::Subset& subset, unsigned long epoch, Options options)
+    : DataLoader(
+          [&data = subset.data(), order = std::vector<unsigned long>(), next = 0ul, &subset,
+           epoch](std::span<double> inputs, std::span<double> targets) mutable {
+              // The permutation is drawn on the loader thread as well
+              if (next == 0)
+                  subset.order(epoch, order);
+              if (next == order.size())
+                  return false;
+
+              data.gather({&order[next++], 1}, inputs, targets);
+              return true;
+          },
+          nullptr, subset.data().inputWidth(), subset.data().targetWidth(), std::move(options))
+{
+}
+
+DataLoader::DataLoader(Reader reader, std::function<std::string()> error,
+                       unsigned long inputWidth, unsigned long targetWidth, Options options)
+    : m_reader(std::move(reader))
+    , m_readerError(std::move(error))
+    , m_inputWidth(inputWidth)
+    , m_targetWidth(targetWidth)
+    , m_options(std::move(options))
+    , m_slots(std::max(m_options.depth, 1ul))
+    , m_rng(m_options.seed)
+{
+    assert(m_options.batchSize > 0);
+    assert(m_options.inputOffset.empty() || m_options.inputOffset.size() == inputWidth);
+    assert(m_options.inputScale.empty() || m_options.inputScale.size() == inputWidth);
+
+    for (auto& slot : m_slots)
+    {
+        slot.inputs.resize(m_options.batchSize * m_inputWidth);
+        slot.targets.resize(m_options.batchSize * m_targetWidth);
+        m_free.push_back(&slot);
+    }
+
+    m_window.resize(m_options.shuffleWindow * (m_inputWidth + m_targetWidth));
+    m_thread = std::thread(&DataLoader::run, this);
+}
+
+DataLoader::~DataLoader()
+{
+    stop();
+    m_thread.join();
+}
+
+const DataLoader::Batch* DataLoader::acquire()
+{
+    std::unique_lock lock(m_mutex);
+    if (m_ready.empty() && !m_finished && !m_stopping)
+    {
+        ++m_stats.consumerWaits;
+        m_batchReady.wait(lock, [this] { return !m_ready.empty() || m_finished || m_stopping; });
+    }
+
+    if (m_stopping || m_ready.empty())
+        return nullptr;
+
+    const auto* batch = m_ready.front();
+    m_ready.pop_front();
+    return batch;
+}
+
+const DataLoader::Batch* DataLoader::tryAcquire()
+{
+    std::lock_guard lock(m_mutex);
+    if (m_stopping || m_ready.empty())
+        return nullptr;
+
+    const auto* batch = m_ready.front();
+    m_ready.pop_front();
+    return batch;
+}
+
+void DataLoader::release(const Batch* batch)
+{
+    assert(batch >= m_slots.data() && batch < m_slots.data() + m_slots.size());
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_free.push_back(&m_slots[static_cast<unsigned long>(batch - m_slots.data())]);
+    }
+
+    m_slotFreed.notify_one();
+}
+
+void DataLoader::stop()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_slotFreed.notify_all();
+    m_batchReady.notify_all();
+}
+
+DataLoader::Stats DataLoader::stats() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_stats;
+}
+
+std::string DataLoader::error() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_error;
+}
+
+void DataLoader::run()
+{
+    ENGINE_PROFILE_THREAD("data loader");
+    while (true)
+    {
+        Batch* batch = nullptr;
+        {
+            std::unique_lock lock(m_mutex);
+            if (m_free.empty() && !m_stopping)
+            {
+                ++m_stats.producerWaits;
+                m_slotFreed.wait(lock, [this] { return !m_free.empty() || m_stopping; });
+            }
+
+            if (m_stopping)
+                break;
+
+            batch = m_free.back();
+            m_free.pop_back();
+        }
+
+        // Parsing happens outside the lock, the consumer only ever waits for finished batches
+        ENGINE_PROFILE_SCOPE("fill batch");
+        batch->inputs.resize(m_options.batchSize * m_inputWidth);
+        batch->targets.resize(m_options.batchSize * m_targetWidth);
+        batch->samples = 0;
+
+        while (batch->samples < m_options.batchSize)
+        {
+            std::span<double> inputs(batch->inputs.data() + batch->samples * m_inputWidth,
+                                     m_inputWidth);
+            std::span<double> targets(batch->targets.data() + batch->samples * m_targetWidth,
+                                      m_targetWidth);
+            if (!nextSample(inputs, targets))
+                break;
+
+            ++batch->samples;
+        }
+
+        const auto exhausted = batch->samples < m_options.batchSize;
+        batch->inputs.resize(batch->samples * m_inputWidth);
+        batch->targets.resize(batch->samples * m_targetWidth);
+
+        {
+            std::lock_guard lock(m_mutex);
+            if (batch->samples > 0)
+            {
+                m_ready.push_back(batch);
+                ++m_stats.batches;
+                m_stats.samples += batch->samples;
+            }
+            else
+            {
+                m_free.push_back(batch);
+            }
+
+            if (exhausted)
+            {
+                m_finished = true;
+                if (m_readerError)
+                    m_error = m_readerError();
+            }
+        }
+
+        m_batchReady.notify_all();
+        if (exhausted)
+            return;
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_finished = true;
+    }
+
+    m_batchReady.notify_all();
+}
+
+bool DataLoader::nextSample(std::span<double> inputs, std::span<double> targets)
+{
+    if (m_options.shuffleWindow == 0)
+    {
+        if (!m_reader(inputs, targets))
+            return false;
+
+        normalize(inputs);
+        return true;
+    }
+
+    // A sliding shuffle window: emit a random held-back sample and refill its place from the
+    // source, so the order is randomized without reading the whole dataset first.
+    const auto width = m_inputWidth + m_targetWidth;
+    auto record = [&](unsigned long i) { return m_window.data() + i * width; };
+
+    while (!m_sourceDone && m_windowFill < m_options.shuffleWindow)
+    {
+        auto* slot = record(m_windowFill);
+        if (!m_reader({slot, m_inputWidth}, {slot + m_inputWidth, m_targetWidth}))
+            m_sourceDone = true;
+        else
+            ++m_windowFill;
+    }
+
+    if (m_windowFill == 0)
+        return false;
+
+    std::uniform_int_distribution<unsigned long> pick(0, m_windowFill - 1);
+    auto* chosen = record(pick(m_rng));
+
+    std::copy(chosen, chosen + m_inputWidth, inputs.begin());
+    std::copy(chosen + m_inputWidth, chosen + width, targets.begin());
+    normalize(inputs);
+
+    if (m_sourceDone ||
+        !m_reader({chosen, m_inputWidth}, {chosen + m_inputWidth, m_targetWidth}))
+    {
+        m_sourceDone = true;
+        --m_windowFill;
+        std::copy(record(m_windowFill), record(m_windowFill) + width, chosen);
+    }
+
+    return true;
+}
+
+void DataLoader::normalize(std::span<double> inputs) const
+{
+    if (!m_options.inputOffset.empty())
+        for (auto i = 0ul; i < inputs.size(); ++i)
+            inputs[i] -= m_options.inputOffset[i];
+
+    if (!m_options.inputScale.empty())
+        for (auto i = 0ul; i < inputs.size(); ++i)
+            inputs[i] *= m_options.inputScale[i];
+}
+
+} // namespace Engine
@@ -0,0 +1,123 @@
+/* Background data loading. A loader thread reads samples from a TrainingData stream, a
+ * BinaryDataset or one epoch of an IndexedDataset subset, optionally normalizes and shuffles
+ * them, and packs them into batches while the trainer works on earlier ones.
+ *
+ * Batches live in a fixed pool of slots. The loader blocks when every slot is either ready or
+ * in use (backpressure), the consumer blocks in acquire() only when it has caught up with the
+ * loader. Slots are handed back with release() in any order, so several consumers can hold
+ * batches at the same time. */
+#pragma once
+
+// clang-format off
+#include "IndexedDataset.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+class BinaryDataset;
+class TrainingData;
+
+class DataLoader
+{
+public:
+    struct Options
+    {
+        unsigned long batchSize = 32;
+        unsigned long depth = 4;         // batches prepared ahead of the consumer
+        unsigned long shuffleWindow = 0; // samples held back for shuffling, 0 keeps file order
+        unsigned long seed = 0;
+
+        // Per input affine normalization, x' = (x - offset) * scale. Empty leaves inputs as is.
+        std::vector<double> inputOffset;
+        std::vector<double> inputScale;
+    };
+
+    struct Batch
+    {
+        std::vector<double> inputs;  // samples x input width
+        std::vector<double> targets; // samples x target width
+        unsigned long samples = 0;
+    };
+
+    struct Stats
+    {
+        unsigned long batches = 0;
+        unsigned long samples = 0;
+        unsigned long consumerWaits = 0; // acquire() found nothing ready, I/O was not hidden
+        unsigned long producerWaits = 0; // the loader was ahead and had to wait for a slot
+    };
+
+public:
+    // The source must not be read by anyone else while the loader runs
+    DataLoader(TrainingData& data, unsigned long inputWidth, unsigned long targetWidth,
+               Options options);
+    DataLoader(const BinaryDataset& data, Options options);
+    DataLoader(const IndexedDataset::Subset& subset, unsigned long epoch, Options options);
+    ~DataLoader();
+
+    DataLoader(const DataLoader&) = delete;
+    DataLoader& operator=(const DataLoader&) = delete;
+
+public:
+    // Blocks until a batch is ready, returns nullptr once the data is exhausted or stop() was
+    // called. tryAcquire() returns nullptr instead of blocking.
+    const Batch* acquire();
+    const Batch* tryAcquire();
+    void release(const Batch* batch);
+
+    // Stops the loader early, pending and future acquire() calls return nullptr
+    void stop();
+
+    inline unsigned long inputWidth() const { return m_inputWidth; }
+    inline unsigned long targetWidth() const { return m_targetWidth; }
+    inline unsigned long batchSize() const { return m_options.batchSize; }
+    inline unsigned long depth() const { return m_options.depth; }
+    Stats stats() const;
+    std::string error() const;
+
+private:
+    using Reader = std::function<bool(std::span<double> inputs, std::span<double> targets)>;
+
+    DataLoader(Reader reader, std::function<std::string()> error, unsigned long inputWidth,
+               unsigned long targetWidth, Options options);
+    void run();
+    bool nextSample(std::span<double> inputs, std::span<double> targets);
+    void normalize(std::span<double> inputs) const;
+
+private:
+    Reader m_reader;
+    std::function<std::string()> m_readerError;
+    unsigned long m_inputWidth;
+    unsigned long m_targetWidth;
+    Options m_options;
+
+    std::vector<Batch> m_slots;
+    std::vector<Batch*> m_free;
+    std::deque<Batch*> m_ready;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_slotFreed;
+    std::condition_variable m_batchReady;
+    bool m_finished = false;
+    bool m_stopping = false;
+    Stats m_stats;
+    std::string m_error;
+
+    // Shuffle window, only touched by the loader thread
+    std::vector<double> m_window;
+    unsigned long m_windowFill = 0;
+    bool m_sourceDone = false;
+    std::mt19937_64 m_rng;
+
+    std::thread m_thread;
+};
+
+} // namespace Engine
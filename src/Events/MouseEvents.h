@@ -20,7 +20,7 @@ public:
     EVENT_CLASS_TYPE(mouseMoved);
     EVENT_CLASS_CATEGORY(EventCategoryMouse | EventCategoryInput);
 
-    void log() override { ENGINE_INFO("[INPUT] Mouse moved: {},{}", m_x, m_y); }
+    void log() override { ENGINE_DEBUG("[INPUT] Mouse moved: {},{}", m_x, m_y); }
 
 private:
     double m_x;
@@ -0,0 +1,87 @@
+// clang-format off
+#include "FrameStats.h"
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <numeric>
+// clang-format on
+
+namespace Engine {
+
+FrameStats::FrameStats(unsigned long capacity)
+    : m_capacity(capacity)
+{
+    assert(capacity > 0);
+
+    m_timings.reserve(capacity);
+    m_sorted.reserve(capacity);
+}
+
+void FrameStats::add(const FrameTiming& timing)
+{
+    if (m_timings.size() < m_capacity)
+    {
+        m_timings.push_back(timing);
+        return;
+    }
+
+    m_timings[m_next] = timing;
+    m_next = (m_next + 1) % m_capacity;
+}
+
+void FrameStats::clear()
+{
+    m_timings.clear();
+    m_next = 0;
+}
+
+FrameStats::Summary FrameStats::summary() const
+{
+    Summary summary;
+    summary.frames = m_timings.size();
+    if (m_timings.empty())
+        return summary;
+
+    auto total = 0.0;
+    m_sorted.clear();
+    for (const auto& timing : m_timings)
+    {
+        total += timing.frame;
+        summary.average.frame += timing.frame;
+        summary.average.update += timing.update;
+        summary.average.render += timing.render;
+        summary.average.swap += timing.swap;
+        summary.average.events += timing.events;
+        m_sorted.push_back(timing.frame);
+    }
+
+    const auto frames = static_cast<double>(summary.frames);
+    summary.average.frame /= frames;
+    summary.average.update /= frames;
+    summary.average.render /= frames;
+    summary.average.swap /= frames;
+    summary.average.events /= frames;
+    summary.averageFps = total > 0.0 ? frames / total : 0.0;
+
+    // Only the slowest 1% are needed in order, at least one frame for each statistic
+    auto slowest = [&](double fraction) {
+        return std::max(static_cast<unsigned long>(frames * fraction), 1ul);
+    };
+    const auto slowest1 = slowest(0.01);
+    const auto slowest01 = slowest(0.001);
+    std::partial_sort(m_sorted.begin(), m_sorted.begin() + static_cast<long>(slowest1),
+                      m_sorted.end(), std::greater<>());
+
+    auto lowFps = [&](unsigned long count) {
+        const auto time = std::accumulate(m_sorted.begin(),
+                                          m_sorted.begin() + static_cast<long>(count), 0.0);
+        return time > 0.0 ? static_cast<double>(count) / time : 0.0;
+    };
+    summary.low1Fps = lowFps(slowest1);
+    summary.low01Fps = lowFps(slowest01);
+    summary.p99Milliseconds = m_sorted[slowest1 - 1] * 1000.0;
+
+    return summary;
+}
+
+} // namespace Engine
@@ -0,0 +1,60 @@
+/* Frame pacing statistics. The application adds one FrameTiming per frame, split into the phases
+ * of its loop, and a ring buffer keeps the most recent frames. summary() reduces the buffer to
+ * what shows stutter better than an average does: the 1% and 0.1% lows (the average frame rate
+ * of the slowest 1% and 0.1% of frames) and the 99th percentile frame time. */
+#pragma once
+
+// clang-format off
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+// Seconds. The phases need not add up to the frame, which also covers what runs between them.
+struct FrameTiming
+{
+    double frame = 0.0;
+    double update = 0.0; // ImGui's new frame and every layer's onUpdate()
+    double render = 0.0; // ImGui's draw data to GL
+    double swap = 0.0;   // buffer swap, waiting for vsync included
+    double events = 0.0; // event polling and the event callbacks it runs
+};
+
+class FrameStats
+{
+public:
+    explicit FrameStats(unsigned long capacity = 4096);
+
+public:
+    struct Summary
+    {
+        unsigned long frames = 0;
+        double averageFps = 0.0;
+        double low1Fps = 0.0;
+        double low01Fps = 0.0;
+        double p99Milliseconds = 0.0;
+        FrameTiming average; // of each phase
+    };
+
+    void add(const FrameTiming& timing);
+    void clear();
+    Summary summary() const;
+
+    inline unsigned long size() const { return m_timings.size(); }
+    inline unsigned long capacity() const { return m_capacity; }
+    inline const FrameTiming& last() const { return at(size() - 1); }
+
+    // Oldest first
+    inline const FrameTiming& at(unsigned long frame) const
+    {
+        return m_timings[(m_next + frame) % m_timings.size()];
+    }
+
+private:
+    unsigned long m_capacity;
+    unsigned long m_next = 0; // oldest frame once the buffer is full
+    std::vector<FrameTiming> m_timings;
+    mutable std::vector<double> m_sorted;
+};
+
+} // namespace Engine
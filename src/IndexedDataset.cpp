@@ -0,0 +1,142 @@
+// clang-format off
+#include "IndexedDataset.h"
+#include "BinaryDataset.h"
+#include "Logging.h"
+#include "TrainingData.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+// clang-format on
+
+namespace Engine {
+
+IndexedDataset::Subset::Subset(const IndexedDataset& data, std::vector<unsigned long> indices,
+                               unsigned long seed)
+    : m_data(&data)
+    , m_indices(std::move(indices))
+    , m_seed(seed)
+{
+}
+
+void IndexedDataset::Subset::order(unsigned long epoch, std::vector<unsigned long>& out) const
+{
+    out.assign(m_indices.begin(), m_indices.end());
+
+    // seed_seq keeps 32 bits per value, so both halves of each are passed on
+    auto low = [](unsigned long value) { return static_cast<std::uint32_t>(value); };
+    auto high = [](unsigned long value) { return static_cast<std::uint32_t>(value >> 32); };
+    std::seed_seq seed{low(m_seed), high(m_seed), low(epoch), high(epoch)};
+    std::mt19937_64 rng(seed);
+    std::shuffle(out.begin(), out.end(), rng);
+}
+
+IndexedDataset::IndexedDataset(TrainingData& data, unsigned long inputWidth,
+                               unsigned long targetWidth)
+    : m_inputWidth(inputWidth)
+    , m_targetWidth(targetWidth)
+{
+    // Samples are parsed straight into the end of the storage, which grows geometrically
+    while (true)
+    {
+        m_inputStorage.resize((m_samples + 1) * m_inputWidth);
+        m_targetStorage.resize((m_samples + 1) * m_targetWidth);
+
+        std::span<double> inputs(m_inputStorage.data() + m_samples * m_inputWidth, m_inputWidth);
+        std::span<double> targets(m_targetStorage.data() + m_samples * m_targetWidth,
+                                  m_targetWidth);
+        if (!data.readSample(inputs, targets))
+            break;
+
+        ++m_samples;
+    }
+
+    m_inputStorage.resize(m_samples * m_inputWidth);
+    m_targetStorage.resize(m_samples * m_targetWidth);
+    m_inputs = m_inputStorage.data();
+    m_targets = m_targetStorage.data();
+    m_error = data.error();
+
+    if (hasError())
+    {
+        ENGINE_ERROR("Indexing stopped after {} samples: {}", m_samples, m_error);
+    }
+}
+
+IndexedDataset::IndexedDataset(const BinaryDataset& data)
+    : m_inputWidth(data.isOpen() ? data.inputWidth() : 0)
+    , m_targetWidth(data.isOpen() ? data.targetWidth() : 0)
+{
+    if (!data.isOpen())
+    {
+        m_error = "dataset is not open";
+        return;
+    }
+
+    m_samples = data.samples();
+    if (data.dtype() == BinaryDataset::DType::Float64)
+    {
+        m_inputs = data.inputs<double>(0, m_samples).data();
+        m_targets = data.targets<double>(0, m_samples).data();
+        return;
+    }
+
+    const auto inputs = data.inputs<float>(0, m_samples);
+    const auto targets = data.targets<float>(0, m_samples);
+    m_inputStorage.assign(inputs.begin(), inputs.end());
+    m_targetStorage.assign(targets.begin(), targets.end());
+    m_inputs = m_inputStorage.data();
+    m_targets = m_targetStorage.data();
+}
+
+void IndexedDataset::gather(std::span<const unsigned long> samples, std::span<double> inputs,
+                            std::span<double> targets) const
+{
+    assert(inputs.size() >= samples.size() * m_inputWidth);
+    assert(targets.size() >= samples.size() * m_targetWidth);
+
+    for (auto i = 0ul; i < samples.size(); ++i)
+    {
+        assert(samples[i] < m_samples);
+
+        const auto in = this->inputs(samples[i]);
+        const auto target = this->targets(samples[i]);
+        std::copy(in.begin(), in.end(), inputs.begin() + static_cast<long>(i * m_inputWidth));
+        std::copy(target.begin(), target.end(),
+                  targets.begin() + static_cast<long>(i * m_targetWidth));
+    }
+}
+
+IndexedDataset::Subset IndexedDataset::all(unsigned long seed) const
+{
+    std::vector<unsigned long> indices(m_samples);
+    std::iota(indices.begin(), indices.end(), 0ul);
+
+    return {*this, std::move(indices), seed};
+}
+
+std::pair<IndexedDataset::Subset, IndexedDataset::Subset>
+IndexedDataset::split(double validationFraction, unsigned long seed) const
+{
+    assert(validationFraction >= 0.0 && validationFraction <= 1.0);
+
+    // The split itself is the subset order of an epoch nobody trains on
+    std::vector<unsigned long> shuffled;
+    all(seed).order(~0ul, shuffled);
+
+    const auto held = static_cast<unsigned long>(
+        std::lround(validationFraction * static_cast<double>(m_samples)));
+    const auto cut = shuffled.begin() + static_cast<long>(m_samples - held);
+
+    // Each side is kept in file order, which keeps epoch gathers close to sequential
+    std::vector<unsigned long> train(shuffled.begin(), cut);
+    std::vector<unsigned long> validation(cut, shuffled.end());
+    std::sort(train.begin(), train.end());
+    std::sort(validation.begin(), validation.end());
+
+    return {Subset(*this, std::move(train), seed), Subset(*this, std::move(validation), seed)};
+}
+
+} // namespace Engine
@@ -0,0 +1,90 @@
+/* Random access over a whole dataset. Samples are addressed by index at a fixed stride: a
+ * float64 BinaryDataset is used in place, text and float32 data is parsed or widened into
+ * memory once. Subsets built on top of it give seeded train/validation splits and a shuffled
+ * order per epoch, so running more epochs never reads or parses the file again. */
+#pragma once
+
+// clang-format off
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+class BinaryDataset;
+class TrainingData;
+
+class IndexedDataset
+{
+public:
+    // A selection of sample indices. Subsets refer to their dataset, which must outlive them.
+    class Subset
+    {
+    public:
+        Subset(const IndexedDataset& data, std::vector<unsigned long> indices,
+               unsigned long seed);
+
+        inline const IndexedDataset& data() const { return *m_data; }
+        inline unsigned long size() const { return m_indices.size(); }
+        inline std::span<const unsigned long> indices() const { return m_indices; }
+
+        // The sample order of one epoch, a permutation of indices() seeded by the subset's seed
+        // and the epoch number, so every epoch is shuffled differently but reproducibly.
+        void order(unsigned long epoch, std::vector<unsigned long>& out) const;
+
+    private:
+        const IndexedDataset* m_data;
+        std::vector<unsigned long> m_indices;
+        unsigned long m_seed;
+    };
+
+public:
+    // Parses the remaining samples of a text stream. Stops at the first malformed sample, the
+    // samples before it are kept and error() says what went wrong.
+    IndexedDataset(TrainingData& data, unsigned long inputWidth, unsigned long targetWidth);
+    explicit IndexedDataset(const BinaryDataset& data);
+
+    // Subsets point back here, so the dataset stays where it was built
+    IndexedDataset(const IndexedDataset&) = delete;
+    IndexedDataset& operator=(const IndexedDataset&) = delete;
+
+public:
+    inline unsigned long samples() const { return m_samples; }
+    inline unsigned long inputWidth() const { return m_inputWidth; }
+    inline unsigned long targetWidth() const { return m_targetWidth; }
+    inline bool hasError() const { return !m_error.empty(); }
+    inline const std::string& error() const { return m_error; }
+
+    inline std::span<const double> inputs(unsigned long sample) const
+    {
+        return {m_inputs + sample * m_inputWidth, m_inputWidth};
+    }
+    inline std::span<const double> targets(unsigned long sample) const
+    {
+        return {m_targets + sample * m_targetWidth, m_targetWidth};
+    }
+
+    // Copies the given samples into row-major batch blocks
+    void gather(std::span<const unsigned long> samples, std::span<double> inputs,
+                std::span<double> targets) const;
+
+    // Every sample, or a seeded random split with the given fraction held out for validation
+    Subset all(unsigned long seed = 0) const;
+    std::pair<Subset, Subset> split(double validationFraction, unsigned long seed = 0) const;
+
+private:
+    unsigned long m_samples = 0;
+    unsigned long m_inputWidth;
+    unsigned long m_targetWidth;
+    const double* m_inputs = nullptr;
+    const double* m_targets = nullptr;
+    std::string m_error;
+
+    // Backing storage when the samples could not be used in place
+    std::vector<double> m_inputStorage;
+    std::vector<double> m_targetStorage;
+};
+
+} // namespace Engine
@@ -0,0 +1,140 @@
+// clang-format off
+#include "InferenceModel.h"
+#include "Kernels.h"
+#include <algorithm>
+#include <cassert>
+// clang-format on
+
+namespace Engine {
+
+template <typename T, typename Acc>
+BasicInferenceModel<T, Acc>::BasicInferenceModel(const BasicNetwork<T, Acc>& network)
+    : m_topology(network.topology())
+    , m_owned(network.parameters().begin(), network.parameters().end())
+    , m_parameters(m_owned)
+{
+    m_shells.resize(m_topology.size());
+    for (auto l = 1ul; l < m_topology.size(); ++l)
+        m_shells[l].activation = network.activation(l);
+
+    build();
+}
+
+template <typename T, typename Acc>
+BasicInferenceModel<T, Acc>::BasicInferenceModel(std::shared_ptr<const Checkpoint> checkpoint)
+    : m_topology(checkpoint->topology())
+    , m_checkpoint(std::move(checkpoint))
+    , m_parameters(m_checkpoint->parameters<T>())
+{
+    m_shells.resize(m_topology.size());
+    for (auto l = 1ul; l < m_topology.size(); ++l)
+        m_shells[l].activation = m_checkpoint->activation(l);
+
+    build();
+}
+
+template <typename T, typename Acc>
+void BasicInferenceModel<T, Acc>::build()
+{
+    // Same walk as Network::bind(): each shell's weight matrix followed by its bias vector
+    auto offset = 0ul;
+    m_shells.front().size = m_topology.front();
+    m_shells.front().fanIn = 0;
+    for (auto l = 1ul; l < m_topology.size(); ++l)
+    {
+        auto& shell = m_shells[l];
+        shell.size = m_topology[l];
+        shell.fanIn = m_topology[l - 1];
+        shell.weights = m_parameters.data() + offset;
+        shell.biases = shell.weights + shell.size * shell.fanIn;
+        offset += shell.size * (shell.fanIn + 1);
+
+        m_widest = std::max(m_widest, shell.size);
+    }
+
+    assert(offset == m_parameters.size());
+}
+
+template <typename T, typename Acc>
+void BasicInferenceModel<T, Acc>::reserve(Scratch& scratch, unsigned long batchSize) const
+{
+    const auto size = batchSize * m_widest;
+    if (scratch.m_front.size() < size)
+    {
+        scratch.m_front.resize(size);
+        scratch.m_back.resize(size);
+    }
+}
+
+template <typename T, typename Acc>
+typename BasicInferenceModel<T, Acc>::Scratch
+BasicInferenceModel<T, Acc>::makeScratch(unsigned long batchSize) const
+{
+    Scratch scratch;
+    reserve(scratch, batchSize);
+    return scratch;
+}
+
+template <typename T, typename Acc>
+std::span<const T> BasicInferenceModel<T, Acc>::infer(std::span<const T> input,
+                                                      Scratch& scratch) const
+{
+    assert(input.size() == inputWidth());
+
+    reserve(scratch, 1);
+
+    // Shells write into one buffer and read the previous shell's outputs from the other
+    const auto* prev = input.data();
+    for (auto l = 1ul; l < m_shells.size(); ++l)
+    {
+        const auto& shell = m_shells[l];
+        auto* out = (l % 2 ? scratch.m_front : scratch.m_back).data();
+
+        for (auto n = 0ul; n < shell.size; ++n)
+        {
+            const auto sum = Kernels::dotIn<Acc>(shell.weights + n * shell.fanIn, prev,
+                                                 shell.fanIn) +
+                             static_cast<Acc>(shell.biases[n]);
+            out[n] = static_cast<T>(sum);
+        }
+
+        activate(shell.activation, out, 1, shell.size);
+        prev = out;
+    }
+
+    return {prev, outputWidth()};
+}
+
+template <typename T, typename Acc>
+std::span<const T> BasicInferenceModel<T, Acc>::inferBatch(std::span<const T> inputs,
+                                                           unsigned long batchSize,
+                                                           Scratch& scratch) const
+{
+    assert(batchSize > 0);
+    assert(inputs.size() == batchSize * inputWidth());
+
+    reserve(scratch, batchSize);
+
+    // The input block is read in place, as Network::forwardBatch() does
+    const auto* prev = inputs.data();
+    for (auto l = 1ul; l < m_shells.size(); ++l)
+    {
+        const auto& shell = m_shells[l];
+        auto* out = (l % 2 ? scratch.m_front : scratch.m_back).data();
+
+        Kernels::gemmNT<T, Acc>(prev, shell.weights, out, batchSize, shell.size, shell.fanIn);
+        for (auto s = 0ul; s < batchSize; ++s)
+            Kernels::axpy(T(1), shell.biases, out + s * shell.size, shell.size);
+
+        activate(shell.activation, out, batchSize, shell.size);
+        prev = out;
+    }
+
+    return {prev, batchSize * outputWidth()};
+}
+
+template class BasicInferenceModel<double>;
+template class BasicInferenceModel<float>;
+template class BasicInferenceModel<float, double>;
+
+} // namespace Engine
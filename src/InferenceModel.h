@@ -0,0 +1,100 @@
+/* Read-only inference over a trained network. A model holds the weights, biases and
+ * activations and nothing else, every intermediate value lives in a Scratch the caller owns.
+ * All of its member functions are const and touch no shared mutable state, so any number of
+ * threads can evaluate one model at the same time, each with a Scratch of its own.
+ *
+ * A model either copies the parameters of a network or reads those of a checkpoint in place,
+ * in which case it keeps the checkpoint's mapping alive. */
+#pragma once
+
+// clang-format off
+#include "Activations.h"
+#include "Checkpoint.h"
+#include "Network.h"
+#include <memory>
+#include <span>
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+template <typename T, typename Acc = T>
+class BasicInferenceModel
+{
+    using Topology = std::vector<unsigned long>;
+
+public:
+    using Scalar = T;
+
+    // Intermediate outputs of one evaluation at a time. Grows on first use to what the largest
+    // batch needs and is reused from then on, so steady-state inference does not allocate.
+    class Scratch
+    {
+        friend class BasicInferenceModel;
+
+    public:
+        Scratch() = default;
+
+    private:
+        std::vector<T> m_front;
+        std::vector<T> m_back;
+    };
+
+public:
+    // Copies the network's parameters and activations, later training does not affect the model
+    explicit BasicInferenceModel(const BasicNetwork<T, Acc>& network);
+
+    // Reads the parameters straight from the mapping. The checkpoint must be open and hold
+    // parameters of type T.
+    explicit BasicInferenceModel(std::shared_ptr<const Checkpoint> checkpoint);
+
+public:
+    inline const Topology& topology() const { return m_topology; }
+    inline unsigned long inputWidth() const { return m_topology.front(); }
+    inline unsigned long outputWidth() const { return m_topology.back(); }
+    inline Activation activation(unsigned long shell) const { return m_shells[shell].activation; }
+    inline std::span<const T> parameters() const { return m_parameters; }
+
+    // A scratch already sized for batches of up to batchSize samples
+    Scratch makeScratch(unsigned long batchSize = 1) const;
+
+    // Evaluates one sample. The outputs live in the scratch until its next use.
+    std::span<const T> infer(std::span<const T> input, Scratch& scratch) const;
+
+    // Evaluates a row-major block of samples, the outputs hold one row per sample. Computes
+    // exactly what Network::forwardBatch() does, infer() what Network::forward() does.
+    std::span<const T> inferBatch(std::span<const T> inputs, unsigned long batchSize,
+                                  Scratch& scratch) const;
+
+private:
+    void build();
+    void reserve(Scratch& scratch, unsigned long batchSize) const;
+
+private:
+    // A view of one shell's parameters, laid out as in Network
+    struct Shell
+    {
+        unsigned long size;
+        unsigned long fanIn;
+        Activation activation;
+        const T* weights;
+        const T* biases;
+    };
+
+    Topology m_topology;
+    std::vector<Shell> m_shells; // the input shell has no parameters
+    std::vector<T> m_owned;
+    std::shared_ptr<const Checkpoint> m_checkpoint;
+    std::span<const T> m_parameters; // into m_owned or the checkpoint's mapping
+    unsigned long m_widest = 0;      // shell, the input shell excluded
+};
+
+using InferenceModel = BasicInferenceModel<double>;
+using InferenceModelF32 = BasicInferenceModel<float>;
+using InferenceModelMixed = BasicInferenceModel<float, double>;
+
+extern template class BasicInferenceModel<double>;
+extern template class BasicInferenceModel<float>;
+extern template class BasicInferenceModel<float, double>;
+
+} // namespace Engine
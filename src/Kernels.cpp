@@ -0,0 +1,210 @@
+// clang-format off
+#include "Kernels.h"
+#include "Logging.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <type_traits>
+#include <vector>
+// clang-format on
+
+namespace Engine::Kernels {
+
+// Tile sizes in elements. A 64 x 256 tile of doubles is 128 KiB, which keeps the reused operand
+// resident in L2 while the other one streams through.
+static constexpr unsigned long s_rowBlock = 64;
+static constexpr unsigned long s_depthBlock = 256;
+
+static std::atomic<const KernelTable*> s_active = nullptr;
+
+bool isSupported(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Scalar:
+        return true;
+#ifdef ENGINE_X86_KERNELS
+    case Isa::SSE2:
+        return __builtin_cpu_supports("sse2");
+    case Isa::AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case Isa::AVX512:
+        return __builtin_cpu_supports("avx512f");
+#else
+    default:
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+Isa detectIsa()
+{
+    for (auto isa : {Isa::AVX512, Isa::AVX2, Isa::SSE2})
+        if (isSupported(isa))
+            return isa;
+
+    return Isa::Scalar;
+}
+
+const KernelTable& table(Isa isa)
+{
+    assert(isSupported(isa));
+
+    switch (isa)
+    {
+#ifdef ENGINE_X86_KERNELS
+    case Isa::SSE2:
+        return sse2Kernels();
+    case Isa::AVX2:
+        return avx2Kernels();
+    case Isa::AVX512:
+        return avx512Kernels();
+#endif
+    default:
+        return scalarKernels();
+    }
+}
+
+const KernelTable& active()
+{
+    if (const auto* kernels = s_active.load(std::memory_order_acquire))
+        return *kernels;
+
+    static const auto* detected = [] {
+        const auto* kernels = &table(detectIsa());
+        ENGINE_INFO("Using {} kernels", kernels->name);
+        return kernels;
+    }();
+
+    const KernelTable* expected = nullptr;
+    s_active.compare_exchange_strong(expected, detected, std::memory_order_acq_rel);
+    return *s_active.load(std::memory_order_acquire);
+}
+
+void select(Isa isa) { s_active.store(&table(isa), std::memory_order_release); }
+
+template <typename T, typename Acc>
+static auto dotKernel(const KernelTable& kernels)
+{
+    if constexpr (std::is_same_v<T, double>)
+        return kernels.dot;
+    else if constexpr (std::is_same_v<Acc, double>)
+        return kernels.dotF32Mixed;
+    else
+        return kernels.dotF32;
+}
+
+template <typename T>
+static auto axpyKernel(const KernelTable& kernels)
+{
+    if constexpr (std::is_same_v<T, double>)
+        return kernels.axpy;
+    else
+        return kernels.axpyF32;
+}
+
+template <typename T, typename Acc>
+void gemmNT(const T* a, const T* b, T* c, unsigned long m, unsigned long n, unsigned long k)
+{
+    const auto dot = dotKernel<T, Acc>(active());
+
+    // The partial sums of the depth blocks are added up in Acc and narrowed to T once at the
+    // end. With a wider Acc they need a scratch copy of C, kept per thread.
+    Acc* acc = nullptr;
+    if constexpr (std::is_same_v<Acc, T>)
+    {
+        acc = c;
+    }
+    else
+    {
+        thread_local std::vector<Acc> scratch;
+        if (scratch.size() < m * n)
+            scratch.resize(m * n);
+        acc = scratch.data();
+    }
+    std::fill(acc, acc + m * n, Acc(0));
+
+    for (auto k0 = 0ul; k0 < k; k0 += s_depthBlock)
+    {
+        const auto kb = std::min(s_depthBlock, k - k0);
+        for (auto j0 = 0ul; j0 < n; j0 += s_rowBlock)
+        {
+            const auto jEnd = std::min(j0 + s_rowBlock, n);
+            for (auto i = 0ul; i < m; ++i)
+            {
+                const auto* rowA = a + i * k + k0;
+                auto* rowAcc = acc + i * n;
+                for (auto j = j0; j < jEnd; ++j)
+                    rowAcc[j] += dot(rowA, b + j * k + k0, kb);
+            }
+        }
+    }
+
+    if constexpr (!std::is_same_v<Acc, T>)
+        std::transform(acc, acc + m * n, c, [](Acc value) { return static_cast<T>(value); });
+}
+
+template <typename T>
+void gemmNN(const T* a, const T* b, T* c, unsigned long m, unsigned long n, unsigned long k)
+{
+    const auto axpy = axpyKernel<T>(active());
+    std::fill(c, c + m * n, T(0));
+
+    for (auto p0 = 0ul; p0 < k; p0 += s_rowBlock)
+    {
+        const auto pEnd = std::min(p0 + s_rowBlock, k);
+        for (auto j0 = 0ul; j0 < n; j0 += s_depthBlock)
+        {
+            const auto nb = std::min(s_depthBlock, n - j0);
+            for (auto i = 0ul; i < m; ++i)
+            {
+                const auto* rowA = a + i * k;
+                auto* rowC = c + i * n + j0;
+                for (auto p = p0; p < pEnd; ++p)
+                    axpy(rowA[p], b + p * n + j0, rowC, nb);
+            }
+        }
+    }
+}
+
+template <typename T>
+void gemmTNAccumulate(const T* a, const T* b, T* c, unsigned long m, unsigned long n,
+                      unsigned long k, unsigned long lda)
+{
+    const auto axpy = axpyKernel<T>(active());
+
+    for (auto i0 = 0ul; i0 < m; i0 += s_rowBlock)
+    {
+        const auto iEnd = std::min(i0 + s_rowBlock, m);
+        for (auto j0 = 0ul; j0 < n; j0 += s_depthBlock)
+        {
+            const auto nb = std::min(s_depthBlock, n - j0);
+            for (auto p = 0ul; p < k; ++p)
+            {
+                const auto* rowA = a + p * lda;
+                const auto* rowB = b + p * n + j0;
+                for (auto i = i0; i < iEnd; ++i)
+                    axpy(rowA[i], rowB, c + i * n + j0, nb);
+            }
+        }
+    }
+}
+
+template void gemmNT<double, double>(const double*, const double*, double*, unsigned long,
+                                     unsigned long, unsigned long);
+template void gemmNT<float, float>(const float*, const float*, float*, unsigned long,
+                                   unsigned long, unsigned long);
+template void gemmNT<float, double>(const float*, const float*, float*, unsigned long,
+                                    unsigned long, unsigned long);
+template void gemmNN<double>(const double*, const double*, double*, unsigned long,
+                             unsigned long, unsigned long);
+template void gemmNN<float>(const float*, const float*, float*, unsigned long, unsigned long,
+                            unsigned long);
+template void gemmTNAccumulate<double>(const double*, const double*, double*, unsigned long,
+                                       unsigned long, unsigned long, unsigned long);
+template void gemmTNAccumulate<float>(const float*, const float*, float*, unsigned long,
+                                      unsigned long, unsigned long, unsigned long);
+
+} // namespace Engine::Kernels
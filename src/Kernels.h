@@ -0,0 +1,223 @@
+/* Dense linear algebra used by the network. All matrices are row-major and tightly packed.
+ * The vector kernels exist once per instruction set and the widest one the CPU supports is
+ * picked at startup. The matrix-matrix products are cache blocked and built on top of them.
+ * Every kernel comes in double and single precision, the single precision ones process twice
+ * the lanes per register. */
+#pragma once
+
+#include <type_traits>
+
+namespace Engine::Kernels {
+
+enum class Isa { Scalar, SSE2, AVX2, AVX512 };
+
+struct KernelTable
+{
+    Isa isa;
+    const char* name;
+    double (*dot)(const double* a, const double* b, unsigned long n);
+    void (*axpy)(double a, const double* x, double* y, unsigned long n);
+    void (*momentumUpdate)(double* weights, double* deltas, const double* x, double scale,
+                           double momentum, unsigned long n);
+
+    float (*dotF32)(const float* a, const float* b, unsigned long n);
+    void (*axpyF32)(float a, const float* x, float* y, unsigned long n);
+    void (*momentumUpdateF32)(float* weights, float* deltas, const float* x, float scale,
+                              float momentum, unsigned long n);
+
+    // Single precision operands, products summed in double precision
+    double (*dotF32Mixed)(const float* a, const float* b, unsigned long n);
+
+    // Activations, applied in place to a whole array
+    void (*tanhApprox)(double* x, unsigned long n, double inScale, double outScale,
+                       double offset);
+    void (*tanhApproxF32)(float* x, unsigned long n, float inScale, float outScale, float offset);
+    void (*leakyRelu)(double* x, double slope, unsigned long n);
+    void (*leakyReluF32)(float* x, float slope, unsigned long n);
+
+    // Optimizer steps, see the wrappers below
+    void (*nesterovUpdate)(double* weights, double* velocity, const double* x, double scale,
+                           double momentum, unsigned long n);
+    void (*rmsPropUpdate)(double* weights, double* meanSquare, const double* x, double scale,
+                          double rate, double decay, double epsilon, unsigned long n);
+    void (*adamUpdate)(double* weights, double* mean, double* variance, const double* x,
+                       double scale, double step, double beta1, double beta2, double epsilon,
+                       unsigned long n);
+    void (*nesterovUpdateF32)(float* weights, float* velocity, const float* x, float scale,
+                              float momentum, unsigned long n);
+    void (*rmsPropUpdateF32)(float* weights, float* meanSquare, const float* x, float scale,
+                             float rate, float decay, float epsilon, unsigned long n);
+    void (*adamUpdateF32)(float* weights, float* mean, float* variance, const float* x,
+                          float scale, float step, float beta1, float beta2, float epsilon,
+                          unsigned long n);
+};
+
+// Rational tanh approximation, p(x) / q(x) with an odd numerator of degree 13 and an even
+// denominator of degree 6, evaluated on x clamped to [-s_tanhClamp, s_tanhClamp]. Outside of
+// that range tanh rounds to +-1 in single precision. The absolute error stays below 3e-7 in
+// both precisions, most of it at the clamp, since tanh(7.9) is 1 - 2.7e-7.
+namespace TanhApprox {
+inline constexpr double s_clamp = 7.90531110763549805;
+inline constexpr double s_alpha[7] = {4.89352455891786e-03,  6.37261928875436e-04,
+                                      1.48572235717979e-05,  5.12229709037114e-08,
+                                      -8.60467152213735e-11, 2.00018790482477e-13,
+                                      -2.76076847742355e-16};
+inline constexpr double s_beta[4] = {4.89352518554385e-03, 2.26843463243900e-03,
+                                     1.18534705686654e-04, 1.19825839466702e-06};
+} // namespace TanhApprox
+
+// Widest instruction set supported by both the build and the running CPU
+Isa detectIsa();
+bool isSupported(Isa isa);
+
+// Kernels currently in use. select() can force a narrower set, e.g. the scalar reference path
+// when validating the vectorized ones. It must not be called while a network is running.
+const KernelTable& active();
+const KernelTable& table(Isa isa);
+void select(Isa isa);
+
+// Per instruction set tables, only the ones enabled in the build are defined
+const KernelTable& scalarKernels();
+const KernelTable& sse2Kernels();
+const KernelTable& avx2Kernels();
+const KernelTable& avx512Kernels();
+
+inline double dot(const double* a, const double* b, unsigned long n)
+{
+    return active().dot(a, b, n);
+}
+
+inline float dot(const float* a, const float* b, unsigned long n)
+{
+    return active().dotF32(a, b, n);
+}
+
+inline double dotMixed(const float* a, const float* b, unsigned long n)
+{
+    return active().dotF32Mixed(a, b, n);
+}
+
+// Dot product summed in Acc, which may be wider than the operands
+template <typename Acc, typename T>
+inline Acc dotIn(const T* a, const T* b, unsigned long n)
+{
+    if constexpr (std::is_same_v<Acc, T>)
+        return dot(a, b, n);
+    else
+        return dotMixed(a, b, n);
+}
+
+// y += a * x
+inline void axpy(double a, const double* x, double* y, unsigned long n)
+{
+    active().axpy(a, x, y, n);
+}
+
+inline void axpy(float a, const float* x, float* y, unsigned long n)
+{
+    active().axpyF32(a, x, y, n);
+}
+
+// deltas = scale * x + momentum * deltas; weights += deltas
+inline void momentumUpdate(double* weights, double* deltas, const double* x, double scale,
+                           double momentum, unsigned long n)
+{
+    active().momentumUpdate(weights, deltas, x, scale, momentum, n);
+}
+
+inline void momentumUpdate(float* weights, float* deltas, const float* x, float scale,
+                           float momentum, unsigned long n)
+{
+    active().momentumUpdateF32(weights, deltas, x, scale, momentum, n);
+}
+
+// The optimizer steps all move the weights along g = scale * x. Each one reads and writes the
+// weights and their state in a single pass.
+
+// velocity = momentum * velocity + g; weights += momentum * velocity + g
+inline void nesterovUpdate(double* weights, double* velocity, const double* x, double scale,
+                           double momentum, unsigned long n)
+{
+    active().nesterovUpdate(weights, velocity, x, scale, momentum, n);
+}
+
+inline void nesterovUpdate(float* weights, float* velocity, const float* x, float scale,
+                           float momentum, unsigned long n)
+{
+    active().nesterovUpdateF32(weights, velocity, x, scale, momentum, n);
+}
+
+// meanSquare = decay * meanSquare + (1 - decay) * g^2;
+// weights += rate * g / (sqrt(meanSquare) + epsilon)
+inline void rmsPropUpdate(double* weights, double* meanSquare, const double* x, double scale,
+                          double rate, double decay, double epsilon, unsigned long n)
+{
+    active().rmsPropUpdate(weights, meanSquare, x, scale, rate, decay, epsilon, n);
+}
+
+inline void rmsPropUpdate(float* weights, float* meanSquare, const float* x, float scale,
+                          float rate, float decay, float epsilon, unsigned long n)
+{
+    active().rmsPropUpdateF32(weights, meanSquare, x, scale, rate, decay, epsilon, n);
+}
+
+// mean = beta1 * mean + (1 - beta1) * g; variance = beta2 * variance + (1 - beta2) * g^2;
+// weights += step * mean / (sqrt(variance) + epsilon). Bias correction is up to the caller,
+// folded into step and epsilon.
+inline void adamUpdate(double* weights, double* mean, double* variance, const double* x,
+                       double scale, double step, double beta1, double beta2, double epsilon,
+                       unsigned long n)
+{
+    active().adamUpdate(weights, mean, variance, x, scale, step, beta1, beta2, epsilon, n);
+}
+
+inline void adamUpdate(float* weights, float* mean, float* variance, const float* x,
+                       float scale, float step, float beta1, float beta2, float epsilon,
+                       unsigned long n)
+{
+    active().adamUpdateF32(weights, mean, variance, x, scale, step, beta1, beta2, epsilon, n);
+}
+
+// x = outScale * tanh(inScale * x) + offset, using the rational approximation above. The
+// scales and offset let the logistic sigmoid, 0.5 * tanh(0.5 * x) + 0.5, share the kernel.
+inline void tanhApprox(double* x, unsigned long n, double inScale = 1.0, double outScale = 1.0,
+                       double offset = 0.0)
+{
+    active().tanhApprox(x, n, inScale, outScale, offset);
+}
+
+inline void tanhApprox(float* x, unsigned long n, float inScale = 1.0f, float outScale = 1.0f,
+                       float offset = 0.0f)
+{
+    active().tanhApproxF32(x, n, inScale, outScale, offset);
+}
+
+// x = max(x, slope * x), i.e. ReLU for a slope of 0. The slope must not exceed 1.
+inline void leakyRelu(double* x, double slope, unsigned long n)
+{
+    active().leakyRelu(x, slope, n);
+}
+
+inline void leakyRelu(float* x, float slope, unsigned long n)
+{
+    active().leakyReluF32(x, slope, n);
+}
+
+// The matrix products are defined for float and double. Acc is the type gemmNT's dot products
+// are summed in, double with float operands is the mixed precision variant.
+
+// C[m x n] = A[m x k] * B[n x k]^T
+template <typename T, typename Acc = T>
+void gemmNT(const T* a, const T* b, T* c, unsigned long m, unsigned long n, unsigned long k);
+
+// C[m x n] = A[m x k] * B[k x n]
+template <typename T>
+void gemmNN(const T* a, const T* b, T* c, unsigned long m, unsigned long n, unsigned long k);
+
+// C[m x n] += A[k x m]^T * B[k x n]. Rows of A are lda elements apart, so a band of C's rows
+// can be computed from a column slice of A.
+template <typename T>
+void gemmTNAccumulate(const T* a, const T* b, T* c, unsigned long m, unsigned long n,
+                      unsigned long k, unsigned long lda);
+
+} // namespace Engine::Kernels
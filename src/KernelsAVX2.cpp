@@ -0,0 +1,496 @@
+// Built with -mavx2 -mfma. Only reached after the CPU has been checked for both.
+// No standard library templates or inline functions are used in here. They are emitted as
+// weak symbols, and the linker may pick this file's copy, built for the wider instruction set,
+// for callers anywhere in the program.
+
+// clang-format off
+#include "Kernels.h"
+#include <immintrin.h>
+// clang-format on
+
+namespace Engine::Kernels {
+
+namespace Avx2 {
+
+static double dot(const double* a, const double* b, unsigned long n)
+{
+    auto acc0 = _mm256_setzero_pd();
+    auto acc1 = _mm256_setzero_pd();
+    auto acc2 = _mm256_setzero_pd();
+    auto acc3 = _mm256_setzero_pd();
+
+    auto i = 0ul;
+    for (; i + 16 <= n; i += 16)
+    {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), acc1);
+        acc2 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 8), _mm256_loadu_pd(b + i + 8), acc2);
+        acc3 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 12), _mm256_loadu_pd(b + i + 12), acc3);
+    }
+
+    for (; i + 4 <= n; i += 4)
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+
+    acc0 = _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3));
+    auto half = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    auto sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+
+static void axpy(double a, const double* x, double* y, unsigned long n)
+{
+    const auto va = _mm256_set1_pd(a);
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto vy = _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i));
+        _mm256_storeu_pd(y + i, vy);
+    }
+
+    for (; i < n; ++i)
+        y[i] += a * x[i];
+}
+
+static void momentumUpdate(double* weights, double* deltas, const double* x, double scale,
+                           double momentum, unsigned long n)
+{
+    const auto vs = _mm256_set1_pd(scale);
+    const auto vm = _mm256_set1_pd(momentum);
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto d = _mm256_fmadd_pd(vs, _mm256_loadu_pd(x + i),
+                                       _mm256_mul_pd(vm, _mm256_loadu_pd(deltas + i)));
+        _mm256_storeu_pd(deltas + i, d);
+        _mm256_storeu_pd(weights + i, _mm256_add_pd(_mm256_loadu_pd(weights + i), d));
+    }
+
+    for (; i < n; ++i)
+    {
+        deltas[i] = scale * x[i] + momentum * deltas[i];
+        weights[i] += deltas[i];
+    }
+}
+
+static float dotF32(const float* a, const float* b, unsigned long n)
+{
+    auto acc0 = _mm256_setzero_ps();
+    auto acc1 = _mm256_setzero_ps();
+    auto acc2 = _mm256_setzero_ps();
+    auto acc3 = _mm256_setzero_ps();
+
+    auto i = 0ul;
+    for (; i + 32 <= n; i += 32)
+    {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+        acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), acc2);
+        acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), acc3);
+    }
+
+    for (; i + 8 <= n; i += 8)
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+
+    acc0 = _mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3));
+    auto quad = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    quad = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+    auto sum = _mm_cvtss_f32(_mm_add_ss(quad, _mm_shuffle_ps(quad, quad, 1)));
+
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+
+static void axpyF32(float a, const float* x, float* y, unsigned long n)
+{
+    const auto va = _mm256_set1_ps(a);
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto vy = _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i));
+        _mm256_storeu_ps(y + i, vy);
+    }
+
+    for (; i < n; ++i)
+        y[i] += a * x[i];
+}
+
+static void momentumUpdateF32(float* weights, float* deltas, const float* x, float scale,
+                              float momentum, unsigned long n)
+{
+    const auto vs = _mm256_set1_ps(scale);
+    const auto vm = _mm256_set1_ps(momentum);
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto d = _mm256_fmadd_ps(vs, _mm256_loadu_ps(x + i),
+                                       _mm256_mul_ps(vm, _mm256_loadu_ps(deltas + i)));
+        _mm256_storeu_ps(deltas + i, d);
+        _mm256_storeu_ps(weights + i, _mm256_add_ps(_mm256_loadu_ps(weights + i), d));
+    }
+
+    for (; i < n; ++i)
+    {
+        deltas[i] = scale * x[i] + momentum * deltas[i];
+        weights[i] += deltas[i];
+    }
+}
+
+static double dotF32Mixed(const float* a, const float* b, unsigned long n)
+{
+    auto acc0 = _mm256_setzero_pd();
+    auto acc1 = _mm256_setzero_pd();
+
+    // Eight floats per load, widened to two registers of doubles
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto va = _mm256_loadu_ps(a + i);
+        const auto vb = _mm256_loadu_ps(b + i);
+        acc0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(va)),
+                               _mm256_cvtps_pd(_mm256_castps256_ps128(vb)), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(va, 1)),
+                               _mm256_cvtps_pd(_mm256_extractf128_ps(vb, 1)), acc1);
+    }
+
+    acc0 = _mm256_add_pd(acc0, acc1);
+    auto half = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    auto sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+
+    for (; i < n; ++i)
+        sum += static_cast<double>(a[i]) * static_cast<double>(b[i]);
+
+    return sum;
+}
+
+
+// p(v) / q(v) * v on four lanes, see Kernels.h
+static inline __m256d tanhLanes(__m256d v)
+{
+    using namespace TanhApprox;
+    v = _mm256_min_pd(_mm256_max_pd(v, _mm256_set1_pd(-s_clamp)), _mm256_set1_pd(s_clamp));
+    const auto v2 = _mm256_mul_pd(v, v);
+
+    auto p = _mm256_set1_pd(s_alpha[6]);
+    for (auto c = 6; c-- > 0;)
+        p = _mm256_fmadd_pd(p, v2, _mm256_set1_pd(s_alpha[c]));
+
+    auto q = _mm256_set1_pd(s_beta[3]);
+    for (auto c = 3; c-- > 0;)
+        q = _mm256_fmadd_pd(q, v2, _mm256_set1_pd(s_beta[c]));
+
+    return _mm256_div_pd(_mm256_mul_pd(v, p), q);
+}
+
+static inline __m256 tanhLanes(__m256 v)
+{
+    using namespace TanhApprox;
+    const auto limit = static_cast<float>(s_clamp);
+    v = _mm256_min_ps(_mm256_max_ps(v, _mm256_set1_ps(-limit)), _mm256_set1_ps(limit));
+    const auto v2 = _mm256_mul_ps(v, v);
+
+    auto p = _mm256_set1_ps(static_cast<float>(s_alpha[6]));
+    for (auto c = 6; c-- > 0;)
+        p = _mm256_fmadd_ps(p, v2, _mm256_set1_ps(static_cast<float>(s_alpha[c])));
+
+    auto q = _mm256_set1_ps(static_cast<float>(s_beta[3]));
+    for (auto c = 3; c-- > 0;)
+        q = _mm256_fmadd_ps(q, v2, _mm256_set1_ps(static_cast<float>(s_beta[c])));
+
+    return _mm256_div_ps(_mm256_mul_ps(v, p), q);
+}
+
+static void tanhApprox(double* x, unsigned long n, double inScale, double outScale,
+                       double offset)
+{
+    const auto vi = _mm256_set1_pd(inScale);
+    const auto vo = _mm256_set1_pd(outScale);
+    const auto vb = _mm256_set1_pd(offset);
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto t = tanhLanes(_mm256_mul_pd(vi, _mm256_loadu_pd(x + i)));
+        _mm256_storeu_pd(x + i, _mm256_fmadd_pd(vo, t, vb));
+    }
+
+    // The tail goes through the same lanes, padded with zeros
+    if (i < n)
+    {
+        alignas(32) double tail[4] = {};
+        for (auto j = i; j < n; ++j)
+            tail[j - i] = x[j];
+        const auto t = tanhLanes(_mm256_mul_pd(vi, _mm256_load_pd(tail)));
+        _mm256_store_pd(tail, _mm256_fmadd_pd(vo, t, vb));
+        for (auto j = i; j < n; ++j)
+            x[j] = tail[j - i];
+    }
+}
+
+static void tanhApproxF32(float* x, unsigned long n, float inScale, float outScale, float offset)
+{
+    const auto vi = _mm256_set1_ps(inScale);
+    const auto vo = _mm256_set1_ps(outScale);
+    const auto vb = _mm256_set1_ps(offset);
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto t = tanhLanes(_mm256_mul_ps(vi, _mm256_loadu_ps(x + i)));
+        _mm256_storeu_ps(x + i, _mm256_fmadd_ps(vo, t, vb));
+    }
+
+    if (i < n)
+    {
+        alignas(32) float tail[8] = {};
+        for (auto j = i; j < n; ++j)
+            tail[j - i] = x[j];
+        const auto t = tanhLanes(_mm256_mul_ps(vi, _mm256_load_ps(tail)));
+        _mm256_store_ps(tail, _mm256_fmadd_ps(vo, t, vb));
+        for (auto j = i; j < n; ++j)
+            x[j] = tail[j - i];
+    }
+}
+
+static void leakyRelu(double* x, double slope, unsigned long n)
+{
+    const auto vs = _mm256_set1_pd(slope);
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto v = _mm256_loadu_pd(x + i);
+        _mm256_storeu_pd(x + i, _mm256_max_pd(v, _mm256_mul_pd(vs, v)));
+    }
+
+    for (; i < n; ++i)
+        x[i] = x[i] < slope * x[i] ? slope * x[i] : x[i];
+}
+
+static void leakyReluF32(float* x, float slope, unsigned long n)
+{
+    const auto vs = _mm256_set1_ps(slope);
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto v = _mm256_loadu_ps(x + i);
+        _mm256_storeu_ps(x + i, _mm256_max_ps(v, _mm256_mul_ps(vs, v)));
+    }
+
+    for (; i < n; ++i)
+        x[i] = x[i] < slope * x[i] ? slope * x[i] : x[i];
+}
+
+
+static void nesterovUpdate(double* weights, double* velocity, const double* x, double scale,
+                           double momentum, unsigned long n)
+{
+    const auto vs = _mm256_set1_pd(scale);
+    const auto vm = _mm256_set1_pd(momentum);
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto g = _mm256_mul_pd(vs, _mm256_loadu_pd(x + i));
+        const auto v = _mm256_fmadd_pd(vm, _mm256_loadu_pd(velocity + i), g);
+        const auto delta = _mm256_fmadd_pd(vm, v, g);
+        _mm256_storeu_pd(velocity + i, v);
+        _mm256_storeu_pd(weights + i, _mm256_add_pd(_mm256_loadu_pd(weights + i), delta));
+    }
+
+    for (; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        velocity[i] = momentum * velocity[i] + g;
+        weights[i] += momentum * velocity[i] + g;
+    }
+}
+
+static void rmsPropUpdate(double* weights, double* meanSquare, const double* x, double scale,
+                          double rate, double decay, double epsilon, unsigned long n)
+{
+    const auto vs = _mm256_set1_pd(scale);
+    const auto vr = _mm256_set1_pd(rate);
+    const auto vd = _mm256_set1_pd(decay);
+    const auto vc = _mm256_set1_pd(1.0 - decay);
+    const auto ve = _mm256_set1_pd(epsilon);
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto g = _mm256_mul_pd(vs, _mm256_loadu_pd(x + i));
+        const auto s = _mm256_fmadd_pd(vd, _mm256_loadu_pd(meanSquare + i),
+                                       _mm256_mul_pd(vc, _mm256_mul_pd(g, g)));
+        const auto delta = _mm256_div_pd(_mm256_mul_pd(vr, g),
+                                         _mm256_add_pd(_mm256_sqrt_pd(s), ve));
+        _mm256_storeu_pd(meanSquare + i, s);
+        _mm256_storeu_pd(weights + i, _mm256_add_pd(_mm256_loadu_pd(weights + i), delta));
+    }
+
+    for (; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        meanSquare[i] = decay * meanSquare[i] + (1.0 - decay) * g * g;
+        weights[i] += rate * g / (__builtin_sqrt(meanSquare[i]) + epsilon);
+    }
+}
+
+static void adamUpdate(double* weights, double* mean, double* variance, const double* x,
+                       double scale, double step, double beta1, double beta2, double epsilon,
+                       unsigned long n)
+{
+    const auto vs = _mm256_set1_pd(scale);
+    const auto vt = _mm256_set1_pd(step);
+    const auto vb1 = _mm256_set1_pd(beta1);
+    const auto vc1 = _mm256_set1_pd(1.0 - beta1);
+    const auto vb2 = _mm256_set1_pd(beta2);
+    const auto vc2 = _mm256_set1_pd(1.0 - beta2);
+    const auto ve = _mm256_set1_pd(epsilon);
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto g = _mm256_mul_pd(vs, _mm256_loadu_pd(x + i));
+        const auto m = _mm256_fmadd_pd(vb1, _mm256_loadu_pd(mean + i), _mm256_mul_pd(vc1, g));
+        const auto v = _mm256_fmadd_pd(vb2, _mm256_loadu_pd(variance + i),
+                                       _mm256_mul_pd(vc2, _mm256_mul_pd(g, g)));
+        const auto delta = _mm256_div_pd(_mm256_mul_pd(vt, m),
+                                         _mm256_add_pd(_mm256_sqrt_pd(v), ve));
+        _mm256_storeu_pd(mean + i, m);
+        _mm256_storeu_pd(variance + i, v);
+        _mm256_storeu_pd(weights + i, _mm256_add_pd(_mm256_loadu_pd(weights + i), delta));
+    }
+
+    for (; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        mean[i] = beta1 * mean[i] + (1.0 - beta1) * g;
+        variance[i] = beta2 * variance[i] + (1.0 - beta2) * g * g;
+        weights[i] += step * mean[i] / (__builtin_sqrt(variance[i]) + epsilon);
+    }
+}
+
+static void nesterovUpdateF32(float* weights, float* velocity, const float* x, float scale,
+                              float momentum, unsigned long n)
+{
+    const auto vs = _mm256_set1_ps(scale);
+    const auto vm = _mm256_set1_ps(momentum);
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto g = _mm256_mul_ps(vs, _mm256_loadu_ps(x + i));
+        const auto v = _mm256_fmadd_ps(vm, _mm256_loadu_ps(velocity + i), g);
+        const auto delta = _mm256_fmadd_ps(vm, v, g);
+        _mm256_storeu_ps(velocity + i, v);
+        _mm256_storeu_ps(weights + i, _mm256_add_ps(_mm256_loadu_ps(weights + i), delta));
+    }
+
+    for (; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        velocity[i] = momentum * velocity[i] + g;
+        weights[i] += momentum * velocity[i] + g;
+    }
+}
+
+static void rmsPropUpdateF32(float* weights, float* meanSquare, const float* x, float scale,
+                             float rate, float decay, float epsilon, unsigned long n)
+{
+    const auto vs = _mm256_set1_ps(scale);
+    const auto vr = _mm256_set1_ps(rate);
+    const auto vd = _mm256_set1_ps(decay);
+    const auto vc = _mm256_set1_ps(1.0f - decay);
+    const auto ve = _mm256_set1_ps(epsilon);
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto g = _mm256_mul_ps(vs, _mm256_loadu_ps(x + i));
+        const auto s = _mm256_fmadd_ps(vd, _mm256_loadu_ps(meanSquare + i),
+                                       _mm256_mul_ps(vc, _mm256_mul_ps(g, g)));
+        const auto delta = _mm256_div_ps(_mm256_mul_ps(vr, g),
+                                         _mm256_add_ps(_mm256_sqrt_ps(s), ve));
+        _mm256_storeu_ps(meanSquare + i, s);
+        _mm256_storeu_ps(weights + i, _mm256_add_ps(_mm256_loadu_ps(weights + i), delta));
+    }
+
+    for (; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        meanSquare[i] = decay * meanSquare[i] + (1.0f - decay) * g * g;
+        weights[i] += rate * g / (__builtin_sqrtf(meanSquare[i]) + epsilon);
+    }
+}
+
+static void adamUpdateF32(float* weights, float* mean, float* variance, const float* x, float scale,
+                          float step, float beta1, float beta2, float epsilon, unsigned long n)
+{
+    const auto vs = _mm256_set1_ps(scale);
+    const auto vt = _mm256_set1_ps(step);
+    const auto vb1 = _mm256_set1_ps(beta1);
+    const auto vc1 = _mm256_set1_ps(1.0f - beta1);
+    const auto vb2 = _mm256_set1_ps(beta2);
+    const auto vc2 = _mm256_set1_ps(1.0f - beta2);
+    const auto ve = _mm256_set1_ps(epsilon);
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto g = _mm256_mul_ps(vs, _mm256_loadu_ps(x + i));
+        const auto m = _mm256_fmadd_ps(vb1, _mm256_loadu_ps(mean + i), _mm256_mul_ps(vc1, g));
+        const auto v = _mm256_fmadd_ps(vb2, _mm256_loadu_ps(variance + i),
+                                       _mm256_mul_ps(vc2, _mm256_mul_ps(g, g)));
+        const auto delta = _mm256_div_ps(_mm256_mul_ps(vt, m),
+                                         _mm256_add_ps(_mm256_sqrt_ps(v), ve));
+        _mm256_storeu_ps(mean + i, m);
+        _mm256_storeu_ps(variance + i, v);
+        _mm256_storeu_ps(weights + i, _mm256_add_ps(_mm256_loadu_ps(weights + i), delta));
+    }
+
+    for (; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        mean[i] = beta1 * mean[i] + (1.0f - beta1) * g;
+        variance[i] = beta2 * variance[i] + (1.0f - beta2) * g * g;
+        weights[i] += step * mean[i] / (__builtin_sqrtf(variance[i]) + epsilon);
+    }
+}
+
+} // namespace Avx2
+
+const KernelTable& avx2Kernels()
+{
+    static const KernelTable table{Isa::AVX2,
+                                   "AVX2",
+                                   Avx2::dot,
+                                   Avx2::axpy,
+                                   Avx2::momentumUpdate,
+                                   Avx2::dotF32,
+                                   Avx2::axpyF32,
+                                   Avx2::momentumUpdateF32,
+                                   Avx2::dotF32Mixed,
+                                   Avx2::tanhApprox,
+                                   Avx2::tanhApproxF32,
+                                   Avx2::leakyRelu,
+                                   Avx2::leakyReluF32,
+                                   Avx2::nesterovUpdate,
+                                   Avx2::rmsPropUpdate,
+                                   Avx2::adamUpdate,
+                                   Avx2::nesterovUpdateF32,
+                                   Avx2::rmsPropUpdateF32,
+                                   Avx2::adamUpdateF32};
+    return table;
+}
+
+} // namespace Engine::Kernels
@@ -0,0 +1,578 @@
+// Built with -mavx512f. Only reached after the CPU has been checked for it. Tails are handled
+// with masked loads and stores instead of a scalar loop.
+// No standard library templates or inline functions are used in here. They are emitted as
+// weak symbols, and the linker may pick this file's copy, built for the wider instruction set,
+// for callers anywhere in the program.
+
+// clang-format off
+#include "Kernels.h"
+#include <immintrin.h>
+// clang-format on
+
+namespace Engine::Kernels {
+
+namespace Avx512 {
+
+static inline __mmask8 tailMask(unsigned long remaining)
+{
+    return static_cast<__mmask8>((1u << remaining) - 1u);
+}
+
+static inline __mmask16 tailMaskF32(unsigned long remaining)
+{
+    return static_cast<__mmask16>((1u << remaining) - 1u);
+}
+
+static double dot(const double* a, const double* b, unsigned long n)
+{
+    auto acc0 = _mm512_setzero_pd();
+    auto acc1 = _mm512_setzero_pd();
+
+    auto i = 0ul;
+    for (; i + 16 <= n; i += 16)
+    {
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+        acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8), acc1);
+    }
+
+    for (; i + 8 <= n; i += 8)
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+
+    if (i < n)
+    {
+        const auto mask = tailMask(n - i);
+        acc1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a + i),
+                               _mm512_maskz_loadu_pd(mask, b + i), acc1);
+    }
+
+    // Spilling the lanes sidesteps GCC's -Wuninitialized false positive in _mm512_reduce_add_pd
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, _mm512_add_pd(acc0, acc1));
+
+    return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) +
+           ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+}
+
+static void axpy(double a, const double* x, double* y, unsigned long n)
+{
+    const auto va = _mm512_set1_pd(a);
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto vy = _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i));
+        _mm512_storeu_pd(y + i, vy);
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMask(n - i);
+        const auto vy = _mm512_maskz_loadu_pd(mask, y + i);
+        _mm512_mask_storeu_pd(y + i, mask,
+                              _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(mask, x + i), vy));
+    }
+}
+
+static void momentumUpdate(double* weights, double* deltas, const double* x, double scale,
+                           double momentum, unsigned long n)
+{
+    const auto vs = _mm512_set1_pd(scale);
+    const auto vm = _mm512_set1_pd(momentum);
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto d = _mm512_fmadd_pd(vs, _mm512_loadu_pd(x + i),
+                                       _mm512_mul_pd(vm, _mm512_loadu_pd(deltas + i)));
+        _mm512_storeu_pd(deltas + i, d);
+        _mm512_storeu_pd(weights + i, _mm512_add_pd(_mm512_loadu_pd(weights + i), d));
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMask(n - i);
+        const auto d = _mm512_fmadd_pd(vs, _mm512_maskz_loadu_pd(mask, x + i),
+                                       _mm512_mul_pd(vm, _mm512_maskz_loadu_pd(mask, deltas + i)));
+        _mm512_mask_storeu_pd(deltas + i, mask, d);
+        _mm512_mask_storeu_pd(weights + i, mask,
+                              _mm512_add_pd(_mm512_maskz_loadu_pd(mask, weights + i), d));
+    }
+}
+
+static float dotF32(const float* a, const float* b, unsigned long n)
+{
+    auto acc0 = _mm512_setzero_ps();
+    auto acc1 = _mm512_setzero_ps();
+
+    auto i = 0ul;
+    for (; i + 32 <= n; i += 32)
+    {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+    }
+
+    for (; i + 16 <= n; i += 16)
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+
+    if (i < n)
+    {
+        const auto mask = tailMaskF32(n - i);
+        acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i),
+                               _mm512_maskz_loadu_ps(mask, b + i), acc1);
+    }
+
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, _mm512_add_ps(acc0, acc1));
+
+    auto sum = 0.0f;
+    for (auto lane = 0; lane < 8; ++lane)
+        sum += lanes[lane] + lanes[lane + 8];
+
+    return sum;
+}
+
+static void axpyF32(float a, const float* x, float* y, unsigned long n)
+{
+    const auto va = _mm512_set1_ps(a);
+
+    auto i = 0ul;
+    for (; i + 16 <= n; i += 16)
+    {
+        const auto vy = _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i));
+        _mm512_storeu_ps(y + i, vy);
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMaskF32(n - i);
+        const auto vy = _mm512_maskz_loadu_ps(mask, y + i);
+        _mm512_mask_storeu_ps(y + i, mask,
+                              _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(mask, x + i), vy));
+    }
+}
+
+static void momentumUpdateF32(float* weights, float* deltas, const float* x, float scale,
+                              float momentum, unsigned long n)
+{
+    const auto vs = _mm512_set1_ps(scale);
+    const auto vm = _mm512_set1_ps(momentum);
+
+    auto i = 0ul;
+    for (; i + 16 <= n; i += 16)
+    {
+        const auto d = _mm512_fmadd_ps(vs, _mm512_loadu_ps(x + i),
+                                       _mm512_mul_ps(vm, _mm512_loadu_ps(deltas + i)));
+        _mm512_storeu_ps(deltas + i, d);
+        _mm512_storeu_ps(weights + i, _mm512_add_ps(_mm512_loadu_ps(weights + i), d));
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMaskF32(n - i);
+        const auto d = _mm512_fmadd_ps(vs, _mm512_maskz_loadu_ps(mask, x + i),
+                                       _mm512_mul_ps(vm, _mm512_maskz_loadu_ps(mask, deltas + i)));
+        _mm512_mask_storeu_ps(deltas + i, mask, d);
+        _mm512_mask_storeu_ps(weights + i, mask,
+                              _mm512_add_ps(_mm512_maskz_loadu_ps(mask, weights + i), d));
+    }
+}
+
+// Widen the low or high eight floats of a register to doubles. The zero-masked forms do the
+// same as the plain intrinsics without their undefined source operand, which GCC warns about.
+template <int Half>
+static inline __m512d widen(__m512 v)
+{
+    const auto half = _mm512_maskz_extractf64x4_pd(0xf, _mm512_castps_pd(v), Half);
+    return _mm512_maskz_cvtps_pd(0xff, _mm256_castpd_ps(half));
+}
+
+static double dotF32Mixed(const float* a, const float* b, unsigned long n)
+{
+    auto acc0 = _mm512_setzero_pd();
+    auto acc1 = _mm512_setzero_pd();
+
+    // Sixteen floats per load, widened to two registers of doubles
+    auto i = 0ul;
+    for (; i + 16 <= n; i += 16)
+    {
+        const auto va = _mm512_loadu_ps(a + i);
+        const auto vb = _mm512_loadu_ps(b + i);
+        acc0 = _mm512_fmadd_pd(widen<0>(va), widen<0>(vb), acc0);
+        acc1 = _mm512_fmadd_pd(widen<1>(va), widen<1>(vb), acc1);
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMaskF32(n - i);
+        const auto va = _mm512_maskz_loadu_ps(mask, a + i);
+        const auto vb = _mm512_maskz_loadu_ps(mask, b + i);
+        acc0 = _mm512_fmadd_pd(widen<0>(va), widen<0>(vb), acc0);
+        acc1 = _mm512_fmadd_pd(widen<1>(va), widen<1>(vb), acc1);
+    }
+
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, _mm512_add_pd(acc0, acc1));
+
+    return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) +
+           ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+}
+
+
+// Zero-masked min and max with every lane selected, for the same reason as widen()
+static inline __m512d maxLanes(__m512d a, __m512d b) { return _mm512_maskz_max_pd(0xff, a, b); }
+static inline __m512d minLanes(__m512d a, __m512d b) { return _mm512_maskz_min_pd(0xff, a, b); }
+static inline __m512 maxLanes(__m512 a, __m512 b) { return _mm512_maskz_max_ps(0xffff, a, b); }
+static inline __m512 minLanes(__m512 a, __m512 b) { return _mm512_maskz_min_ps(0xffff, a, b); }
+
+// p(v) / q(v) * v on eight lanes, see Kernels.h
+static inline __m512d tanhLanes(__m512d v)
+{
+    using namespace TanhApprox;
+    v = minLanes(maxLanes(v, _mm512_set1_pd(-s_clamp)), _mm512_set1_pd(s_clamp));
+    const auto v2 = _mm512_mul_pd(v, v);
+
+    auto p = _mm512_set1_pd(s_alpha[6]);
+    for (auto c = 6; c-- > 0;)
+        p = _mm512_fmadd_pd(p, v2, _mm512_set1_pd(s_alpha[c]));
+
+    auto q = _mm512_set1_pd(s_beta[3]);
+    for (auto c = 3; c-- > 0;)
+        q = _mm512_fmadd_pd(q, v2, _mm512_set1_pd(s_beta[c]));
+
+    return _mm512_div_pd(_mm512_mul_pd(v, p), q);
+}
+
+static inline __m512 tanhLanes(__m512 v)
+{
+    using namespace TanhApprox;
+    const auto limit = static_cast<float>(s_clamp);
+    v = minLanes(maxLanes(v, _mm512_set1_ps(-limit)), _mm512_set1_ps(limit));
+    const auto v2 = _mm512_mul_ps(v, v);
+
+    auto p = _mm512_set1_ps(static_cast<float>(s_alpha[6]));
+    for (auto c = 6; c-- > 0;)
+        p = _mm512_fmadd_ps(p, v2, _mm512_set1_ps(static_cast<float>(s_alpha[c])));
+
+    auto q = _mm512_set1_ps(static_cast<float>(s_beta[3]));
+    for (auto c = 3; c-- > 0;)
+        q = _mm512_fmadd_ps(q, v2, _mm512_set1_ps(static_cast<float>(s_beta[c])));
+
+    return _mm512_div_ps(_mm512_mul_ps(v, p), q);
+}
+
+static void tanhApprox(double* x, unsigned long n, double inScale, double outScale,
+                       double offset)
+{
+    const auto vi = _mm512_set1_pd(inScale);
+    const auto vo = _mm512_set1_pd(outScale);
+    const auto vb = _mm512_set1_pd(offset);
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto t = tanhLanes(_mm512_mul_pd(vi, _mm512_loadu_pd(x + i)));
+        _mm512_storeu_pd(x + i, _mm512_fmadd_pd(vo, t, vb));
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMask(n - i);
+        const auto t = tanhLanes(_mm512_mul_pd(vi, _mm512_maskz_loadu_pd(mask, x + i)));
+        _mm512_mask_storeu_pd(x + i, mask, _mm512_fmadd_pd(vo, t, vb));
+    }
+}
+
+static void tanhApproxF32(float* x, unsigned long n, float inScale, float outScale, float offset)
+{
+    const auto vi = _mm512_set1_ps(inScale);
+    const auto vo = _mm512_set1_ps(outScale);
+    const auto vb = _mm512_set1_ps(offset);
+
+    auto i = 0ul;
+    for (; i + 16 <= n; i += 16)
+    {
+        const auto t = tanhLanes(_mm512_mul_ps(vi, _mm512_loadu_ps(x + i)));
+        _mm512_storeu_ps(x + i, _mm512_fmadd_ps(vo, t, vb));
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMaskF32(n - i);
+        const auto t = tanhLanes(_mm512_mul_ps(vi, _mm512_maskz_loadu_ps(mask, x + i)));
+        _mm512_mask_storeu_ps(x + i, mask, _mm512_fmadd_ps(vo, t, vb));
+    }
+}
+
+static void leakyRelu(double* x, double slope, unsigned long n)
+{
+    const auto vs = _mm512_set1_pd(slope);
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto v = _mm512_loadu_pd(x + i);
+        _mm512_storeu_pd(x + i, maxLanes(v, _mm512_mul_pd(vs, v)));
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMask(n - i);
+        const auto v = _mm512_maskz_loadu_pd(mask, x + i);
+        _mm512_mask_storeu_pd(x + i, mask, maxLanes(v, _mm512_mul_pd(vs, v)));
+    }
+}
+
+static void leakyReluF32(float* x, float slope, unsigned long n)
+{
+    const auto vs = _mm512_set1_ps(slope);
+
+    auto i = 0ul;
+    for (; i + 16 <= n; i += 16)
+    {
+        const auto v = _mm512_loadu_ps(x + i);
+        _mm512_storeu_ps(x + i, maxLanes(v, _mm512_mul_ps(vs, v)));
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMaskF32(n - i);
+        const auto v = _mm512_maskz_loadu_ps(mask, x + i);
+        _mm512_mask_storeu_ps(x + i, mask, maxLanes(v, _mm512_mul_ps(vs, v)));
+    }
+}
+
+
+// Zero-masked square roots with every lane selected, for the same reason as widen()
+static inline __m512d sqrtLanes(__m512d v) { return _mm512_maskz_sqrt_pd(0xff, v); }
+static inline __m512 sqrtLanes(__m512 v) { return _mm512_maskz_sqrt_ps(0xffff, v); }
+
+static void nesterovUpdate(double* weights, double* velocity, const double* x, double scale,
+                           double momentum, unsigned long n)
+{
+    const auto vs = _mm512_set1_pd(scale);
+    const auto vm = _mm512_set1_pd(momentum);
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto g = _mm512_mul_pd(vs, _mm512_loadu_pd(x + i));
+        const auto v = _mm512_fmadd_pd(vm, _mm512_loadu_pd(velocity + i), g);
+        const auto delta = _mm512_fmadd_pd(vm, v, g);
+        _mm512_storeu_pd(velocity + i, v);
+        _mm512_storeu_pd(weights + i, _mm512_add_pd(_mm512_loadu_pd(weights + i), delta));
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMask(n - i);
+        const auto g = _mm512_mul_pd(vs, _mm512_maskz_loadu_pd(mask, x + i));
+        const auto v = _mm512_fmadd_pd(vm, _mm512_maskz_loadu_pd(mask, velocity + i), g);
+        const auto delta = _mm512_fmadd_pd(vm, v, g);
+        _mm512_mask_storeu_pd(velocity + i, mask, v);
+        _mm512_mask_storeu_pd(weights + i, mask,
+                              _mm512_add_pd(_mm512_maskz_loadu_pd(mask, weights + i), delta));
+    }
+}
+
+static void rmsPropUpdate(double* weights, double* meanSquare, const double* x, double scale,
+                          double rate, double decay, double epsilon, unsigned long n)
+{
+    const auto vs = _mm512_set1_pd(scale);
+    const auto vr = _mm512_set1_pd(rate);
+    const auto vd = _mm512_set1_pd(decay);
+    const auto vc = _mm512_set1_pd(1.0 - decay);
+    const auto ve = _mm512_set1_pd(epsilon);
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto g = _mm512_mul_pd(vs, _mm512_loadu_pd(x + i));
+        const auto s = _mm512_fmadd_pd(vd, _mm512_loadu_pd(meanSquare + i),
+                                       _mm512_mul_pd(vc, _mm512_mul_pd(g, g)));
+        const auto delta = _mm512_div_pd(_mm512_mul_pd(vr, g), _mm512_add_pd(sqrtLanes(s), ve));
+        _mm512_storeu_pd(meanSquare + i, s);
+        _mm512_storeu_pd(weights + i, _mm512_add_pd(_mm512_loadu_pd(weights + i), delta));
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMask(n - i);
+        const auto g = _mm512_mul_pd(vs, _mm512_maskz_loadu_pd(mask, x + i));
+        const auto s = _mm512_fmadd_pd(vd, _mm512_maskz_loadu_pd(mask, meanSquare + i),
+                                       _mm512_mul_pd(vc, _mm512_mul_pd(g, g)));
+        const auto delta = _mm512_div_pd(_mm512_mul_pd(vr, g), _mm512_add_pd(sqrtLanes(s), ve));
+        _mm512_mask_storeu_pd(meanSquare + i, mask, s);
+        _mm512_mask_storeu_pd(weights + i, mask,
+                              _mm512_add_pd(_mm512_maskz_loadu_pd(mask, weights + i), delta));
+    }
+}
+
+static void adamUpdate(double* weights, double* mean, double* variance, const double* x,
+                       double scale, double step, double beta1, double beta2, double epsilon,
+                       unsigned long n)
+{
+    const auto vs = _mm512_set1_pd(scale);
+    const auto vt = _mm512_set1_pd(step);
+    const auto vb1 = _mm512_set1_pd(beta1);
+    const auto vc1 = _mm512_set1_pd(1.0 - beta1);
+    const auto vb2 = _mm512_set1_pd(beta2);
+    const auto vc2 = _mm512_set1_pd(1.0 - beta2);
+    const auto ve = _mm512_set1_pd(epsilon);
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        const auto g = _mm512_mul_pd(vs, _mm512_loadu_pd(x + i));
+        const auto m = _mm512_fmadd_pd(vb1, _mm512_loadu_pd(mean + i), _mm512_mul_pd(vc1, g));
+        const auto v = _mm512_fmadd_pd(vb2, _mm512_loadu_pd(variance + i),
+                                       _mm512_mul_pd(vc2, _mm512_mul_pd(g, g)));
+        const auto delta = _mm512_div_pd(_mm512_mul_pd(vt, m), _mm512_add_pd(sqrtLanes(v), ve));
+        _mm512_storeu_pd(mean + i, m);
+        _mm512_storeu_pd(variance + i, v);
+        _mm512_storeu_pd(weights + i, _mm512_add_pd(_mm512_loadu_pd(weights + i), delta));
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMask(n - i);
+        const auto g = _mm512_mul_pd(vs, _mm512_maskz_loadu_pd(mask, x + i));
+        const auto m = _mm512_fmadd_pd(vb1, _mm512_maskz_loadu_pd(mask, mean + i),
+                                       _mm512_mul_pd(vc1, g));
+        const auto v = _mm512_fmadd_pd(vb2, _mm512_maskz_loadu_pd(mask, variance + i),
+                                       _mm512_mul_pd(vc2, _mm512_mul_pd(g, g)));
+        const auto delta = _mm512_div_pd(_mm512_mul_pd(vt, m), _mm512_add_pd(sqrtLanes(v), ve));
+        _mm512_mask_storeu_pd(mean + i, mask, m);
+        _mm512_mask_storeu_pd(variance + i, mask, v);
+        _mm512_mask_storeu_pd(weights + i, mask,
+                              _mm512_add_pd(_mm512_maskz_loadu_pd(mask, weights + i), delta));
+    }
+}
+
+static void nesterovUpdateF32(float* weights, float* velocity, const float* x, float scale,
+                              float momentum, unsigned long n)
+{
+    const auto vs = _mm512_set1_ps(scale);
+    const auto vm = _mm512_set1_ps(momentum);
+
+    auto i = 0ul;
+    for (; i + 16 <= n; i += 16)
+    {
+        const auto g = _mm512_mul_ps(vs, _mm512_loadu_ps(x + i));
+        const auto v = _mm512_fmadd_ps(vm, _mm512_loadu_ps(velocity + i), g);
+        const auto delta = _mm512_fmadd_ps(vm, v, g);
+        _mm512_storeu_ps(velocity + i, v);
+        _mm512_storeu_ps(weights + i, _mm512_add_ps(_mm512_loadu_ps(weights + i), delta));
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMaskF32(n - i);
+        const auto g = _mm512_mul_ps(vs, _mm512_maskz_loadu_ps(mask, x + i));
+        const auto v = _mm512_fmadd_ps(vm, _mm512_maskz_loadu_ps(mask, velocity + i), g);
+        const auto delta = _mm512_fmadd_ps(vm, v, g);
+        _mm512_mask_storeu_ps(velocity + i, mask, v);
+        _mm512_mask_storeu_ps(weights + i, mask,
+                              _mm512_add_ps(_mm512_maskz_loadu_ps(mask, weights + i), delta));
+    }
+}
+
+static void rmsPropUpdateF32(float* weights, float* meanSquare, const float* x, float scale,
+                             float rate, float decay, float epsilon, unsigned long n)
+{
+    const auto vs = _mm512_set1_ps(scale);
+    const auto vr = _mm512_set1_ps(rate);
+    const auto vd = _mm512_set1_ps(decay);
+    const auto vc = _mm512_set1_ps(1.0f - decay);
+    const auto ve = _mm512_set1_ps(epsilon);
+
+    auto i = 0ul;
+    for (; i + 16 <= n; i += 16)
+    {
+        const auto g = _mm512_mul_ps(vs, _mm512_loadu_ps(x + i));
+        const auto s = _mm512_fmadd_ps(vd, _mm512_loadu_ps(meanSquare + i),
+                                       _mm512_mul_ps(vc, _mm512_mul_ps(g, g)));
+        const auto delta = _mm512_div_ps(_mm512_mul_ps(vr, g), _mm512_add_ps(sqrtLanes(s), ve));
+        _mm512_storeu_ps(meanSquare + i, s);
+        _mm512_storeu_ps(weights + i, _mm512_add_ps(_mm512_loadu_ps(weights + i), delta));
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMaskF32(n - i);
+        const auto g = _mm512_mul_ps(vs, _mm512_maskz_loadu_ps(mask, x + i));
+        const auto s = _mm512_fmadd_ps(vd, _mm512_maskz_loadu_ps(mask, meanSquare + i),
+                                       _mm512_mul_ps(vc, _mm512_mul_ps(g, g)));
+        const auto delta = _mm512_div_ps(_mm512_mul_ps(vr, g), _mm512_add_ps(sqrtLanes(s), ve));
+        _mm512_mask_storeu_ps(meanSquare + i, mask, s);
+        _mm512_mask_storeu_ps(weights + i, mask,
+                              _mm512_add_ps(_mm512_maskz_loadu_ps(mask, weights + i), delta));
+    }
+}
+
+static void adamUpdateF32(float* weights, float* mean, float* variance, const float* x, float scale,
+                          float step, float beta1, float beta2, float epsilon, unsigned long n)
+{
+    const auto vs = _mm512_set1_ps(scale);
+    const auto vt = _mm512_set1_ps(step);
+    const auto vb1 = _mm512_set1_ps(beta1);
+    const auto vc1 = _mm512_set1_ps(1.0f - beta1);
+    const auto vb2 = _mm512_set1_ps(beta2);
+    const auto vc2 = _mm512_set1_ps(1.0f - beta2);
+    const auto ve = _mm512_set1_ps(epsilon);
+
+    auto i = 0ul;
+    for (; i + 16 <= n; i += 16)
+    {
+        const auto g = _mm512_mul_ps(vs, _mm512_loadu_ps(x + i));
+        const auto m = _mm512_fmadd_ps(vb1, _mm512_loadu_ps(mean + i), _mm512_mul_ps(vc1, g));
+        const auto v = _mm512_fmadd_ps(vb2, _mm512_loadu_ps(variance + i),
+                                       _mm512_mul_ps(vc2, _mm512_mul_ps(g, g)));
+        const auto delta = _mm512_div_ps(_mm512_mul_ps(vt, m), _mm512_add_ps(sqrtLanes(v), ve));
+        _mm512_storeu_ps(mean + i, m);
+        _mm512_storeu_ps(variance + i, v);
+        _mm512_storeu_ps(weights + i, _mm512_add_ps(_mm512_loadu_ps(weights + i), delta));
+    }
+
+    if (i < n)
+    {
+        const auto mask = tailMaskF32(n - i);
+        const auto g = _mm512_mul_ps(vs, _mm512_maskz_loadu_ps(mask, x + i));
+        const auto m = _mm512_fmadd_ps(vb1, _mm512_maskz_loadu_ps(mask, mean + i),
+                                       _mm512_mul_ps(vc1, g));
+        const auto v = _mm512_fmadd_ps(vb2, _mm512_maskz_loadu_ps(mask, variance + i),
+                                       _mm512_mul_ps(vc2, _mm512_mul_ps(g, g)));
+        const auto delta = _mm512_div_ps(_mm512_mul_ps(vt, m), _mm512_add_ps(sqrtLanes(v), ve));
+        _mm512_mask_storeu_ps(mean + i, mask, m);
+        _mm512_mask_storeu_ps(variance + i, mask, v);
+        _mm512_mask_storeu_ps(weights + i, mask,
+                              _mm512_add_ps(_mm512_maskz_loadu_ps(mask, weights + i), delta));
+    }
+}
+
+} // namespace Avx512
+
+const KernelTable& avx512Kernels()
+{
+    static const KernelTable table{Isa::AVX512,
+                                   "AVX-512",
+                                   Avx512::dot,
+                                   Avx512::axpy,
+                                   Avx512::momentumUpdate,
+                                   Avx512::dotF32,
+                                   Avx512::axpyF32,
+                                   Avx512::momentumUpdateF32,
+                                   Avx512::dotF32Mixed,
+                                   Avx512::tanhApprox,
+                                   Avx512::tanhApproxF32,
+                                   Avx512::leakyRelu,
+                                   Avx512::leakyReluF32,
+                                   Avx512::nesterovUpdate,
+                                   Avx512::rmsPropUpdate,
+                                   Avx512::adamUpdate,
+                                   Avx512::nesterovUpdateF32,
+                                   Avx512::rmsPropUpdateF32,
+                                   Avx512::adamUpdateF32};
+    return table;
+}
+
+} // namespace Engine::Kernels
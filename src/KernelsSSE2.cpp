@@ -0,0 +1,469 @@
+// Built with -msse2. Only reached after the CPU has been checked for it.
+// No standard library templates or inline functions are used in here. They are emitted as
+// weak symbols, and the linker may pick this file's copy, built for the wider instruction set,
+// for callers anywhere in the program.
+
+// clang-format off
+#include "Kernels.h"
+#include <emmintrin.h>
+// clang-format on
+
+namespace Engine::Kernels {
+
+namespace Sse2 {
+
+static double dot(const double* a, const double* b, unsigned long n)
+{
+    auto acc0 = _mm_setzero_pd();
+    auto acc1 = _mm_setzero_pd();
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+    }
+
+    acc0 = _mm_add_pd(acc0, acc1);
+    auto sum = _mm_cvtsd_f64(_mm_add_sd(acc0, _mm_unpackhi_pd(acc0, acc0)));
+
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+
+static void axpy(double a, const double* x, double* y, unsigned long n)
+{
+    const auto va = _mm_set1_pd(a);
+
+    auto i = 0ul;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(va, _mm_loadu_pd(x + i))));
+
+    for (; i < n; ++i)
+        y[i] += a * x[i];
+}
+
+static void momentumUpdate(double* weights, double* deltas, const double* x, double scale,
+                           double momentum, unsigned long n)
+{
+    const auto vs = _mm_set1_pd(scale);
+    const auto vm = _mm_set1_pd(momentum);
+
+    auto i = 0ul;
+    for (; i + 2 <= n; i += 2)
+    {
+        const auto d = _mm_add_pd(_mm_mul_pd(vs, _mm_loadu_pd(x + i)),
+                                  _mm_mul_pd(vm, _mm_loadu_pd(deltas + i)));
+        _mm_storeu_pd(deltas + i, d);
+        _mm_storeu_pd(weights + i, _mm_add_pd(_mm_loadu_pd(weights + i), d));
+    }
+
+    for (; i < n; ++i)
+    {
+        deltas[i] = scale * x[i] + momentum * deltas[i];
+        weights[i] += deltas[i];
+    }
+}
+
+static float dotF32(const float* a, const float* b, unsigned long n)
+{
+    auto acc0 = _mm_setzero_ps();
+    auto acc1 = _mm_setzero_ps();
+
+    auto i = 0ul;
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+
+    acc0 = _mm_add_ps(acc0, acc1);
+    acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+    auto sum = _mm_cvtss_f32(_mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1)));
+
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+
+static void axpyF32(float a, const float* x, float* y, unsigned long n)
+{
+    const auto va = _mm_set1_ps(a);
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(va, _mm_loadu_ps(x + i))));
+
+    for (; i < n; ++i)
+        y[i] += a * x[i];
+}
+
+static void momentumUpdateF32(float* weights, float* deltas, const float* x, float scale,
+                              float momentum, unsigned long n)
+{
+    const auto vs = _mm_set1_ps(scale);
+    const auto vm = _mm_set1_ps(momentum);
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto d = _mm_add_ps(_mm_mul_ps(vs, _mm_loadu_ps(x + i)),
+                                  _mm_mul_ps(vm, _mm_loadu_ps(deltas + i)));
+        _mm_storeu_ps(deltas + i, d);
+        _mm_storeu_ps(weights + i, _mm_add_ps(_mm_loadu_ps(weights + i), d));
+    }
+
+    for (; i < n; ++i)
+    {
+        deltas[i] = scale * x[i] + momentum * deltas[i];
+        weights[i] += deltas[i];
+    }
+}
+
+static double dotF32Mixed(const float* a, const float* b, unsigned long n)
+{
+    auto acc0 = _mm_setzero_pd();
+    auto acc1 = _mm_setzero_pd();
+
+    // Four floats per load, widened to two pairs of doubles
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto va = _mm_loadu_ps(a + i);
+        const auto vb = _mm_loadu_ps(b + i);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_cvtps_pd(va), _mm_cvtps_pd(vb)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(va, va)),
+                                           _mm_cvtps_pd(_mm_movehl_ps(vb, vb))));
+    }
+
+    acc0 = _mm_add_pd(acc0, acc1);
+    auto sum = _mm_cvtsd_f64(_mm_add_sd(acc0, _mm_unpackhi_pd(acc0, acc0)));
+
+    for (; i < n; ++i)
+        sum += static_cast<double>(a[i]) * static_cast<double>(b[i]);
+
+    return sum;
+}
+
+
+// p(v) / q(v) * v on two lanes, see Kernels.h
+static inline __m128d tanhLanes(__m128d v)
+{
+    using namespace TanhApprox;
+    v = _mm_min_pd(_mm_max_pd(v, _mm_set1_pd(-s_clamp)), _mm_set1_pd(s_clamp));
+    const auto v2 = _mm_mul_pd(v, v);
+
+    auto p = _mm_set1_pd(s_alpha[6]);
+    for (auto c = 6; c-- > 0;)
+        p = _mm_add_pd(_mm_mul_pd(p, v2), _mm_set1_pd(s_alpha[c]));
+
+    auto q = _mm_set1_pd(s_beta[3]);
+    for (auto c = 3; c-- > 0;)
+        q = _mm_add_pd(_mm_mul_pd(q, v2), _mm_set1_pd(s_beta[c]));
+
+    return _mm_div_pd(_mm_mul_pd(v, p), q);
+}
+
+static inline __m128 tanhLanes(__m128 v)
+{
+    using namespace TanhApprox;
+    const auto limit = static_cast<float>(s_clamp);
+    v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-limit)), _mm_set1_ps(limit));
+    const auto v2 = _mm_mul_ps(v, v);
+
+    auto p = _mm_set1_ps(static_cast<float>(s_alpha[6]));
+    for (auto c = 6; c-- > 0;)
+        p = _mm_add_ps(_mm_mul_ps(p, v2), _mm_set1_ps(static_cast<float>(s_alpha[c])));
+
+    auto q = _mm_set1_ps(static_cast<float>(s_beta[3]));
+    for (auto c = 3; c-- > 0;)
+        q = _mm_add_ps(_mm_mul_ps(q, v2), _mm_set1_ps(static_cast<float>(s_beta[c])));
+
+    return _mm_div_ps(_mm_mul_ps(v, p), q);
+}
+
+static void tanhApprox(double* x, unsigned long n, double inScale, double outScale,
+                       double offset)
+{
+    const auto vi = _mm_set1_pd(inScale);
+    const auto vo = _mm_set1_pd(outScale);
+    const auto vb = _mm_set1_pd(offset);
+
+    auto i = 0ul;
+    for (; i + 2 <= n; i += 2)
+    {
+        const auto t = tanhLanes(_mm_mul_pd(vi, _mm_loadu_pd(x + i)));
+        _mm_storeu_pd(x + i, _mm_add_pd(_mm_mul_pd(vo, t), vb));
+    }
+
+    // The odd element out goes through the same lanes
+    if (i < n)
+    {
+        const auto t = tanhLanes(_mm_mul_pd(vi, _mm_set_sd(x[i])));
+        x[i] = _mm_cvtsd_f64(_mm_add_pd(_mm_mul_pd(vo, t), vb));
+    }
+}
+
+static void tanhApproxF32(float* x, unsigned long n, float inScale, float outScale, float offset)
+{
+    const auto vi = _mm_set1_ps(inScale);
+    const auto vo = _mm_set1_ps(outScale);
+    const auto vb = _mm_set1_ps(offset);
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto t = tanhLanes(_mm_mul_ps(vi, _mm_loadu_ps(x + i)));
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_mul_ps(vo, t), vb));
+    }
+
+    for (; i < n; ++i)
+    {
+        const auto t = tanhLanes(_mm_mul_ps(vi, _mm_set_ss(x[i])));
+        x[i] = _mm_cvtss_f32(_mm_add_ps(_mm_mul_ps(vo, t), vb));
+    }
+}
+
+static void leakyRelu(double* x, double slope, unsigned long n)
+{
+    const auto vs = _mm_set1_pd(slope);
+
+    auto i = 0ul;
+    for (; i + 2 <= n; i += 2)
+    {
+        const auto v = _mm_loadu_pd(x + i);
+        _mm_storeu_pd(x + i, _mm_max_pd(v, _mm_mul_pd(vs, v)));
+    }
+
+    for (; i < n; ++i)
+        x[i] = x[i] < slope * x[i] ? slope * x[i] : x[i];
+}
+
+static void leakyReluF32(float* x, float slope, unsigned long n)
+{
+    const auto vs = _mm_set1_ps(slope);
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto v = _mm_loadu_ps(x + i);
+        _mm_storeu_ps(x + i, _mm_max_ps(v, _mm_mul_ps(vs, v)));
+    }
+
+    for (; i < n; ++i)
+        x[i] = x[i] < slope * x[i] ? slope * x[i] : x[i];
+}
+
+
+// a * b + c, SSE2 has no fused multiply-add
+static inline __m128d multiplyAdd(__m128d a, __m128d b, __m128d c)
+{
+    return _mm_add_pd(_mm_mul_pd(a, b), c);
+}
+
+static inline __m128 multiplyAdd(__m128 a, __m128 b, __m128 c)
+{
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+static void nesterovUpdate(double* weights, double* velocity, const double* x, double scale,
+                           double momentum, unsigned long n)
+{
+    const auto vs = _mm_set1_pd(scale);
+    const auto vm = _mm_set1_pd(momentum);
+
+    auto i = 0ul;
+    for (; i + 2 <= n; i += 2)
+    {
+        const auto g = _mm_mul_pd(vs, _mm_loadu_pd(x + i));
+        const auto v = multiplyAdd(vm, _mm_loadu_pd(velocity + i), g);
+        const auto delta = multiplyAdd(vm, v, g);
+        _mm_storeu_pd(velocity + i, v);
+        _mm_storeu_pd(weights + i, _mm_add_pd(_mm_loadu_pd(weights + i), delta));
+    }
+
+    for (; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        velocity[i] = momentum * velocity[i] + g;
+        weights[i] += momentum * velocity[i] + g;
+    }
+}
+
+static void rmsPropUpdate(double* weights, double* meanSquare, const double* x, double scale,
+                          double rate, double decay, double epsilon, unsigned long n)
+{
+    const auto vs = _mm_set1_pd(scale);
+    const auto vr = _mm_set1_pd(rate);
+    const auto vd = _mm_set1_pd(decay);
+    const auto vc = _mm_set1_pd(1.0 - decay);
+    const auto ve = _mm_set1_pd(epsilon);
+
+    auto i = 0ul;
+    for (; i + 2 <= n; i += 2)
+    {
+        const auto g = _mm_mul_pd(vs, _mm_loadu_pd(x + i));
+        const auto s = multiplyAdd(vd, _mm_loadu_pd(meanSquare + i),
+                                   _mm_mul_pd(vc, _mm_mul_pd(g, g)));
+        const auto delta = _mm_div_pd(_mm_mul_pd(vr, g), _mm_add_pd(_mm_sqrt_pd(s), ve));
+        _mm_storeu_pd(meanSquare + i, s);
+        _mm_storeu_pd(weights + i, _mm_add_pd(_mm_loadu_pd(weights + i), delta));
+    }
+
+    for (; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        meanSquare[i] = decay * meanSquare[i] + (1.0 - decay) * g * g;
+        weights[i] += rate * g / (__builtin_sqrt(meanSquare[i]) + epsilon);
+    }
+}
+
+static void adamUpdate(double* weights, double* mean, double* variance, const double* x,
+                       double scale, double step, double beta1, double beta2, double epsilon,
+                       unsigned long n)
+{
+    const auto vs = _mm_set1_pd(scale);
+    const auto vt = _mm_set1_pd(step);
+    const auto vb1 = _mm_set1_pd(beta1);
+    const auto vc1 = _mm_set1_pd(1.0 - beta1);
+    const auto vb2 = _mm_set1_pd(beta2);
+    const auto vc2 = _mm_set1_pd(1.0 - beta2);
+    const auto ve = _mm_set1_pd(epsilon);
+
+    auto i = 0ul;
+    for (; i + 2 <= n; i += 2)
+    {
+        const auto g = _mm_mul_pd(vs, _mm_loadu_pd(x + i));
+        const auto m = multiplyAdd(vb1, _mm_loadu_pd(mean + i), _mm_mul_pd(vc1, g));
+        const auto v = multiplyAdd(vb2, _mm_loadu_pd(variance + i),
+                                   _mm_mul_pd(vc2, _mm_mul_pd(g, g)));
+        const auto delta = _mm_div_pd(_mm_mul_pd(vt, m), _mm_add_pd(_mm_sqrt_pd(v), ve));
+        _mm_storeu_pd(mean + i, m);
+        _mm_storeu_pd(variance + i, v);
+        _mm_storeu_pd(weights + i, _mm_add_pd(_mm_loadu_pd(weights + i), delta));
+    }
+
+    for (; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        mean[i] = beta1 * mean[i] + (1.0 - beta1) * g;
+        variance[i] = beta2 * variance[i] + (1.0 - beta2) * g * g;
+        weights[i] += step * mean[i] / (__builtin_sqrt(variance[i]) + epsilon);
+    }
+}
+
+static void nesterovUpdateF32(float* weights, float* velocity, const float* x, float scale,
+                              float momentum, unsigned long n)
+{
+    const auto vs = _mm_set1_ps(scale);
+    const auto vm = _mm_set1_ps(momentum);
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto g = _mm_mul_ps(vs, _mm_loadu_ps(x + i));
+        const auto v = multiplyAdd(vm, _mm_loadu_ps(velocity + i), g);
+        const auto delta = multiplyAdd(vm, v, g);
+        _mm_storeu_ps(velocity + i, v);
+        _mm_storeu_ps(weights + i, _mm_add_ps(_mm_loadu_ps(weights + i), delta));
+    }
+
+    for (; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        velocity[i] = momentum * velocity[i] + g;
+        weights[i] += momentum * velocity[i] + g;
+    }
+}
+
+static void rmsPropUpdateF32(float* weights, float* meanSquare, const float* x, float scale,
+                             float rate, float decay, float epsilon, unsigned long n)
+{
+    const auto vs = _mm_set1_ps(scale);
+    const auto vr = _mm_set1_ps(rate);
+    const auto vd = _mm_set1_ps(decay);
+    const auto vc = _mm_set1_ps(1.0f - decay);
+    const auto ve = _mm_set1_ps(epsilon);
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto g = _mm_mul_ps(vs, _mm_loadu_ps(x + i));
+        const auto s = multiplyAdd(vd, _mm_loadu_ps(meanSquare + i),
+                                   _mm_mul_ps(vc, _mm_mul_ps(g, g)));
+        const auto delta = _mm_div_ps(_mm_mul_ps(vr, g), _mm_add_ps(_mm_sqrt_ps(s), ve));
+        _mm_storeu_ps(meanSquare + i, s);
+        _mm_storeu_ps(weights + i, _mm_add_ps(_mm_loadu_ps(weights + i), delta));
+    }
+
+    for (; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        meanSquare[i] = decay * meanSquare[i] + (1.0f - decay) * g * g;
+        weights[i] += rate * g / (__builtin_sqrtf(meanSquare[i]) + epsilon);
+    }
+}
+
+static void adamUpdateF32(float* weights, float* mean, float* variance, const float* x, float scale,
+                          float step, float beta1, float beta2, float epsilon, unsigned long n)
+{
+    const auto vs = _mm_set1_ps(scale);
+    const auto vt = _mm_set1_ps(step);
+    const auto vb1 = _mm_set1_ps(beta1);
+    const auto vc1 = _mm_set1_ps(1.0f - beta1);
+    const auto vb2 = _mm_set1_ps(beta2);
+    const auto vc2 = _mm_set1_ps(1.0f - beta2);
+    const auto ve = _mm_set1_ps(epsilon);
+
+    auto i = 0ul;
+    for (; i + 4 <= n; i += 4)
+    {
+        const auto g = _mm_mul_ps(vs, _mm_loadu_ps(x + i));
+        const auto m = multiplyAdd(vb1, _mm_loadu_ps(mean + i), _mm_mul_ps(vc1, g));
+        const auto v = multiplyAdd(vb2, _mm_loadu_ps(variance + i),
+                                   _mm_mul_ps(vc2, _mm_mul_ps(g, g)));
+        const auto delta = _mm_div_ps(_mm_mul_ps(vt, m), _mm_add_ps(_mm_sqrt_ps(v), ve));
+        _mm_storeu_ps(mean + i, m);
+        _mm_storeu_ps(variance + i, v);
+        _mm_storeu_ps(weights + i, _mm_add_ps(_mm_loadu_ps(weights + i), delta));
+    }
+
+    for (; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        mean[i] = beta1 * mean[i] + (1.0f - beta1) * g;
+        variance[i] = beta2 * variance[i] + (1.0f - beta2) * g * g;
+        weights[i] += step * mean[i] / (__builtin_sqrtf(variance[i]) + epsilon);
+    }
+}
+
+} // namespace Sse2
+
+const KernelTable& sse2Kernels()
+{
+    static const KernelTable table{Isa::SSE2,
+                                   "SSE2",
+                                   Sse2::dot,
+                                   Sse2::axpy,
+                                   Sse2::momentumUpdate,
+                                   Sse2::dotF32,
+                                   Sse2::axpyF32,
+                                   Sse2::momentumUpdateF32,
+                                   Sse2::dotF32Mixed,
+                                   Sse2::tanhApprox,
+                                   Sse2::tanhApproxF32,
+                                   Sse2::leakyRelu,
+                                   Sse2::leakyReluF32,
+                                   Sse2::nesterovUpdate,
+                                   Sse2::rmsPropUpdate,
+                                   Sse2::adamUpdate,
+                                   Sse2::nesterovUpdateF32,
+                                   Sse2::rmsPropUpdateF32,
+                                   Sse2::adamUpdateF32};
+    return table;
+}
+
+} // namespace Engine::Kernels
@@ -0,0 +1,135 @@
+// Reference kernels. These are the plain loops every vectorized variant is validated against.
+
+// clang-format off
+#include "Kernels.h"
+#include <algorithm>
+#include <cmath>
+// clang-format on
+
+namespace Engine::Kernels {
+
+namespace Reference {
+
+// Acc is the type products are summed in
+template <typename T, typename Acc = T>
+static Acc dot(const T* a, const T* b, unsigned long n)
+{
+    Acc sum = 0;
+    for (auto i = 0ul; i < n; ++i)
+        sum += static_cast<Acc>(a[i]) * static_cast<Acc>(b[i]);
+
+    return sum;
+}
+
+template <typename T>
+static void axpy(T a, const T* x, T* y, unsigned long n)
+{
+    for (auto i = 0ul; i < n; ++i)
+        y[i] += a * x[i];
+}
+
+template <typename T>
+static void momentumUpdate(T* weights, T* deltas, const T* x, T scale, T momentum,
+                           unsigned long n)
+{
+    for (auto i = 0ul; i < n; ++i)
+    {
+        deltas[i] = scale * x[i] + momentum * deltas[i];
+        weights[i] += deltas[i];
+    }
+}
+
+template <typename T>
+static void nesterovUpdate(T* weights, T* velocity, const T* x, T scale, T momentum,
+                           unsigned long n)
+{
+    for (auto i = 0ul; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        velocity[i] = momentum * velocity[i] + g;
+        weights[i] += momentum * velocity[i] + g;
+    }
+}
+
+template <typename T>
+static void rmsPropUpdate(T* weights, T* meanSquare, const T* x, T scale, T rate, T decay,
+                          T epsilon, unsigned long n)
+{
+    for (auto i = 0ul; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        meanSquare[i] = decay * meanSquare[i] + (T(1) - decay) * g * g;
+        weights[i] += rate * g / (std::sqrt(meanSquare[i]) + epsilon);
+    }
+}
+
+template <typename T>
+static void adamUpdate(T* weights, T* mean, T* variance, const T* x, T scale, T step, T beta1,
+                       T beta2, T epsilon, unsigned long n)
+{
+    for (auto i = 0ul; i < n; ++i)
+    {
+        const auto g = scale * x[i];
+        mean[i] = beta1 * mean[i] + (T(1) - beta1) * g;
+        variance[i] = beta2 * variance[i] + (T(1) - beta2) * g * g;
+        weights[i] += step * mean[i] / (std::sqrt(variance[i]) + epsilon);
+    }
+}
+
+template <typename T>
+static void tanhApprox(T* x, unsigned long n, T inScale, T outScale, T offset)
+{
+    using namespace TanhApprox;
+    const auto limit = static_cast<T>(s_clamp);
+
+    for (auto i = 0ul; i < n; ++i)
+    {
+        const auto v = std::clamp(inScale * x[i], -limit, limit);
+        const auto v2 = v * v;
+
+        auto p = static_cast<T>(s_alpha[6]);
+        for (auto c = 6; c-- > 0;)
+            p = p * v2 + static_cast<T>(s_alpha[c]);
+
+        auto q = static_cast<T>(s_beta[3]);
+        for (auto c = 3; c-- > 0;)
+            q = q * v2 + static_cast<T>(s_beta[c]);
+
+        x[i] = outScale * (v * p / q) + offset;
+    }
+}
+
+template <typename T>
+static void leakyRelu(T* x, T slope, unsigned long n)
+{
+    for (auto i = 0ul; i < n; ++i)
+        x[i] = std::max(x[i], slope * x[i]);
+}
+
+} // namespace Reference
+
+const KernelTable& scalarKernels()
+{
+    static const KernelTable table{Isa::Scalar,
+                                   "Scalar",
+                                   Reference::dot<double>,
+                                   Reference::axpy<double>,
+                                   Reference::momentumUpdate<double>,
+                                   Reference::dot<float>,
+                                   Reference::axpy<float>,
+                                   Reference::momentumUpdate<float>,
+                                   Reference::dot<float, double>,
+                                   Reference::tanhApprox<double>,
+                                   Reference::tanhApprox<float>,
+                                   Reference::leakyRelu<double>,
+                                   Reference::leakyRelu<float>,
+                                   Reference::nesterovUpdate<double>,
+                                   Reference::rmsPropUpdate<double>,
+                                   Reference::adamUpdate<double>,
+                                   Reference::nesterovUpdate<float>,
+                                   Reference::rmsPropUpdate<float>,
+                                   Reference::adamUpdate<float>};
+    return table;
+}
+
+} // namespace Engine::Kernels
@@ -1,14 +1,65 @@
 // clang-format off
 #include "ImGuiLayer.h"
 #include "../Application.h"
+#include "../FrameStats.h"
 #include <imgui.h>
 #include <backends/imgui_impl_opengl3.h>
 #include <backends/imgui_impl_glfw.h>
+#include <algorithm>
 #include <filesystem>
 // clang-format on
 
 namespace Engine {
 
+static const ImVec4 s_updateColor{0.35f, 0.6f, 1.0f, 1.0f};
+static const ImVec4 s_renderColor{0.4f, 0.85f, 0.4f, 1.0f};
+static const ImVec4 s_swapColor{1.0f, 0.6f, 0.2f, 1.0f};
+static const ImVec4 s_eventsColor{0.85f, 0.4f, 0.85f, 1.0f};
+static const ImVec4 s_unaccountedColor{0.6f, 0.6f, 0.6f, 1.0f};
+
+// One column per frame, the newest on the right. The phases are stacked from the bottom, with
+// whatever the frame spent outside them on top.
+static void drawFrameGraph(const FrameStats& stats, double scaleMilliseconds)
+{
+    constexpr auto width = 300.0f;
+    constexpr auto height = 80.0f;
+    const auto origin = ImGui::GetCursorScreenPos();
+    const auto bottom = origin.y + height;
+    auto* drawList = ImGui::GetWindowDrawList();
+    drawList->AddRectFilled(origin, ImVec2(origin.x + width, bottom), IM_COL32(0, 0, 0, 96));
+
+    const auto columns = std::min(stats.size(), static_cast<unsigned long>(width));
+    const auto first = stats.size() - columns;
+    for (auto i = 0ul; i < columns; ++i)
+    {
+        const auto& timing = stats.at(first + i);
+        const auto x = origin.x + width - static_cast<float>(columns - i);
+        auto top = bottom;
+        auto stack = [&](double seconds, const ImVec4& color) {
+            const auto fraction = std::max(seconds * 1000.0 / scaleMilliseconds, 0.0);
+            const auto next = std::max(top - static_cast<float>(fraction) * height, origin.y);
+            drawList->AddRectFilled(ImVec2(x, next), ImVec2(x + 1.0f, top),
+                                    ImGui::ColorConvertFloat4ToU32(color));
+            top = next;
+        };
+
+        stack(timing.update, s_updateColor);
+        stack(timing.render, s_renderColor);
+        stack(timing.swap, s_swapColor);
+        stack(timing.events, s_eventsColor);
+        stack(timing.frame - timing.update - timing.render - timing.swap - timing.events,
+              s_unaccountedColor);
+    }
+
+    // 60 FPS
+    const auto target = bottom - static_cast<float>(1000.0 / 60.0 / scaleMilliseconds) * height;
+    if (target > origin.y)
+        drawList->AddLine(ImVec2(origin.x, target), ImVec2(origin.x + width, target),
+                          IM_COL32(255, 255, 255, 96));
+
+    ImGui::Dummy(ImVec2(width, height));
+}
+
 void ImGuiLayer::onAttach()
 {
     IMGUI_CHECKVERSION();
@@ -49,6 +100,7 @@ void ImGuiLayer::runImGui()
 
 void ImGuiLayer::onUpdate(double frameTime)
 {
+    (void)frameTime;
     auto& app = Application::instance();
     static auto dockFlags = ImGuiDockNodeFlags_PassthruCentralNode;
 
@@ -56,7 +108,7 @@ void ImGuiLayer::onUpdate(double frameTime)
 
     // ImGui::ShowDemoWindow();
 
-    showStats(frameTime);
+    showStats(app.frameStats());
 
     if (ImGui::BeginMainMenuBar())
     {
@@ -94,7 +146,7 @@ void ImGuiLayer::onDetach()
     ImGui::DestroyContext();
 }
 
-void ImGuiLayer::showStats(double frameTime)
+void ImGuiLayer::showStats(const FrameStats& stats)
 {
     static auto corner = 0;
     // ImGuiIO& io = ImGui::GetIO();
@@ -121,13 +173,36 @@ void ImGuiLayer::showStats(double frameTime)
         window_flags |= ImGuiWindowFlags_NoMove;
     }
 
-    if (ImGui::Begin("Stats", nullptr, window_flags))
+    // End() is called whether or not Begin() returned true
+    if (ImGui::Begin("Stats", nullptr, window_flags) && stats.size() > 0)
     {
-        ImGui::Text("FPS: %f", frameTime * 3600);
-        // ImGui::Separator();
-
-        ImGui::End();
+        const auto summary = stats.summary();
+        const auto& last = stats.last();
+        const auto& average = summary.average;
+
+        ImGui::Text("Frame %.2f ms (%.0f FPS)", last.frame * 1000.0, 1.0 / last.frame);
+        ImGui::Text("Average %.1f FPS, p99 %.2f ms", summary.averageFps,
+                    summary.p99Milliseconds);
+        ImGui::Text("1%% low %.1f FPS, 0.1%% low %.1f FPS", summary.low1Fps, summary.low01Fps);
+        ImGui::Text("Over the last %lu frames", summary.frames);
+        ImGui::Separator();
+
+        ImGui::TextColored(s_updateColor, "Update %.2f", average.update * 1000.0);
+        ImGui::SameLine();
+        ImGui::TextColored(s_renderColor, "Render %.2f", average.render * 1000.0);
+        ImGui::SameLine();
+        ImGui::TextColored(s_swapColor, "Swap %.2f", average.swap * 1000.0);
+        ImGui::SameLine();
+        ImGui::TextColored(s_eventsColor, "Events %.2f", average.events * 1000.0);
+        ImGui::SameLine();
+        ImGui::TextColored(s_unaccountedColor, "Unaccounted ms");
+
+        // Scaled to the slow frames, so a hitch is tall but does not flatten everything else
+        const auto scale = std::max(summary.p99Milliseconds * 1.5, 20.0);
+        drawFrameGraph(stats, scale);
+        ImGui::Text("0 - %.0f ms, line at 60 FPS", scale);
     }
+    ImGui::End();
 }
 
 } // namespace Engine
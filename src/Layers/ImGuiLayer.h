@@ -4,6 +4,8 @@
 
 namespace Engine {
 
+class FrameStats;
+
 class ImGuiLayer : public Layer
 {
 public:
@@ -12,9 +14,10 @@ public:
     void onUpdate(double frameTime) override;
     void endImGui();
     void onDetach() override;
+    inline const char* name() const override { return "ImGui layer"; }
 
 private:
-    void showStats(double frameTime);
+    void showStats(const FrameStats& stats);
 };
 
 } // namespace Engine
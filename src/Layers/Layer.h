@@ -12,6 +12,7 @@ public:
     virtual void onAttach() = 0;
     virtual void onUpdate(double frameTime) = 0;
     virtual void onDetach() = 0;
+    virtual const char* name() const = 0; // for profiling, lives as long as the layer
     inline bool isEnabled() const { return m_enabled; }
     inline void toggle(bool active) { m_enabled = active; }
 
@@ -10,11 +10,7 @@ LayerStack::LayerStack()
 {
 }
 
-LayerStack::~LayerStack()
-{
-    for (auto* l : m_layers)
-        l->onDetach();
-}
+LayerStack::~LayerStack() { clear(); }
 
 void LayerStack::pushLayer(Layer* layer)
 {
@@ -47,4 +43,15 @@ void LayerStack::popOverlay(Layer* overlay)
     }
 }
 
+void LayerStack::clear()
+{
+    for (auto* l : m_layers)
+        l->onDetach();
+    for (auto* l : m_layers)
+        delete l;
+
+    m_layers.clear();
+    m_insertionItr = m_layers.begin();
+}
+
 } // namespace Engine
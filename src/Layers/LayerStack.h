@@ -14,11 +14,15 @@ public:
     ~LayerStack();
 
 public:
+    // Pushed layers are owned by the stack until they are popped
     void pushLayer(Layer* layer);
     void popLayer(Layer* layer);
     void pushOverlay(Layer* overlay);
     void popOverlay(Layer* overlay);
 
+    // Detaches and deletes every layer, joining the threads they own
+    void clear();
+
     inline std::vector<Layer*>::iterator begin() { return m_layers.begin(); }
     inline std::vector<Layer*>::iterator end() { return m_layers.end(); }
 
@@ -11,6 +11,7 @@ public:
     void onAttach() override;
     void onUpdate(double frameTime) override;
     void onDetach() override;
+    inline const char* name() const override { return "Main layer"; }
 
 private:
     ImVec4 m_clearColor{0.1f, 0.2f, 0.3f, 1.0f};
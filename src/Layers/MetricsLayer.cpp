@@ -0,0 +1,91 @@
+// clang-format off
+#include "MetricsLayer.h"
+#include <imgui.h>
+#include <cfloat>
+#include <cstdio>
+#include <string>
+// clang-format on
+
+namespace Engine {
+
+// Each bucket is drawn as its minimum followed by its maximum, so the line traces the envelope
+static float envelope(void* data, int index)
+{
+    const auto* series = static_cast<const TimeSeries*>(data);
+    const auto bucket = static_cast<unsigned long>(index / 2);
+
+    return index % 2 ? series->max(bucket) : series->min(bucket);
+}
+
+static void plot(const char* label, TimeSeries& series, const char* unit)
+{
+    char overlay[64];
+    std::snprintf(overlay, sizeof(overlay), "%.6g %s", series.last(), unit);
+
+    ImGui::PlotLines(label, envelope, &series, static_cast<int>(series.size() * 2), 0, overlay,
+                     FLT_MAX, FLT_MAX, ImVec2(0.0f, 80.0f));
+}
+
+MetricsLayer::MetricsLayer(MetricsChannel& channel)
+    : Layer()
+    , m_channel(channel)
+{
+}
+
+void MetricsLayer::onAttach() {}
+
+void MetricsLayer::onUpdate(double frameTime)
+{
+    (void)frameTime;
+
+    MetricSample sample;
+    while (m_channel.tryPop(sample))
+    {
+        m_error.add(sample.error);
+        m_recentAvgError.add(sample.recentAvgError);
+        m_samplesPerSecond.add(sample.samplesPerSecond);
+
+        m_shells = sample.shells;
+        for (auto l = 0ul; l < m_shells; ++l)
+            m_shellTimes[l].add(sample.shellMicroseconds[l]);
+
+        ++m_samples;
+    }
+
+    ImGui::Begin("Metrics");
+    {
+        if (ImGui::Button("Clear"))
+            clear();
+
+        ImGui::SameLine();
+        ImGui::Text("%lu samples, %lu per point, %lu dropped", m_samples,
+                    m_error.samplesPerBucket(), m_channel.dropped());
+
+        plot("Error", m_error, "");
+        plot("Recent avg. error", m_recentAvgError, "");
+        plot("Throughput", m_samplesPerSecond, "samples/s");
+
+        // The input shell does no work of its own
+        for (auto l = 1ul; l < m_shells; ++l)
+        {
+            const auto label = "Shell " + std::to_string(l);
+            plot(label.c_str(), m_shellTimes[l], "us/sample");
+        }
+    }
+    ImGui::End();
+}
+
+void MetricsLayer::onDetach() {}
+
+void MetricsLayer::clear()
+{
+    m_error.clear();
+    m_recentAvgError.clear();
+    m_samplesPerSecond.clear();
+    for (auto& series : m_shellTimes)
+        series.clear();
+
+    m_samples = 0;
+}
+
+} // namespace Engine
@@ -0,0 +1,37 @@
+#pragma once
+
+// clang-format off
+#include "Layer.h"
+#include "../Metrics.h"
+#include <array>
+// clang-format on
+
+namespace Engine {
+
+// Plots the metrics a training job sends through a channel. The layer is the channel's only
+// consumer and drains it once per frame.
+class MetricsLayer : public Layer
+{
+public:
+    explicit MetricsLayer(MetricsChannel& channel);
+
+public:
+    void onAttach() override;
+    void onUpdate(double frameTime) override;
+    void onDetach() override;
+    inline const char* name() const override { return "Metrics layer"; }
+
+private:
+    void clear();
+
+private:
+    MetricsChannel& m_channel;
+    TimeSeries m_error;
+    TimeSeries m_recentAvgError;
+    TimeSeries m_samplesPerSecond;
+    std::array<TimeSeries, MetricSample::s_maxShells> m_shellTimes;
+    unsigned long m_shells = 0;
+    unsigned long m_samples = 0;
+};
+
+} // namespace Engine
@@ -1,22 +1,48 @@
 // clang-format off
 #include "NetworkLayer.h"
 #include <imgui.h>
-#include <sstream>
+#include <algorithm>
+#include <array>
+#include <cstdio>
 #include <string>
 // clang-format on
 
 namespace Engine {
 
-static std::string vecToStr(const std::string& label, const std::vector<double>& v)
+// Epoch summaries and errors kept above the pass log
+static constexpr unsigned long s_maxMessages = 64;
+
+// Combo box labels, in the order of the Activation enum
+static const auto s_activationNames = [] {
+    std::array<const char*, s_activations.size()> names{};
+    for (auto i = 0ul; i < names.size(); ++i)
+        names[i] = activationName(s_activations[i]);
+    return names;
+}();
+
+// Combo box labels, in the order of OptimizerType
+static const std::array<const char*, 4> s_optimizerNames{
+    optimizerName(OptimizerType::Momentum), optimizerName(OptimizerType::Nesterov),
+    optimizerName(OptimizerType::RmsProp), optimizerName(OptimizerType::Adam)};
+
+// Writes the values space separated into a fixed buffer, truncating what does not fit
+static const char* formatValues(std::span<const double> values, char* buffer, unsigned long size)
 {
-    std::stringstream ss;
-    ss << label << " ";
-    for (unsigned i = 0; i < v.size(); ++i)
-        ss << v[i] << " ";
+    auto used = 0ul;
+    buffer[0] = '\0';
+    for (auto value : values)
+    {
+        if (used >= size)
+            break;
+
+        const auto written = std::snprintf(buffer + used, size - used, "%g ", value);
+        if (written < 0)
+            break;
 
-    ss << '\n';
+        used += static_cast<unsigned long>(written);
+    }
 
-    return ss.str();
+    return buffer;
 }
 
 NetworkLayer::NetworkLayer()
@@ -28,67 +54,196 @@ NetworkLayer::NetworkLayer()
 void NetworkLayer::onAttach()
 {
     m_net = new Network({2, 4, 1});
+
+    m_data = std::make_unique<IndexedDataset>(m_td, m_net->topology().front(),
+                                              m_net->topology().back());
+    auto [train, validation] = m_data->split(0.1);
+    m_trainSet = std::make_unique<IndexedDataset::Subset>(std::move(train));
+    m_validationSet = std::make_unique<IndexedDataset::Subset>(std::move(validation));
+
+    m_log = std::make_unique<TrainingLog>(m_net->topology().front(), m_net->topology().back());
+    m_logReader = std::make_unique<TrainingLog::Reader>(*m_log);
+}
+
+void NetworkLayer::addMessage(std::string message)
+{
+    if (m_messages.size() == s_maxMessages)
+        m_messages.pop_front();
+
+    m_messages.push_back(std::move(message));
 }
 
 void NetworkLayer::onUpdate(double frameTime)
 {
     (void)frameTime;
-    int trainingPass = 0;
-    static std::vector<std::string> text;
 
     ImGui::Begin("Network");
     {
-        if (ImGui::Button("Train"))
+        // Training runs on the job's thread, the UI only ever looks at its progress snapshot
+        const auto progress = m_job.progress();
+        const auto active = progress.state == TrainingJob::State::Running ||
+                            progress.state == TrainingJob::State::Paused;
+
+        if (progress.epoch > m_jobEpochs)
         {
-            while (!m_td.isEof())
-            {
-                if (m_td.getNextInputs(m_net->m_inputVals) != m_net->topology()[0])
-                    break;
+            m_jobEpochs = progress.epoch;
+            addMessage("Epoch " + std::to_string(m_epoch + m_jobEpochs - 1) +
+                       " validation error: " + std::to_string(progress.validationError));
+        }
 
-                text.emplace_back(std::string("Pass: " + std::to_string(trainingPass)));
+        if (!active)
+        {
+            if (m_jobStarted)
+            {
+                // Later clicks continue with the next epoch's shuffle
+                m_epoch += progress.epoch;
+                m_jobStarted = false;
+            }
 
-                // Get new input data and feed it forward:
-                text.emplace_back(vecToStr("Inputs:", m_net->m_inputVals));
-                m_net->forward(m_net->m_inputVals);
+            // Activations only change between jobs. Softmax is offered for the output shell only.
+            for (auto l = 1ul; l < m_net->topology().size(); ++l)
+            {
+                const auto output = l + 1 == m_net->topology().size();
+                const auto choices = static_cast<int>(s_activations.size()) - (output ? 0 : 1);
+                auto current = static_cast<int>(m_net->activation(l));
 
-                // Collect the net's actual output results:
-                text.emplace_back(vecToStr("Outputs:", m_net->results()));
+                char label[32];
+                std::snprintf(label, sizeof(label), "Shell %lu activation", l);
+                if (ImGui::Combo(label, &current, s_activationNames.data(), choices))
+                    m_net->setActivation(l, static_cast<Activation>(current));
+            }
 
-                // Train the net what the outputs should have been:
-                m_td.getTargetOutputs(m_net->m_targetVals);
-                text.emplace_back(vecToStr("Targets:", m_net->m_targetVals));
-                assert(m_net->m_targetVals.size() == m_net->topology().back());
+            auto options = m_net->optimizer().options();
+            auto optimizer = static_cast<int>(options.type);
+            if (ImGui::Combo("Optimizer", &optimizer, s_optimizerNames.data(),
+                             static_cast<int>(s_optimizerNames.size())))
+            {
+                options.type = static_cast<OptimizerType>(optimizer);
+                options.learningRate = defaultLearningRate(options.type);
+                m_net->setOptimizer(options);
+            }
 
-                m_net->backward(m_net->m_targetVals);
+            auto rate = static_cast<float>(options.learningRate);
+            if (ImGui::SliderFloat("Learning rate", &rate, 0.0001f, 0.5f, "%.4f"))
+            {
+                options.learningRate = static_cast<double>(rate);
+                m_net->setOptimizer(options);
+            }
 
-                // Report how well the training is working, average over recent samples:
-                text.emplace_back(std::string("Net recenet avg. error: " +
-                                              std::to_string(m_net->m_recentAvgError)));
+            if (ImGui::Button("Train"))
+            {
+                if (m_data->hasError())
+                    addMessage("Training data error: " + m_data->error());
 
-                ++trainingPass;
+                TrainingJob::Options options;
+                options.firstEpoch = m_epoch;
+                options.log = m_log.get();
+                options.metrics = &m_metrics;
+                options.checkpoints = &m_checkpoints;
+                m_jobStarted = m_job.start(*m_net, *m_trainSet, m_validationSet.get(), options);
+                m_jobEpochs = 0;
             }
         }
+        else
+        {
+            if (progress.state == TrainingJob::State::Paused ? ImGui::Button("Resume")
+                                                              : ImGui::Button("Pause"))
+            {
+                if (progress.state == TrainingJob::State::Paused)
+                    m_job.resume();
+                else
+                    m_job.pause();
+            }
+
+            ImGui::SameLine();
+            if (ImGui::Button("Cancel"))
+                m_job.cancel();
+        }
+
+        ImGui::Text("%s: %lu passes, %.0f samples/s", TrainingJob::stateName(progress.state),
+                    progress.passes, progress.samplesPerSecond);
+        ImGui::Text("Net recent avg. error: %f", progress.recentAvgError);
+        ImGui::Separator();
+
+        int interval = static_cast<int>(m_log->interval());
+        if (ImGui::InputInt("Log every n-th pass", &interval))
+            m_log->setInterval(static_cast<unsigned long>(std::max(interval, 1)));
 
-        int count = 0;
-        for (const auto& i : text)
+        for (const auto& message : m_messages)
+            ImGui::TextUnformatted(message.c_str());
+        ImGui::Separator();
+
+        // Only the rows in view are read back and formatted, however many passes were logged
+        ImGui::BeginChild("Passes");
         {
-            ImGui::Text("%s", i.c_str());
+            const auto first = m_log->first();
+            const auto rows = m_log->end() - first;
+            const auto following = ImGui::GetScrollY() >= ImGui::GetScrollMaxY();
+
+            char inputs[128];
+            char outputs[128];
+            char targets[128];
+            TrainingLog::Record record;
+
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(rows));
+            while (clipper.Step())
+            {
+                for (auto row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                {
+                    // Rows the writer has overwritten since first() was taken are skipped
+                    if (!m_logReader->read(first + static_cast<unsigned long>(row), record))
+                    {
+                        ImGui::TextUnformatted("...");
+                        continue;
+                    }
+
+                    ImGui::Text("Pass: %lu  Inputs: %s Outputs: %s Targets: %s Error: %f  "
+                                "Net recent avg. error: %f",
+                                record.pass, formatValues(record.inputs, inputs, sizeof(inputs)),
+                                formatValues(record.outputs, outputs, sizeof(outputs)),
+                                formatValues(record.targets, targets, sizeof(targets)),
+                                record.error, record.recentAvgError);
+                }
+            }
+            clipper.End();
 
-            ++count;
-            if (count % 5 == 0)
-                ImGui::Separator();
+            // Stay at the newest pass unless the user scrolled up to look at older ones
+            if (following)
+                ImGui::SetScrollHereY(1.0f);
         }
+        ImGui::EndChild();
     }
     ImGui::End();
 
     if (ImGui::BeginMainMenuBar())
     {
-        if (ImGui::BeginMenu("Export"))
+        // The network is the job's while it runs, checkpoints are only taken and restored between
+        // jobs from here
+        if (ImGui::BeginMenu("Checkpoint"))
         {
-            if (ImGui::MenuItem("Results"))
+            const auto idle = !m_job.isActive();
+            if (ImGui::MenuItem("Save", nullptr, false, idle))
             {
-                // TODO this needs to get the results from net directly, once that class has a
-                // better way of storing its output values Removing implementation for now
+                const auto progress = m_job.progress();
+                m_checkpoints.save(*m_net, {m_epoch, progress.passes, progress.recentAvgError});
+                addMessage("Saving checkpoint " + m_checkpoints.path());
+            }
+
+            if (ImGui::MenuItem("Load", nullptr, false, idle))
+            {
+                m_checkpoints.wait();
+                const Checkpoint checkpoint(m_checkpoints.path());
+                if (checkpoint.isOpen() && checkpoint.restore(*m_net))
+                {
+                    m_epoch = checkpoint.cursor().epoch;
+                    addMessage("Loaded checkpoint " + m_checkpoints.path() + " at epoch " +
+                               std::to_string(m_epoch));
+                }
+                else
+                {
+                    addMessage("Could not load checkpoint " + m_checkpoints.path());
+                }
             }
 
             ImGui::EndMenu();
@@ -100,6 +255,13 @@ void NetworkLayer::onUpdate(double frameTime)
 
 void NetworkLayer::onDetach()
 {
+    m_job.cancel();
+    m_logReader.reset();
+    m_log.reset();
+    m_trainSet.reset();
+    m_validationSet.reset();
+    m_data.reset();
+
     delete m_net;
     m_net = nullptr;
 }
@@ -2,7 +2,15 @@
 
 // clang-format off
 #include "Layer.h"
+#include "../Checkpoint.h"
+#include "../IndexedDataset.h"
 #include "../Network.h"
+#include "../TrainingData.h"
+#include "../TrainingJob.h"
+#include "../TrainingLog.h"
+#include <deque>
+#include <memory>
+#include <string>
 // clang-format on
 
 namespace Engine {
@@ -16,10 +24,37 @@ public:
     void onAttach() override;
     void onUpdate(double frameTime) override;
     void onDetach() override;
+    inline const char* name() const override { return "Network layer"; }
+
+    // Metrics of the training job, drained by a MetricsLayer
+    inline MetricsChannel& metrics() { return m_metrics; }
+
+private:
+    void addMessage(std::string message);
 
 private:
     TrainingData m_td;
     Network* m_net = nullptr;
+
+    // data.dat is parsed once, every Train click runs another epoch over the training split
+    std::unique_ptr<IndexedDataset> m_data;
+    std::unique_ptr<IndexedDataset::Subset> m_trainSet;
+    std::unique_ptr<IndexedDataset::Subset> m_validationSet;
+    unsigned long m_epoch = 0;
+
+    // Saved every minute while training and once a job ends, declared before the job it serves
+    CheckpointWriter m_checkpoints{"network.ckpt"};
+
+    TrainingJob m_job;
+    bool m_jobStarted = false;
+    unsigned long m_jobEpochs = 0; // epochs of the running job already logged
+
+    // Passes are logged by the job into a fixed ring and only formatted when on screen
+    std::unique_ptr<TrainingLog> m_log;
+    std::unique_ptr<TrainingLog::Reader> m_logReader;
+    std::deque<std::string> m_messages;
+
+    MetricsChannel m_metrics;
 };
 
 } // namespace Engine
@@ -1,19 +1,72 @@
+// clang-format off
 #include "Logging.h"
+#include <spdlog/async.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+// clang-format on
 
 namespace Engine {
 
 std::shared_ptr<spdlog::logger> Logger::s_engineLogger;
 
-void Logger::init()
+void Logger::init(const LoggerOptions& options)
 {
-    #ifdef DEBUG_BUILD
+#if ENGINE_LOG_LEVEL < SPDLOG_LEVEL_OFF
     if (!s_engineLogger)
     {
-        s_engineLogger = spdlog::stdout_color_mt("Engine");
+        // One writer thread keeps the messages in order
+        spdlog::init_thread_pool(options.queueSize, 1);
+        const auto policy = options.overflow == LogOverflow::Block
+                                ? spdlog::async_overflow_policy::block
+                                : spdlog::async_overflow_policy::overrun_oldest;
+
+        s_engineLogger = std::make_shared<spdlog::async_logger>(
+            "Engine", std::make_shared<spdlog::sinks::stdout_color_sink_mt>(),
+            spdlog::thread_pool(), policy);
+        s_engineLogger->set_level(static_cast<spdlog::level::level_enum>(ENGINE_LOG_LEVEL));
         s_engineLogger->info("Logger initialized");
     }
-    #endif
+#else
+    (void)options;
+#endif
 }
 
+void Logger::shutdown()
+{
+    s_engineLogger.reset();
+    spdlog::shutdown();
 }
+
+unsigned long Logger::dropped()
+{
+    const auto pool = spdlog::thread_pool();
+    return pool ? pool->overrun_counter() : 0;
+}
+
+long LogRateLimit::allow()
+{
+    constexpr std::int64_t interval = 1'000'000'000 / s_perSecond;
+    const std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now().time_since_epoch())
+                                 .count();
+
+    // A message is due one interval after the previous one, and may come early by up to the
+    // burst
+    auto due = m_due.load(std::memory_order_relaxed);
+    while (true)
+    {
+        const auto next = std::max(due, now) + interval;
+        if (next - now > s_burst * interval)
+        {
+            m_suppressed.fetch_add(1, std::memory_order_relaxed);
+            return -1;
+        }
+
+        if (m_due.compare_exchange_weak(due, next, std::memory_order_relaxed))
+            return m_suppressed.exchange(0, std::memory_order_relaxed);
+    }
+}
+
+} // namespace Engine
@@ -1,35 +1,121 @@
+/* Engine logging. Messages are formatted on the calling thread and written by a background
+ * thread, so a call does not wait for console I/O. The queue between them is bounded: when it is
+ * full a call either blocks until there is room or the oldest queued message is dropped.
+ *
+ * Each call site is rate limited on its own, a burst of messages is let through and then a few
+ * per second. What a call site suppressed is reported with its next message.
+ *
+ * Levels below ENGINE_LOG_LEVEL (an SPDLOG_LEVEL_* value) compile to nothing, arguments
+ * included. It defaults to info in debug builds and to off otherwise. */
 #pragma once
 
 // clang-format off
 #include <spdlog/logger.h>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <utility>
 // clang-format on
 
 namespace Engine {
 
+enum class LogOverflow { Block, DropOldest };
+
+struct LoggerOptions
+{
+    unsigned long queueSize = 8192; // messages
+    LogOverflow overflow = LogOverflow::DropOldest;
+};
+
 class Logger
 {
 private:
     Logger() = default;
 
 public:
-    static void init();
+    static void init(const LoggerOptions& options = {});
+    // Writes out whatever is still queued and stops the background thread. Every thread that
+    // logs has to be stopped first, the logger is reset without synchronizing with them.
+    static void shutdown();
+    // Messages dropped because the queue was full
+    static unsigned long dropped();
 
 public:
     static inline std::shared_ptr<spdlog::logger>& engine() { return s_engineLogger; }
 
+    template <typename... Args>
+    static void log(spdlog::level::level_enum level, long suppressed,
+                    spdlog::format_string_t<Args...> format, Args&&... args)
+    {
+        if (!s_engineLogger)
+            return;
+
+        s_engineLogger->log(level, format, std::forward<Args>(args)...);
+        if (suppressed > 0)
+            s_engineLogger->log(level, "({} more from the same call site were suppressed)",
+                                suppressed);
+    }
+
 private:
     static std::shared_ptr<spdlog::logger> s_engineLogger;
 };
 
+// Generic cell rate algorithm: a call site may log s_burst messages at once and s_perSecond
+// after that, without a lock
+class LogRateLimit
+{
+public:
+    static constexpr std::int64_t s_perSecond = 10;
+    static constexpr std::int64_t s_burst = 20;
+
+    // The number of messages suppressed since the last one let through, -1 if this one is
+    // suppressed too
+    long allow();
+
+private:
+    std::atomic<std::int64_t> m_due = 0; // nanoseconds
+    std::atomic<long> m_suppressed = 0;
+};
+
 } // namespace Engine
 
+#ifndef ENGINE_LOG_LEVEL
 #ifdef DEBUG_BUILD
-#define ENGINE_INFO(...) Engine::Logger::engine()->info(__VA_ARGS__)
-#define ENGINE_WARN(...) Engine::Logger::engine()->warn(__VA_ARGS__)
-#define ENGINE_ERROR(...) Engine::Logger::engine()->error(__VA_ARGS__)
+#define ENGINE_LOG_LEVEL SPDLOG_LEVEL_INFO
+#else
+#define ENGINE_LOG_LEVEL SPDLOG_LEVEL_OFF
+#endif
+#endif
+
+#define ENGINE_LOG(level, ...)                                                   \
+    do                                                                           \
+    {                                                                            \
+        static Engine::LogRateLimit engineLogRateLimit;                          \
+        if (const auto engineLogSuppressed = engineLogRateLimit.allow();         \
+            engineLogSuppressed >= 0)                                            \
+            Engine::Logger::log(level, engineLogSuppressed, __VA_ARGS__);        \
+    } while (false)
+
+#if ENGINE_LOG_LEVEL <= SPDLOG_LEVEL_DEBUG
+#define ENGINE_DEBUG(...) ENGINE_LOG(spdlog::level::debug, __VA_ARGS__)
+#else
+#define ENGINE_DEBUG(...) (void)0
+#endif
+
+#if ENGINE_LOG_LEVEL <= SPDLOG_LEVEL_INFO
+#define ENGINE_INFO(...) ENGINE_LOG(spdlog::level::info, __VA_ARGS__)
+#else
+#define ENGINE_INFO(...) (void)0
+#endif
+
+#if ENGINE_LOG_LEVEL <= SPDLOG_LEVEL_WARN
+#define ENGINE_WARN(...) ENGINE_LOG(spdlog::level::warn, __VA_ARGS__)
+#else
+#define ENGINE_WARN(...) (void)0
+#endif
+
+#if ENGINE_LOG_LEVEL <= SPDLOG_LEVEL_ERROR
+#define ENGINE_ERROR(...) ENGINE_LOG(spdlog::level::err, __VA_ARGS__)
 #else
-#define ENGINE_INFO(...)
-#define ENGINE_WARN(...)
-#define ENGINE_ERROR(...)
+#define ENGINE_ERROR(...) (void)0
 #endif
@@ -10,5 +10,6 @@ int main()
     auto& app = Engine::Application::instance();
     app.run();
 
+    Engine::Logger::shutdown();
     return 0;
 }
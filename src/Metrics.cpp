@@ -0,0 +1,59 @@
+// clang-format off
+#include "Metrics.h"
+#include <algorithm>
+#include <cassert>
+// clang-format on
+
+namespace Engine {
+
+TimeSeries::TimeSeries(unsigned long buckets)
+    : m_buckets(buckets)
+{
+    assert(buckets >= 2 && buckets % 2 == 0);
+
+    m_min.reserve(buckets);
+    m_max.reserve(buckets);
+}
+
+void TimeSeries::add(double value)
+{
+    m_last = value;
+    const auto sample = static_cast<float>(value);
+
+    if (!m_min.empty() && m_inLastBucket < m_perBucket)
+    {
+        m_min.back() = std::min(m_min.back(), sample);
+        m_max.back() = std::max(m_max.back(), sample);
+        ++m_inLastBucket;
+        return;
+    }
+
+    if (m_min.size() == m_buckets)
+    {
+        // Halve the resolution: bucket i takes over buckets 2i and 2i + 1
+        for (auto i = 0ul; i < m_buckets / 2; ++i)
+        {
+            m_min[i] = std::min(m_min[2 * i], m_min[2 * i + 1]);
+            m_max[i] = std::max(m_max[2 * i], m_max[2 * i + 1]);
+        }
+
+        m_min.resize(m_buckets / 2);
+        m_max.resize(m_buckets / 2);
+        m_perBucket *= 2;
+    }
+
+    m_min.push_back(sample);
+    m_max.push_back(sample);
+    m_inLastBucket = 1;
+}
+
+void TimeSeries::clear()
+{
+    m_min.clear();
+    m_max.clear();
+    m_perBucket = 1;
+    m_inLastBucket = 0;
+    m_last = 0.0;
+}
+
+} // namespace Engine
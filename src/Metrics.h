@@ -0,0 +1,56 @@
+/* Training metrics. The trainer pushes one MetricSample at a time into a MetricsChannel, which
+ * never blocks it, and a viewer drains the channel into TimeSeries for plotting. A TimeSeries
+ * keeps a fixed number of min/max buckets: when they are all used, neighbouring buckets are
+ * merged and every bucket covers twice as many samples, so a series of any length costs the
+ * same memory and the same time to draw, and short spikes still show in the envelope. */
+#pragma once
+
+// clang-format off
+#include "SpscQueue.h"
+#include <array>
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+struct MetricSample
+{
+    static constexpr unsigned long s_maxShells = 8;
+
+    double seconds = 0.0; // since the job started
+    double error = 0.0;
+    double recentAvgError = 0.0;
+    double samplesPerSecond = 0.0; // since the previous sample
+
+    // Wall time per trained sample spent in each shell, the input shell included as 0
+    unsigned long shells = 0;
+    std::array<double, s_maxShells> shellMicroseconds{};
+};
+
+using MetricsChannel = SpscQueue<MetricSample, 1024>;
+
+class TimeSeries
+{
+public:
+    explicit TimeSeries(unsigned long buckets = 256);
+
+public:
+    void add(double value);
+    void clear();
+
+    inline unsigned long size() const { return m_min.size(); }
+    inline float min(unsigned long bucket) const { return m_min[bucket]; }
+    inline float max(unsigned long bucket) const { return m_max[bucket]; }
+    inline double last() const { return m_last; }
+    inline unsigned long samplesPerBucket() const { return m_perBucket; }
+
+private:
+    unsigned long m_buckets;
+    unsigned long m_perBucket = 1;
+    unsigned long m_inLastBucket = 0;
+    double m_last = 0.0;
+    std::vector<float> m_min;
+    std::vector<float> m_max;
+};
+
+} // namespace Engine
@@ -1,217 +1,561 @@
 // clang-format off
 #include "Network.h"
 #include "Logging.h"
-#include <sstream>
+#include "Profiler.h"
+#include "Kernels.h"
+#include "ThreadPool.h"
 #include <random>
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <type_traits>
 #include <utility>
 // clang-format on
 
 namespace Engine {
 
-TrainingData::TrainingData(std::string_view path)
-    : m_file(path.data())
-{
-    assert(m_file.is_open());
-}
 
-unsigned long TrainingData::getNextInputs(vector<double>& inputVals)
+// Adds the lifetime of a scope to a shell's time when shell timing is on
+class ShellTimer
 {
-    inputVals.clear();
-
-    std::string line;
-    std::getline(m_file, line);
-    std::stringstream ss(line);
-
-    double oneValue;
-    while (ss >> oneValue)
-            inputVals.push_back(oneValue);
+public:
+    ShellTimer(bool enabled, double& seconds)
+        : m_seconds(enabled ? &seconds : nullptr)
+    {
+        if (m_seconds)
+            m_start = std::chrono::steady_clock::now();
+    }
 
-    return inputVals.size();
-}
+    ~ShellTimer()
+    {
+        if (m_seconds)
+            *m_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start)
+                              .count();
+    }
 
-unsigned long TrainingData::getTargetOutputs(vector<double>& targetOutputVals)
-{
-    targetOutputVals.clear();
+    ShellTimer(const ShellTimer&) = delete;
+    ShellTimer& operator=(const ShellTimer&) = delete;
 
-    std::string line;
-    std::getline(m_file, line);
-    std::stringstream ss(line);
+private:
+    double* m_seconds;
+    std::chrono::steady_clock::time_point m_start;
+};
 
-    double oneValue;
-    while (ss >> oneValue)
-        targetOutputVals.push_back(oneValue);
+// Multiply-adds below which a shell is evaluated on the calling thread. Waking the pool costs a
+// few microseconds, which is about what this much work takes on one core.
+static constexpr unsigned long s_parallelThreshold = 1ul << 15;
 
-    return targetOutputVals.size();
+template <typename T, typename Acc>
+BasicNetwork<T, Acc>::Shell::Shell(unsigned long nodes, unsigned long inputs)
+    : size(nodes)
+    , fanIn(inputs)
+    , outputs(nodes, 0.0)
+    , gradients(nodes, 0.0)
+{
 }
 
-// -----------------------------------------------------------------------------
-Network::Network(Topology topology)
+template <typename T, typename Acc>
+BasicNetwork<T, Acc>::BasicNetwork(Topology topology)
     : m_topology(std::move(topology))
 {
+    assert(m_topology.size() >= 2);
+
     const auto nLayers = m_topology.size();
+    m_shells.reserve(nLayers);
     for (auto l = 0u; l < nLayers; ++l)
     {
-        m_shells.emplace_back(Shell{});
-        auto numOutputs = l == m_topology.size() - 1 ? 0 : m_topology[l + 1];
-        ENGINE_INFO("Shell constructed. Position: {}", l);
+        m_shells.emplace_back(m_topology[l], l == 0 ? 0 : m_topology[l - 1]);
+        m_parameterCount += m_shells.back().parameters();
+        ENGINE_DEBUG("Shell constructed. Position: {}, nodes: {}", l, m_topology[l]);
+    }
+
+    m_parameters.resize(m_parameterCount);
+    m_gradients.assign(m_parameterCount, 0.0);
+    m_optimizer.resize(m_parameterCount);
+
+    for (auto& p : m_parameters)
+        p = randomWeight();
+
+    bind();
+}
 
-        // Appending an extra bias node to each shell
-        for (auto n = 0u; n <= m_topology[l]; ++n)
-            m_shells[l].emplace_back(Node(n, numOutputs));
+template <typename T, typename Acc>
+BasicNetwork<T, Acc>::BasicNetwork(const BasicNetwork& other)
+    : m_topology(other.m_topology)
+    , m_shells(other.m_shells)
+    , m_inputVals(other.m_inputVals)
+    , m_targetVals(other.m_targetVals)
+    , m_parameterCount(other.m_parameterCount)
+    , m_parameters(other.m_parameters)
+    , m_gradients(other.m_gradients)
+    , m_optimizer(other.m_optimizer)
+    , m_shared(other.m_shared)
+    , m_batchSize(other.m_batchSize)
+    , m_pool(other.m_pool)
+    , m_error(other.m_error)
+    , m_recentAvgError(other.m_recentAvgError)
+    , m_recentAvgSmoothingFactor(other.m_recentAvgSmoothingFactor)
+{
+    bind();
+}
 
-        // set the bias node's output value
-        // TODO This needs to be adjustable in real time
-        m_shells.back().back().output = 1.0;
+template <typename T, typename Acc>
+BasicNetwork<T, Acc>& BasicNetwork<T, Acc>::operator=(const BasicNetwork& other)
+{
+    if (this != &other)
+    {
+        BasicNetwork copy(other);
+        *this = std::move(copy);
     }
+
+    return *this;
 }
 
-void Network::forward(const std::vector<double>& input)
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::bind()
 {
-    assert(input.size() == m_shells.at(0).size() - 1);
+    auto* params = parameterData();
+    auto* gradients = m_gradients.data();
+    auto offset = 0ul;
 
-    for (unsigned int i = 0; i < input.size(); ++i)
+    for (auto& shell : m_shells)
     {
-        m_shells[0][i].output = input.at(i);
+        const auto weights = shell.size * shell.fanIn;
+        shell.offset = offset;
+        shell.weights = params + offset;
+        shell.biases = params + offset + weights;
+        shell.weightGradients = gradients + offset;
+        shell.biasGradients = gradients + offset + weights;
+
+        offset += shell.parameters();
     }
+}
+
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::shareParameters(BasicNetwork& owner)
+{
+    assert(owner.m_topology == m_topology);
+
+    shareParameters(owner.parameters());
+}
+
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::shareParameters(std::span<T> parameters)
+{
+    assert(parameters.size() == m_parameterCount);
+
+    m_shared = parameters.data();
+    m_parameters.clear();
+    m_parameters.shrink_to_fit();
+    bind();
+}
+
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::setActivation(unsigned long shell, Activation activation)
+{
+    assert(shell > 0 && shell < m_shells.size());
+    assert(activation != Activation::Softmax || shell == m_shells.size() - 1);
+
+    m_shells[shell].activation = activation;
+}
+
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::setOptimizer(const OptimizerOptions& options)
+{
+    m_optimizer.setOptions(options);
+}
+
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::setThreads(unsigned int workers)
+{
+    m_pool = workers ? std::make_shared<ThreadPool>(workers) : nullptr;
+}
+
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::setShellTiming(bool enabled) { m_shellTiming = enabled; }
+
+template <typename T, typename Acc>
+double BasicNetwork<T, Acc>::takeShellSeconds(unsigned long shell)
+{
+    return std::exchange(m_shells[shell].seconds, 0.0);
+}
+
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::setThreadPool(std::shared_ptr<ThreadPool> pool)
+{
+    m_pool = std::move(pool);
+}
 
-    for (unsigned int i = 1; i < m_shells.size(); ++i)
+template <typename T, typename Acc>
+template <typename Fn>
+void BasicNetwork<T, Acc>::parallel(unsigned long count, unsigned long workPerItem, Fn&& fn)
+{
+    const auto work = count * std::max(workPerItem, 1ul);
+    if (!m_pool || work < s_parallelThreshold)
     {
-        const auto& prevShell = m_shells[i - 1];
-        for (unsigned int n = 0; n < m_shells.at(i).size() - 1; ++n)
-        {
-            m_shells[i][n].forward(prevShell);
-        }
+        fn(0ul, count);
+        return;
     }
+
+    const auto grain = std::max(s_parallelThreshold / std::max(workPerItem, 1ul), 1ul);
+    m_pool->parallelFor(count, grain, std::forward<Fn>(fn));
 }
 
-void Network::backward(const std::vector<double>& target)
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::forward(std::span<const T> input)
 {
-    auto& output = m_shells.back();
+    assert(input.size() == m_topology.front());
 
-    m_error = 0.0;
-    for (unsigned int n = 0; n < output.size() - 1; ++n)
+    std::copy(input.begin(), input.end(), m_shells.front().outputs.begin());
+
+    for (auto l = 1ul; l < m_shells.size(); ++l)
     {
-        auto delta = target[n] - output[n].output;
-        m_error += delta * delta;
+        const auto& prev = m_shells[l - 1];
+        auto& shell = m_shells[l];
+        ShellTimer timer(m_shellTiming, shell.seconds);
+        ENGINE_PROFILE_SCOPE_INDEX("forward", l);
+
+        parallel(shell.size, shell.fanIn, [&](unsigned long begin, unsigned long end) {
+            for (auto n = begin; n < end; ++n)
+            {
+                const auto sum =
+                    Kernels::dotIn<Acc>(shell.row(n), prev.outputs.data(), shell.fanIn) +
+                    static_cast<Acc>(shell.biases[n]);
+                shell.outputs[n] = static_cast<T>(sum);
+            }
+        });
+
+        // Once for the whole shell, softmax needs every sum anyway
+        activate(shell.activation, shell.outputs.data(), 1, shell.size);
     }
+}
 
-    m_error /= output.size() - 1;
-    m_error = sqrt(m_error);
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::backward(std::span<const T> target)
+{
+    auto& output = m_shells.back();
+    assert(target.size() == output.size);
 
-    m_recentAvgError = (m_recentAvgError * m_recentAvgSmoothingFactor + m_error) /
-                       (m_recentAvgSmoothingFactor + 1.0);
+    trackError(output.outputs.data(), target.data());
 
-    for (unsigned int n = 0; n < output.size() - 1; ++n)
-        output.at(n).outputGradients(target[n]);
+    for (auto n = 0ul; n < output.size; ++n)
+        output.gradients[n] = target[n] - output.outputs[n];
+    multiplyDerivative(output.activation, output.outputs.data(), output.gradients.data(),
+                       output.size);
 
-    for (unsigned int l = m_shells.size() - 2; l > 0; --l)
+    // Hidden gradients are the transposed weight matrix of the next shell applied to its
+    // gradients. Accumulating row by row keeps the weight reads sequential, and splitting the
+    // columns between threads keeps their writes disjoint.
+    for (auto l = m_shells.size() - 2; l > 0; --l)
     {
         auto& hidden = m_shells[l];
-        auto& next = m_shells[l + 1];
+        const auto& next = m_shells[l + 1];
+        ShellTimer timer(m_shellTiming, hidden.seconds);
+        ENGINE_PROFILE_SCOPE_INDEX("backward", l);
+
+        parallel(hidden.size, next.size, [&](unsigned long begin, unsigned long end) {
+            auto* gradients = hidden.gradients.data() + begin;
+            std::fill(gradients, gradients + (end - begin), 0.0);
 
-        for (unsigned int n = 0; n < hidden.size(); ++n)
-            hidden[n].hiddenGradients(next);
+            for (auto r = 0ul; r < next.size; ++r)
+                Kernels::axpy(next.gradients[r], next.row(r) + begin, gradients, end - begin);
+
+            multiplyDerivative(hidden.activation, hidden.outputs.data() + begin, gradients,
+                               end - begin);
+        });
     }
 
-    for (unsigned int l = m_shells.size() - 1; l > 0; --l)
+    // A node's weight gradients are its gradient times the previous shell's outputs, so each row
+    // is updated straight from those without storing them
+    m_optimizer.beginStep();
+    for (auto l = m_shells.size() - 1; l > 0; --l)
     {
         auto& shell = m_shells[l];
-        auto& prev = m_shells[l - 1];
+        const auto& prev = m_shells[l - 1];
+        ShellTimer timer(m_shellTiming, shell.seconds);
+        ENGINE_PROFILE_SCOPE_INDEX("update", l);
+
+        parallel(shell.size, shell.fanIn, [&](unsigned long begin, unsigned long end) {
+            for (auto n = begin; n < end; ++n)
+                m_optimizer.update(shell.row(n), shell.offset + n * shell.fanIn,
+                                   prev.outputs.data(), static_cast<double>(shell.gradients[n]),
+                                   shell.fanIn);
+
+            // The bias node's output is always 1.0
+            m_optimizer.update(shell.biases + begin, shell.biasOffset() + begin,
+                               shell.gradients.data() + begin, 1.0, end - begin);
+        });
+    }
+}
+
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::forwardBatch(std::span<const T> inputs, unsigned long batchSize)
+{
+    assert(batchSize > 0);
+    assert(inputs.size() == batchSize * m_topology.front());
 
-        for (unsigned int n = 0; n < shell.size() - 1; ++n)
+    if (batchSize != m_batchSize)
+    {
+        m_batchSize = batchSize;
+        for (auto l = 1ul; l < m_shells.size(); ++l)
         {
-            shell[n].updateInputWeights(prev);
+            m_shells[l].batchOutputs.assign(batchSize * m_shells[l].size, 0.0);
+            m_shells[l].batchGradients.assign(batchSize * m_shells[l].size, 0.0);
         }
     }
+
+    // The input block is read in place rather than copied into the input shell
+    m_batchInputs = inputs;
+
+    // Samples are independent, so each thread takes a band of batch rows
+    for (auto l = 1ul; l < m_shells.size(); ++l)
+    {
+        const auto* prev = batchInputsOf(l);
+        auto& shell = m_shells[l];
+        ShellTimer timer(m_shellTiming, shell.seconds);
+        ENGINE_PROFILE_SCOPE_INDEX("forward batch", l);
+
+        parallel(batchSize, shell.size * shell.fanIn, [&](unsigned long begin, unsigned long end) {
+            auto* out = shell.batchOutputs.data() + begin * shell.size;
+            Kernels::gemmNT<T, Acc>(prev + begin * shell.fanIn, shell.weights, out, end - begin,
+                                    shell.size, shell.fanIn);
+
+            for (auto s = 0ul; s < end - begin; ++s)
+                Kernels::axpy(T(1), shell.biases, out + s * shell.size, shell.size);
+            activate(shell.activation, out, end - begin, shell.size);
+        });
+    }
 }
 
-std::vector<double> Network::results() const
+template <typename T, typename Acc>
+double BasicNetwork<T, Acc>::evaluate(std::span<const T> inputs, std::span<const T> targets,
+                                      unsigned long batchSize)
 {
-    std::vector<double> results;
-    for (unsigned int n = 0; n < m_shells.size() - 1; ++n)
+    const auto& output = m_shells.back();
+    assert(targets.size() == batchSize * output.size);
+
+    forwardBatch(inputs, batchSize);
+
+    auto total = 0.0;
+    for (auto s = 0ul; s < batchSize; ++s)
     {
-        results.push_back(m_shells.back()[n].output);
+        const auto* out = output.batchOutputs.data() + s * output.size;
+        const auto* target = targets.data() + s * output.size;
+
+        auto error = 0.0;
+        for (auto n = 0ul; n < output.size; ++n)
+        {
+            const auto delta = static_cast<double>(target[n] - out[n]);
+            error += delta * delta;
+        }
+
+        total += sqrt(error / static_cast<double>(output.size));
     }
 
-    return results;
+    return total / static_cast<double>(batchSize);
 }
 
-// -----------------------------------------------------------------------------
-double Network::Node::eta = 0.15;  // net training rate
-double Network::Node::alpha = 0.5; // momentum
-
-Network::Node::Node(unsigned int index, unsigned int connections)
-    : m_index(index)
+template <typename T, typename Acc>
+double BasicNetwork<T, Acc>::evaluate(const IndexedDataset::Subset& subset, unsigned long batchSize)
 {
-    // In a fully connected network, the order of nodes does not matter.
-    for (unsigned int i = 0; i < connections; ++i)
-        connectionWeights.emplace_back(Connection{randomWeight(), 0});
+    assert(batchSize > 0);
+
+    const auto& data = subset.data();
+    const auto indices = subset.indices();
+    if (indices.empty())
+        return 0.0;
+
+    // Datasets hold doubles, other precisions get a converted copy of every batch
+    std::vector<double> inputs;
+    std::vector<double> targets;
+    std::vector<T> scalarInputs;
+    std::vector<T> scalarTargets;
+    auto total = 0.0;
+    for (auto first = 0ul; first < indices.size(); first += batchSize)
+    {
+        const auto samples = std::min(batchSize, indices.size() - first);
+        inputs.resize(samples * data.inputWidth());
+        targets.resize(samples * data.targetWidth());
+        data.gather(indices.subspan(first, samples), inputs, targets);
+
+        if constexpr (std::is_same_v<T, double>)
+        {
+            total += evaluate(inputs, targets, samples) * static_cast<double>(samples);
+        }
+        else
+        {
+            scalarInputs.assign(inputs.begin(), inputs.end());
+            scalarTargets.assign(targets.begin(), targets.end());
+            total += evaluate(scalarInputs, scalarTargets, samples) * static_cast<double>(samples);
+        }
+    }
 
-    ENGINE_INFO("\tNode {} constructed", m_index);
+    return total / static_cast<double>(indices.size());
 }
 
-void Network::Node::forward(const Shell& prevShell)
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::backwardBatch(std::span<const T> targets)
 {
-    auto sum = 0.0;
-    for (unsigned int n = 0; n < prevShell.size(); ++n)
-        sum += prevShell[n].output * prevShell[n].connectionWeights[m_index].weight;
-
-    output = activationFunction(sum);
+    backpropagateBatch(targets, true);
 }
 
-void Network::Node::outputGradients(double target)
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::computeBatchGradients(std::span<const T> targets)
 {
-    auto delta = target - output;
-    m_gradient = delta * activationDerivative(output);
+    backpropagateBatch(targets, false);
 }
 
-void Network::Node::hiddenGradients(const Shell& next)
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::applyGradients(unsigned long samples)
 {
-    double dow = sumDOW(next);
-    m_gradient = dow * activationDerivative(output);
+    assert(samples > 0);
+
+    // Parameters, optimizer state and gradients share one layout, so the whole network is one
+    // pass
+    ENGINE_PROFILE_SCOPE("apply gradients");
+    const auto scale = 1.0 / static_cast<double>(samples);
+    m_optimizer.beginStep();
+    parallel(m_parameterCount, 1, [&](unsigned long begin, unsigned long end) {
+        m_optimizer.update(parameterData() + begin, begin, m_gradients.data() + begin, scale,
+                           end - begin);
+    });
 }
 
-void Network::Node::updateInputWeights(Shell& prev)
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::backpropagateBatch(std::span<const T> targets, bool update)
 {
-    for (unsigned int n = 0; n < prev.size(); ++n)
+    auto& output = m_shells.back();
+    assert(m_batchSize > 0);
+    assert(targets.size() == m_batchSize * output.size);
+
+    for (auto s = 0ul; s < m_batchSize; ++s)
     {
-        auto& node = prev[n];
-        auto& oldDeltaWeight = node.connectionWeights[m_index].deltaWeight;
-        double newDeltaWeight = eta * node.output * m_gradient + alpha * oldDeltaWeight;
+        const auto* out = output.batchOutputs.data() + s * output.size;
+        const auto* target = targets.data() + s * output.size;
+        auto* gradient = output.batchGradients.data() + s * output.size;
 
-        node.connectionWeights[m_index].deltaWeight = newDeltaWeight;
-        node.connectionWeights[m_index].weight += newDeltaWeight;
+        trackError(out, target);
+        for (auto n = 0ul; n < output.size; ++n)
+            gradient[n] = target[n] - out[n];
+    }
+    multiplyDerivative(output.activation, output.batchOutputs.data(),
+                       output.batchGradients.data(), m_batchSize * output.size);
+
+    for (auto l = m_shells.size() - 2; l > 0; --l)
+    {
+        auto& hidden = m_shells[l];
+        const auto& next = m_shells[l + 1];
+        ShellTimer timer(m_shellTiming, hidden.seconds);
+        ENGINE_PROFILE_SCOPE_INDEX("backward batch", l);
+
+        parallel(m_batchSize, hidden.size * next.size, [&](unsigned long begin, unsigned long end) {
+            auto* gradients = hidden.batchGradients.data() + begin * hidden.size;
+            const auto* outputs = hidden.batchOutputs.data() + begin * hidden.size;
+
+            Kernels::gemmNN(next.batchGradients.data() + begin * next.size, next.weights,
+                            gradients, end - begin, hidden.size, next.size);
+
+            multiplyDerivative(hidden.activation, outputs, gradients, (end - begin) * hidden.size);
+        });
+    }
+
+    // Gradients are summed over the whole batch and applied as a single averaged step. Each
+    // thread owns a band of nodes, i.e. a band of rows in the weight matrix, and updates it
+    // while it is still in cache.
+    const auto scale = 1.0 / static_cast<double>(m_batchSize);
+    if (update)
+        m_optimizer.beginStep();
+
+    for (auto l = m_shells.size() - 1; l > 0; --l)
+    {
+        auto& shell = m_shells[l];
+        const auto* prev = batchInputsOf(l);
+        ShellTimer timer(m_shellTiming, shell.seconds);
+        ENGINE_PROFILE_SCOPE_INDEX(update ? "update batch" : "batch gradients", l);
+
+        const auto work = shell.fanIn * m_batchSize;
+        parallel(shell.size, work, [&](unsigned long begin, unsigned long end) {
+            const auto rows = end - begin;
+            auto* weightGradients = shell.weightGradients + begin * shell.fanIn;
+            auto* biasGradients = shell.biasGradients + begin;
+
+            std::fill(weightGradients, weightGradients + rows * shell.fanIn, 0.0);
+            std::fill(biasGradients, biasGradients + rows, 0.0);
+
+            Kernels::gemmTNAccumulate(shell.batchGradients.data() + begin, prev, weightGradients,
+                                      rows, shell.fanIn, m_batchSize, shell.size);
+
+            for (auto s = 0ul; s < m_batchSize; ++s)
+                Kernels::axpy(1.0, shell.batchGradients.data() + s * shell.size + begin,
+                              biasGradients, rows);
+
+            if (!update)
+                return;
+
+            m_optimizer.update(shell.row(begin), shell.offset + begin * shell.fanIn,
+                               weightGradients, scale, rows * shell.fanIn);
+            m_optimizer.update(shell.biases + begin, shell.biasOffset() + begin, biasGradients,
+                               scale, rows);
+        });
     }
 }
 
-double Network::Node::activationFunction(double sum)
+template <typename T, typename Acc>
+std::vector<T> BasicNetwork<T, Acc>::results() const { return m_shells.back().outputs; }
+
+template <typename T, typename Acc>
+std::span<const T> BasicNetwork<T, Acc>::outputs() const { return m_shells.back().outputs; }
+
+template <typename T, typename Acc>
+const T* BasicNetwork<T, Acc>::batchInputsOf(unsigned long shell) const
 {
-    // TODO A way for nodes to have different activation functions?
-    return tanh(sum);
+    return shell == 1 ? m_batchInputs.data() : m_shells[shell - 1].batchOutputs.data();
 }
 
-double Network::Node::activationDerivative(double sum) { return 1.0 - sum * sum; }
-
-double Network::Node::randomWeight() const
+template <typename T, typename Acc>
+std::vector<T> BasicNetwork<T, Acc>::batchResults() const
 {
-    static std::random_device rd;
-    static std::mt19937 rng(rd());
-    static std::uniform_real_distribution<double> dist(0, 1);
+    return m_shells.back().batchOutputs;
+}
 
-    return dist(rng);
+template <typename T, typename Acc>
+std::span<const T> BasicNetwork<T, Acc>::batchOutputs() const
+{
+    return {m_shells.back().batchOutputs.data(), m_batchSize * m_shells.back().size};
 }
 
-double Network::Node::sumDOW(const Shell& shell) const
+template <typename T, typename Acc>
+void BasicNetwork<T, Acc>::trackError(const T* outputs, const T* target)
 {
-    auto sum = 0.0;
-    for (unsigned int n = 0; n < shell.size() - 1; ++n)
+    const auto size = m_topology.back();
+
+    m_error = 0.0;
+    for (auto n = 0ul; n < size; ++n)
     {
-        sum += connectionWeights[n].weight * shell[n].m_gradient;
+        const auto delta = static_cast<double>(target[n] - outputs[n]);
+        m_error += delta * delta;
     }
 
-    return sum;
+    m_error /= static_cast<double>(size);
+    m_error = sqrt(m_error);
+
+    m_recentAvgError = (m_recentAvgError * m_recentAvgSmoothingFactor + m_error) /
+                       (m_recentAvgSmoothingFactor + 1.0);
 }
 
+template <typename T, typename Acc>
+T BasicNetwork<T, Acc>::randomWeight()
+{
+    static std::random_device rd;
+    static std::mt19937 rng(rd());
+    static std::uniform_real_distribution<T> dist(0, 1);
+
+    return dist(rng);
+}
+
+template class BasicNetwork<double>;
+template class BasicNetwork<float>;
+template class BasicNetwork<float, double>;
+
 } // namespace Engine
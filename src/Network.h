@@ -1,94 +1,184 @@
 /* This is a simple prototype for a fully connected, deep neural network.
  * It can create networks with an arbitrary number of layers / nodes each layer.
- * It is restricted by 1) its fully connected nature. 2) One type of activation
- * function only */
+ * It is restricted by its fully connected nature. Every shell picks its own activation
+ * function, tanh by default.
+ *
+ * The network is a template over its scalar type T, which is used for weights, outputs and
+ * gradients, and the type Acc its dot products are summed in. Network is the double precision
+ * one, NetworkF32 halves the memory and doubles the SIMD lanes, NetworkMixed keeps float
+ * weights but sums in double to lose less precision over wide shells. */
 #pragma once
 
-#include <fstream>
-#include <string_view>
+#include "Activations.h"
+#include "IndexedDataset.h"
+#include "Optimizer.h"
+#include <memory>
+#include <span>
 #include <vector>
 
 namespace Engine {
 
 using namespace std;
 
-class TrainingData
-{
-    using Topology = std::vector<unsigned long>;
-
-public:
-    explicit TrainingData(std::string_view path);
-    bool isEof(void) { return m_file.eof(); }
-
-    // Returns the number of input values read from the file:
-    unsigned long getNextInputs(vector<double>& inputVals);
-    unsigned long getTargetOutputs(vector<double>& targetOutputVals);
+class ThreadPool;
 
-private:
-    ifstream m_file;
-};
-
-// -----------------------------------------------------------------------------
-class Network
+template <typename T, typename Acc = T>
+class BasicNetwork
 {
     friend class NetworkLayer;
     using Topology = std::vector<unsigned long>;
-    class Node;
-    using Shell = std::vector<Node>; // A neural network layer
+    struct Shell; // A neural network layer
 
 public:
-    explicit Network(Topology topology);
+    using Scalar = T;
+
+    explicit BasicNetwork(Topology topology);
+    BasicNetwork(const BasicNetwork& other);
+    BasicNetwork& operator=(const BasicNetwork& other);
+    BasicNetwork(BasicNetwork&&) = default;
+    BasicNetwork& operator=(BasicNetwork&&) = default;
 
 public:
-    void forward(const std::vector<double>& input);
-    void backward(const std::vector<double>& target);
-    std::vector<double> results() const;
+    void forward(std::span<const T> input);
+    void backward(std::span<const T> target);
+    std::vector<T> results() const;
+    std::span<const T> outputs() const; // results() without the copy
     inline const Topology& topology() const { return m_topology; }
+    inline double error() const { return m_error; }
+    inline double recentAverageError() const { return m_recentAvgError; }
+
+    // Activation of a shell other than the input shell. Softmax is only valid for the output.
+    void setActivation(unsigned long shell, Activation activation);
+    inline Activation activation(unsigned long shell) const
+    {
+        return m_shells[shell].activation;
+    }
+
+    // Mini-batch training. Inputs and targets are row-major blocks holding one sample per row.
+    // backwardBatch() accumulates the gradients of the whole batch and updates weights once.
+    // The input block is not copied, it has to stay alive until the batch has been propagated
+    // back.
+    void forwardBatch(std::span<const T> inputs, unsigned long batchSize);
+    void backwardBatch(std::span<const T> targets);
+    std::vector<T> batchResults() const;
+    std::span<const T> batchOutputs() const;
+    inline unsigned long batchSize() const { return m_batchSize; }
+
+    // Mean per-sample RMS error over a batch, for validation. Nothing is trained and error()
+    // and recentAverageError() are left alone, but the batch buffers are reused.
+    double evaluate(std::span<const T> inputs, std::span<const T> targets,
+                    unsigned long batchSize);
+    double evaluate(const IndexedDataset::Subset& subset, unsigned long batchSize = 256);
+
+    // backwardBatch() in two halves, for callers that combine gradients from several networks.
+    // computeBatchGradients() leaves the summed gradients of the last batch in gradients(),
+    // applyGradients() takes one optimizer step with them averaged over the given sample count.
+    void computeBatchGradients(std::span<const T> targets);
+    void applyGradients(unsigned long samples);
+
+    // All weights and biases live in one flat buffer, shell after shell, each shell laid out as
+    // its weight matrix followed by its bias vector. Gradients use the same layout.
+    inline std::span<T> parameters() { return {parameterData(), m_parameterCount}; }
+    inline std::span<const T> parameters() const
+    {
+        return {parameterData(), m_parameterCount};
+    }
+    inline std::span<T> gradients() { return m_gradients; }
+    inline std::span<const T> gradients() const { return m_gradients; }
+
+    // Every backward pass, per sample or per batch, is one step of the network's optimizer.
+    // setOptimizer() keeps the optimizer's state unless the type changes.
+    void setOptimizer(const OptimizerOptions& options);
+    inline Optimizer<T>& optimizer() { return m_optimizer; }
+    inline const Optimizer<T>& optimizer() const { return m_optimizer; }
+
+    // Makes this network read and update the weights of another one with the same topology
+    // instead of its own. The owner must outlive this network. Optimizer state stays per
+    // network.
+    void shareParameters(BasicNetwork& owner);
+
+    // The same for a buffer laid out like parameters(), e.g. a checkpoint's mapped weights
+    void shareParameters(std::span<T> parameters);
+
+    // Splits every shell's nodes (or batch rows) across a pool of workers. setThreads() gives
+    // the network a pool of its own, setThreadPool() shares an existing one. Shells too small to
+    // be worth waking the pool for are always evaluated on the calling thread.
+    void setThreads(unsigned int workers);
+    void setThreadPool(std::shared_ptr<ThreadPool> pool);
+    inline const std::shared_ptr<ThreadPool>& threadPool() const { return m_pool; }
+
+    // Optional wall time per shell, forward and backward, for profiling. takeShellSeconds()
+    // returns the time a shell accumulated since the previous call.
+    void setShellTiming(bool enabled);
+    double takeShellSeconds(unsigned long shell);
+
+private:
+    void bind();
+    void backpropagateBatch(std::span<const T> targets, bool update);
+    const T* batchInputsOf(unsigned long shell) const;
+    template <typename Fn>
+    void parallel(unsigned long count, unsigned long workPerItem, Fn&& fn);
+    void trackError(const T* outputs, const T* target);
+    inline T* parameterData() { return m_shared ? m_shared : m_parameters.data(); }
+    inline const T* parameterData() const { return m_shared ? m_shared : m_parameters.data(); }
+    static T randomWeight();
 
 private:
     Topology m_topology;
     std::vector<Shell> m_shells;
-    std::vector<double> m_inputVals;
-    std::vector<double> m_targetVals;
-    double m_error;
-    double m_recentAvgError;
-    double m_recentAvgSmoothingFactor;
-
-    class Node
+    std::vector<T> m_inputVals;
+    std::vector<T> m_targetVals;
+    unsigned long m_parameterCount = 0;
+    std::vector<T> m_parameters;
+    std::vector<T> m_gradients;
+    Optimizer<T> m_optimizer;
+    T* m_shared = nullptr;
+    unsigned long m_batchSize = 0;
+    std::span<const T> m_batchInputs;
+    std::shared_ptr<ThreadPool> m_pool;
+    bool m_shellTiming = false;
+    double m_error = 0.0;
+    double m_recentAvgError = 0.0;
+    double m_recentAvgSmoothingFactor = 100.0;
+
+    // Every shell owns the weights of the connections feeding into it. They are stored as one
+    // contiguous row-major matrix with a row per node and a column per node of the previous
+    // shell, so a node's inputs are a single linear scan. The previous shell's bias node is
+    // kept out of the matrix as a separate bias vector. The matrices are views into the
+    // network's flat buffers, rebound by Network::bind().
+    struct Shell
     {
-        struct Connection;
-
-    public:
-        explicit Node(unsigned int index, unsigned int connections);
-
-    public:
-        void forward(const Shell& prevShell);
-        void outputGradients(double target);
-        void hiddenGradients(const Shell& next);
-        void updateInputWeights(Shell& prev);
-
-    public:
-        double output;
-        std::vector<Connection> connectionWeights;
-
-    private:
-        static double activationFunction(double sum);
-        static double activationDerivative(double x);
-        double randomWeight() const;
-        double sumDOW(const Shell& shell) const;
-
-    private:
-        unsigned int m_index;
-        double m_gradient;
-        static double eta;
-        static double alpha;
-
-        struct Connection
-        {
-            double weight;
-            double deltaWeight;
-        };
+        Shell(unsigned long nodes, unsigned long inputs);
+
+        inline T* row(unsigned long node) { return weights + node * fanIn; }
+        inline const T* row(unsigned long node) const { return weights + node * fanIn; }
+        inline unsigned long parameters() const { return fanIn ? size * (fanIn + 1) : 0; }
+        inline unsigned long biasOffset() const { return offset + size * fanIn; }
+
+        unsigned long size;
+        unsigned long fanIn;
+        Activation activation = Activation::Tanh;
+        std::vector<T> outputs;
+        std::vector<T> gradients;
+        unsigned long offset = 0; // of the weights in the network's flat buffers
+        T* weights = nullptr;
+        T* biases = nullptr;
+        T* weightGradients = nullptr;
+        T* biasGradients = nullptr;
+        double seconds = 0.0; // with shell timing on
+
+        // Mini-batch scratch, one row per sample
+        std::vector<T> batchOutputs;
+        std::vector<T> batchGradients;
     };
 };
 
+using Network = BasicNetwork<double>;
+using NetworkF32 = BasicNetwork<float>;
+using NetworkMixed = BasicNetwork<float, double>;
+
+extern template class BasicNetwork<double>;
+extern template class BasicNetwork<float>;
+extern template class BasicNetwork<float, double>;
+
 } // namespace Engine
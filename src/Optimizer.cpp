@@ -0,0 +1,173 @@
+// clang-format off
+#include "Optimizer.h"
+#include "Kernels.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numbers>
+// clang-format on
+
+namespace Engine {
+
+double LearningRateSchedule::rate(double base, unsigned long step) const
+{
+    if (step < warmupSteps)
+        return base * static_cast<double>(step + 1) / static_cast<double>(warmupSteps);
+
+    const auto t = static_cast<double>(step - warmupSteps);
+    const auto period = static_cast<double>(std::max(decaySteps, 1ul));
+
+    switch (type)
+    {
+    case Type::Constant:
+        return base;
+    case Type::Step:
+        return base * std::pow(decayRate, std::floor(t / period));
+    case Type::Exponential:
+        return base * std::pow(decayRate, t / period);
+    case Type::Cosine:
+        if (t >= period)
+            return minRate;
+        return minRate + 0.5 * (base - minRate) * (1.0 + std::cos(std::numbers::pi * t / period));
+    }
+
+    return base;
+}
+
+const char* optimizerName(OptimizerType type)
+{
+    switch (type)
+    {
+    case OptimizerType::Momentum:
+        return "SGD + momentum";
+    case OptimizerType::Nesterov:
+        return "Nesterov";
+    case OptimizerType::RmsProp:
+        return "RMSProp";
+    case OptimizerType::Adam:
+        return "Adam";
+    }
+
+    return "Unknown";
+}
+
+double defaultLearningRate(OptimizerType type)
+{
+    switch (type)
+    {
+    case OptimizerType::Momentum:
+    case OptimizerType::Nesterov:
+        return 0.15;
+    case OptimizerType::RmsProp:
+    case OptimizerType::Adam:
+        return 0.01;
+    }
+
+    return 0.01;
+}
+
+template <typename T>
+Optimizer<T>::Optimizer(OptimizerOptions options)
+    : m_options(options)
+{
+}
+
+template <typename T>
+void Optimizer<T>::resize(unsigned long parameters)
+{
+    m_parameters = parameters;
+    reset();
+}
+
+template <typename T>
+void Optimizer<T>::reset()
+{
+    m_steps = 0;
+    m_first.assign(m_parameters, 0.0);
+
+    // Only Adam keeps a second moment
+    if (m_options.type == OptimizerType::Adam)
+        m_second.assign(m_parameters, 0.0);
+    else
+        m_second = {};
+}
+
+template <typename T>
+void Optimizer<T>::setOptions(const OptimizerOptions& options)
+{
+    const auto typeChanged = options.type != m_options.type;
+    m_options = options;
+
+    if (typeChanged)
+        reset();
+}
+
+template <typename T>
+void Optimizer<T>::restore(const OptimizerOptions& options, unsigned long steps,
+                           std::span<const T> first, std::span<const T> second)
+{
+    assert(first.empty() || first.size() == m_parameters);
+    assert(second.empty() || second.size() == m_parameters);
+
+    m_options = options;
+    reset();
+    m_steps = steps;
+
+    if (!first.empty())
+        std::copy(first.begin(), first.end(), m_first.begin());
+    if (!second.empty() && !m_second.empty())
+        std::copy(second.begin(), second.end(), m_second.begin());
+}
+
+template <typename T>
+void Optimizer<T>::beginStep()
+{
+    m_rate = m_options.schedule.rate(m_options.learningRate, m_steps);
+    ++m_steps;
+
+    if (m_options.type == OptimizerType::Adam)
+    {
+        // Bias correction of both moments, folded into the step size and epsilon
+        const auto t = static_cast<double>(m_steps);
+        const auto first = 1.0 - std::pow(m_options.beta1, t);
+        const auto second = std::sqrt(1.0 - std::pow(m_options.beta2, t));
+        m_adamStep = m_rate * second / first;
+        m_adamEpsilon = m_options.epsilon * second;
+    }
+}
+
+template <typename T>
+void Optimizer<T>::update(T* parameters, unsigned long offset, const T* x, double scale,
+                          unsigned long n)
+{
+    assert(offset + n <= m_parameters);
+    assert(m_steps > 0);
+
+    auto* first = m_first.data() + offset;
+    switch (m_options.type)
+    {
+    case OptimizerType::Momentum:
+        Kernels::momentumUpdate(parameters, first, x, static_cast<T>(m_rate * scale),
+                                static_cast<T>(m_options.momentum), n);
+        break;
+    case OptimizerType::Nesterov:
+        Kernels::nesterovUpdate(parameters, first, x, static_cast<T>(m_rate * scale),
+                                static_cast<T>(m_options.momentum), n);
+        break;
+    case OptimizerType::RmsProp:
+        Kernels::rmsPropUpdate(parameters, first, x, static_cast<T>(scale),
+                               static_cast<T>(m_rate), static_cast<T>(m_options.decay),
+                               static_cast<T>(m_options.epsilon), n);
+        break;
+    case OptimizerType::Adam:
+        Kernels::adamUpdate(parameters, first, m_second.data() + offset, x, static_cast<T>(scale),
+                            static_cast<T>(m_adamStep), static_cast<T>(m_options.beta1),
+                            static_cast<T>(m_options.beta2), static_cast<T>(m_adamEpsilon), n);
+        break;
+    }
+}
+
+template class Optimizer<double>;
+template class Optimizer<float>;
+
+} // namespace Engine
@@ -0,0 +1,103 @@
+/* Optimizers turn the gradients backpropagation finds into parameter updates. Each network
+ * owns one, together with all of its per-parameter state, kept in flat buffers with the same
+ * layout as the network's parameters. An update of any range of parameters is then a single
+ * fused pass of one vector kernel over the parameters, the gradients and the state. The
+ * learning rate follows a schedule over the optimizer's steps.
+ *
+ * Gradients follow the network's sign convention: they point the way the parameters should
+ * move, so every optimizer adds its step. */
+#pragma once
+
+// clang-format off
+#include <span>
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+enum class OptimizerType { Momentum, Nesterov, RmsProp, Adam };
+
+struct LearningRateSchedule
+{
+    enum class Type { Constant, Step, Exponential, Cosine };
+
+    // Learning rate at a step, counted from 0. The rate first ramps up linearly over the warmup
+    // steps, then Step multiplies it by decayRate every decaySteps steps, Exponential does the
+    // same continuously and Cosine anneals it to minRate over decaySteps and stays there.
+    double rate(double base, unsigned long step) const;
+
+    Type type = Type::Constant;
+    unsigned long warmupSteps = 0;
+    unsigned long decaySteps = 1000;
+    double decayRate = 0.5;
+    double minRate = 0.0;
+};
+
+struct OptimizerOptions
+{
+    OptimizerType type = OptimizerType::Momentum;
+    double learningRate = 0.15;
+    double momentum = 0.5; // Momentum and Nesterov
+    double decay = 0.9;    // RMSProp's moving average of squared gradients
+    double beta1 = 0.9;    // Adam's moving averages of gradients and squared gradients
+    double beta2 = 0.999;
+    double epsilon = 1e-8; // RMSProp and Adam
+    LearningRateSchedule schedule;
+};
+
+const char* optimizerName(OptimizerType type);
+
+// A learning rate that works for the optimizer on the small networks this engine trains
+double defaultLearningRate(OptimizerType type);
+
+template <typename T>
+class Optimizer
+{
+public:
+    explicit Optimizer(OptimizerOptions options = {});
+
+    // Sizes the state for a number of parameters and clears it
+    void resize(unsigned long parameters);
+
+    // Clears the state and starts over at step 0
+    void reset();
+
+    // Changing the type clears the state, other changes take effect with the next step
+    void setOptions(const OptimizerOptions& options);
+    inline const OptimizerOptions& options() const { return m_options; }
+
+    inline unsigned long steps() const { return m_steps; }
+    inline double learningRate() const { return m_rate; }
+
+    // Starts the next step, every update() until the next call is part of it
+    void beginStep();
+
+    // Moves parameters[0, n), which are the parameters at offset in the network's layout,
+    // along the gradients scale * x. Updates of disjoint ranges may run concurrently.
+    void update(T* parameters, unsigned long offset, const T* x, double scale, unsigned long n);
+
+    // First and second moment, or whichever of them the optimizer uses
+    inline std::span<const T> firstState() const { return m_first; }
+    inline std::span<const T> secondState() const { return m_second; }
+
+    // Picks up where a saved optimizer left off. Missing state starts from zero.
+    void restore(const OptimizerOptions& options, unsigned long steps, std::span<const T> first,
+                 std::span<const T> second);
+
+private:
+    OptimizerOptions m_options;
+    unsigned long m_parameters = 0;
+    unsigned long m_steps = 0;
+    std::vector<T> m_first;  // velocity, mean square or mean
+    std::vector<T> m_second; // Adam's variance
+
+    // Per step constants
+    double m_rate = 0.0;
+    double m_adamStep = 0.0;
+    double m_adamEpsilon = 0.0;
+};
+
+extern template class Optimizer<double>;
+extern template class Optimizer<float>;
+
+} // namespace Engine
@@ -0,0 +1,379 @@
+// clang-format off
+#include "ParallelTrainer.h"
+#include "Kernels.h"
+#include "Logging.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+// clang-format on
+
+namespace Engine {
+
+ParallelTrainer::ParallelTrainer(Network& network, unsigned int replicas, Mode mode)
+    : m_network(network)
+    , m_mode(mode)
+    , m_pool(replicas > 1 ? replicas - 1 : 0)
+{
+    assert(replicas > 0);
+
+    m_replicas.reserve(replicas);
+    for (auto r = 0u; r < replicas; ++r)
+    {
+        // Copies take over the activations and optimizer settings along with the topology
+        m_replicas.push_back({Network(network), {}, {}, 0, {}, {}, {}, nullptr});
+
+        // Replicas already run one per core, nesting intra-layer threads would only contend
+        auto& replica = m_replicas.back();
+        replica.network.setThreadPool(nullptr);
+
+        // Hogwild replicas keep the copy as their private weights
+        if (mode == Mode::Synchronous)
+            replica.network.shareParameters(m_network);
+        else
+            replica.snapshot.resize(replica.network.parameters().size());
+    }
+}
+
+const char* ParallelTrainer::modeName(Mode mode)
+{
+    switch (mode)
+    {
+    case Mode::Synchronous:
+        return "Synchronous";
+    case Mode::Hogwild:
+        return "Hogwild";
+    }
+
+    return "Unknown";
+}
+
+ParallelTrainer::Report ParallelTrainer::train(TrainingData& data, unsigned long batchSize,
+                                               unsigned long maxSamples)
+{
+    auto read = [&](Replica& replica, unsigned long n) { return readBatch(data, replica, n); };
+    auto report = run(read, batchSize, maxSamples);
+    report.dataError = data.error();
+
+    return report;
+}
+
+ParallelTrainer::Report ParallelTrainer::train(const BinaryDataset& data, unsigned long batchSize,
+                                               unsigned long maxSamples)
+{
+    assert(data.isOpen());
+    assert(data.inputWidth() == m_network.topology().front());
+    assert(data.targetWidth() == m_network.topology().back());
+
+    auto cursor = 0ul;
+    auto read = [&](Replica& replica, unsigned long n) {
+        replica.samples = std::min(n, data.samples() - cursor);
+        if (data.dtype() == BinaryDataset::DType::Float64)
+        {
+            replica.inputs = data.inputs<double>(cursor, replica.samples);
+            replica.targets = data.targets<double>(cursor, replica.samples);
+        }
+        else
+        {
+            // Single precision files are widened batch by batch, the network trains in double
+            const auto inputs = data.inputs<float>(cursor, replica.samples);
+            const auto targets = data.targets<float>(cursor, replica.samples);
+            replica.inputBuffer.assign(inputs.begin(), inputs.end());
+            replica.targetBuffer.assign(targets.begin(), targets.end());
+            replica.inputs = replica.inputBuffer;
+            replica.targets = replica.targetBuffer;
+        }
+
+        cursor += replica.samples;
+        return replica.samples;
+    };
+
+    return run(read, batchSize, maxSamples);
+}
+
+ParallelTrainer::Report ParallelTrainer::train(DataLoader& loader, unsigned long maxSamples)
+{
+    assert(loader.inputWidth() == m_network.topology().front());
+    assert(loader.targetWidth() == m_network.topology().back());
+    assert(loader.depth() > m_replicas.size());
+
+    if (loader.depth() <= m_replicas.size())
+    {
+        Report report;
+        report.mode = m_mode;
+        report.replicas = static_cast<unsigned int>(m_replicas.size());
+        report.dataError = "the loader needs more slots than there are replicas";
+        return report;
+    }
+
+    m_loader = &loader;
+    auto read = [&](Replica& replica, unsigned long n) {
+        assert(!replica.batch);
+
+        replica.batch = n > 0 ? loader.acquire() : nullptr;
+        if (!replica.batch)
+        {
+            replica.samples = 0;
+            return 0ul;
+        }
+
+        replica.samples = std::min(n, replica.batch->samples);
+        replica.inputs = {replica.batch->inputs.data(), replica.samples * loader.inputWidth()};
+        replica.targets = {replica.batch->targets.data(), replica.samples * loader.targetWidth()};
+        return replica.samples;
+    };
+
+    auto report = run(read, loader.batchSize(), maxSamples, true);
+    for (auto& replica : m_replicas)
+        releaseBatch(replica);
+    m_loader = nullptr;
+
+    report.dataError = loader.error();
+    return report;
+}
+
+ParallelTrainer::Report ParallelTrainer::train(const IndexedDataset::Subset& subset,
+                                               unsigned long batchSize, unsigned long epoch)
+{
+    const auto& data = subset.data();
+    assert(data.inputWidth() == m_network.topology().front());
+    assert(data.targetWidth() == m_network.topology().back());
+
+    subset.order(epoch, m_order);
+
+    // Shuffled samples are scattered over the dataset, so every batch is gathered into a block
+    auto cursor = 0ul;
+    auto read = [&](Replica& replica, unsigned long n) {
+        replica.samples = std::min(n, m_order.size() - cursor);
+        replica.inputBuffer.resize(replica.samples * data.inputWidth());
+        replica.targetBuffer.resize(replica.samples * data.targetWidth());
+
+        data.gather({m_order.data() + cursor, replica.samples}, replica.inputBuffer,
+                    replica.targetBuffer);
+        replica.inputs = replica.inputBuffer;
+        replica.targets = replica.targetBuffer;
+        cursor += replica.samples;
+        return replica.samples;
+    };
+
+    auto report = run(read, batchSize, ~0ul);
+    report.dataError = data.error();
+
+    return report;
+}
+
+double ParallelTrainer::validate(const IndexedDataset::Subset& subset, unsigned long batchSize)
+{
+    return m_network.evaluate(subset, batchSize);
+}
+
+template <typename Reader>
+ParallelTrainer::Report ParallelTrainer::run(Reader&& read, unsigned long batchSize,
+                                             unsigned long maxSamples, bool concurrent)
+{
+    assert(batchSize > 0);
+
+    Report report;
+    report.mode = m_mode;
+    report.replicas = static_cast<unsigned int>(m_replicas.size());
+
+    const auto start = std::chrono::steady_clock::now();
+
+    if (m_mode == Mode::Synchronous)
+        trainSynchronous(read, batchSize, maxSamples, report);
+    else
+        trainHogwild(read, batchSize, maxSamples, concurrent, report);
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    report.seconds = std::chrono::duration<double>(elapsed).count();
+    report.samplesPerSecond =
+        report.seconds > 0.0 ? static_cast<double>(report.samples) / report.seconds : 0.0;
+
+    for (const auto& replica : m_replicas)
+        report.recentAvgError += replica.network.recentAverageError();
+    report.recentAvgError /= static_cast<double>(m_replicas.size());
+
+    ENGINE_INFO("{} training, {} replicas: {} samples in {:.3f}s ({:.0f} samples/s), error {:.6f}",
+                modeName(m_mode), report.replicas, report.samples, report.seconds,
+                report.samplesPerSecond, report.recentAvgError);
+
+    return report;
+}
+
+unsigned long ParallelTrainer::readBatch(TrainingData& data, Replica& replica,
+                                         unsigned long batchSize)
+{
+    const auto inputWidth = m_network.topology().front();
+    const auto targetWidth = m_network.topology().back();
+    auto& inputs = replica.inputBuffer;
+    auto& targets = replica.targetBuffer;
+
+    // Samples are parsed straight into the batch block
+    inputs.resize(batchSize * inputWidth);
+    targets.resize(batchSize * targetWidth);
+    replica.samples = 0;
+
+    while (replica.samples < batchSize)
+    {
+        std::span<double> in(inputs.data() + replica.samples * inputWidth, inputWidth);
+        std::span<double> target(targets.data() + replica.samples * targetWidth, targetWidth);
+        if (!data.readSample(in, target))
+            break;
+
+        ++replica.samples;
+    }
+
+    replica.inputs = {inputs.data(), replica.samples * inputWidth};
+    replica.targets = {targets.data(), replica.samples * targetWidth};
+    return replica.samples;
+}
+
+void ParallelTrainer::pull(Replica& replica)
+{
+    auto shared = m_network.parameters();
+    for (auto i = 0ul; i < shared.size(); ++i)
+        replica.snapshot[i] = std::atomic_ref(shared[i]).load(std::memory_order_relaxed);
+
+    std::copy(replica.snapshot.begin(), replica.snapshot.end(),
+              replica.network.parameters().begin());
+}
+
+void ParallelTrainer::push(Replica& replica)
+{
+    // A load and a store rather than an atomic add, an update racing with another may be lost
+    auto shared = m_network.parameters();
+    const auto trained = replica.network.parameters();
+    for (auto i = 0ul; i < shared.size(); ++i)
+    {
+        std::atomic_ref weight(shared[i]);
+        const auto delta = trained[i] - replica.snapshot[i];
+        weight.store(weight.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+}
+
+void ParallelTrainer::truncate(Replica& replica, unsigned long samples)
+{
+    if (samples >= replica.samples)
+        return;
+
+    replica.samples = samples;
+    replica.inputs = replica.inputs.first(samples * m_network.topology().front());
+    replica.targets = replica.targets.first(samples * m_network.topology().back());
+}
+
+// Hands a loader slot back as soon as the replica is done with it
+void ParallelTrainer::releaseBatch(Replica& replica)
+{
+    if (replica.batch)
+        m_loader->release(replica.batch);
+    replica.batch = nullptr;
+}
+
+template <typename Reader>
+void ParallelTrainer::trainSynchronous(Reader& read, unsigned long batchSize,
+                                       unsigned long maxSamples, Report& report)
+{
+    const auto replicas = static_cast<unsigned long>(m_replicas.size());
+    auto gradients = m_network.gradients();
+
+    while (report.samples < maxSamples)
+    {
+        // Batches are dealt out in order, so every replica sees its own shard of the stream
+        auto stepSamples = 0ul;
+        for (auto& replica : m_replicas)
+        {
+            const auto remaining = maxSamples - report.samples - stepSamples;
+            stepSamples += read(replica, std::min(batchSize, remaining));
+        }
+
+        if (stepSamples == 0)
+            break;
+
+        m_pool.parallelFor(replicas, 1, [&](unsigned long begin, unsigned long end) {
+            for (auto r = begin; r < end; ++r)
+            {
+                auto& replica = m_replicas[r];
+                if (replica.samples == 0)
+                    continue;
+
+                replica.network.forwardBatch(replica.inputs, replica.samples);
+                replica.network.computeBatchGradients(replica.targets);
+                releaseBatch(replica);
+            }
+        });
+
+        std::fill(gradients.begin(), gradients.end(), 0.0);
+        auto error = 0.0;
+        auto trained = 0ul;
+        for (auto& replica : m_replicas)
+        {
+            if (replica.samples == 0)
+                continue;
+
+            const auto replicaGradients = replica.network.gradients();
+            Kernels::axpy(1.0, replicaGradients.data(), gradients.data(), gradients.size());
+            error += replica.network.recentAverageError();
+            ++trained;
+        }
+
+        m_network.applyGradients(stepSamples);
+
+        report.samples += stepSamples;
+        ++report.steps;
+        report.errorHistory.push_back(error / static_cast<double>(trained));
+    }
+}
+
+template <typename Reader>
+void ParallelTrainer::trainHogwild(Reader& read, unsigned long batchSize,
+                                   unsigned long maxSamples, bool concurrent, Report& report)
+{
+    const auto replicas = static_cast<unsigned long>(m_replicas.size());
+
+    m_pool.parallelFor(replicas, 1, [&](unsigned long begin, unsigned long end) {
+        for (auto r = begin; r < end; ++r)
+        {
+            auto& replica = m_replicas[r];
+
+            while (true)
+            {
+                {
+                    // Only the stream itself is locked, weight updates never are
+                    std::unique_lock lock(m_dataMutex);
+                    if (report.samples >= maxSamples)
+                        break;
+
+                    const auto n = std::min(batchSize, maxSamples - report.samples);
+                    if (concurrent)
+                        lock.unlock();
+                    if (read(replica, n) == 0)
+                        break;
+                    if (concurrent)
+                        lock.lock();
+
+                    // Other replicas may have taken the rest of the samples in the meantime
+                    truncate(replica, maxSamples - std::min(report.samples, maxSamples));
+                    if (replica.samples == 0)
+                    {
+                        releaseBatch(replica);
+                        break;
+                    }
+
+                    report.samples += replica.samples;
+                }
+
+                pull(replica);
+                replica.network.forwardBatch(replica.inputs, replica.samples);
+                replica.network.backwardBatch(replica.targets);
+                releaseBatch(replica);
+                push(replica);
+
+                std::lock_guard lock(m_dataMutex);
+                ++report.steps;
+                report.errorHistory.push_back(replica.network.recentAverageError());
+            }
+        }
+    });
+}
+
+} // namespace Engine
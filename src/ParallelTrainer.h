@@ -0,0 +1,117 @@
+/* Data-parallel training. Several replicas of one network each run on their own thread and
+ * consume disjoint batches of the same TrainingData stream. They differ in how updates are
+ * applied:
+ *  - Synchronous: every replica reads the weights of the trained network directly and
+ *    computes the gradients of its batch, the gradients are averaged and a single update is
+ *    applied before the next step.
+ *  - Hogwild: every replica trains a private copy of the weights and adds its change to the
+ *    shared weights as soon as its batch is done, without any locking. Shared weights are only
+ *    accessed through relaxed atomic loads and stores, so replicas may read partially updated
+ *    weights and concurrent updates of one weight may be lost, which is the trade-off Hogwild
+ *    makes for never waiting on each other. Optimizer state stays per replica. */
+#pragma once
+
+// clang-format off
+#include "BinaryDataset.h"
+#include "DataLoader.h"
+#include "IndexedDataset.h"
+#include "Network.h"
+#include "ThreadPool.h"
+#include "TrainingData.h"
+#include <mutex>
+#include <string>
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+class ParallelTrainer
+{
+public:
+    enum class Mode { Synchronous, Hogwild };
+
+    struct Report
+    {
+        Mode mode;
+        unsigned int replicas;
+        unsigned long samples = 0;
+        unsigned long steps = 0;
+        double seconds = 0.0;
+        double samplesPerSecond = 0.0;
+        double recentAvgError = 0.0;
+        std::vector<double> errorHistory; // recent average error after every step
+        std::string dataError;            // set if training stopped on malformed data
+    };
+
+public:
+    ParallelTrainer(Network& network, unsigned int replicas, Mode mode);
+
+    // Trains until the data runs out or maxSamples samples have been consumed. Batches taken
+    // from a double precision BinaryDataset are views straight into its mapping, nothing is
+    // parsed or copied. Single precision ones are converted a batch at a time.
+    Report train(TrainingData& data, unsigned long batchSize, unsigned long maxSamples = ~0ul);
+    Report train(const BinaryDataset& data, unsigned long batchSize,
+                 unsigned long maxSamples = ~0ul);
+
+    // Trains on the batches a DataLoader prepares in the background, so parsing overlaps with
+    // the replicas' compute. The batch size is the loader's. Every replica holds a slot while it
+    // trains, so the loader needs more slots than there are replicas, otherwise nothing is
+    // trained and dataError says so.
+    Report train(DataLoader& loader, unsigned long maxSamples = ~0ul);
+
+    // One epoch over a subset, in that epoch's shuffled order
+    Report train(const IndexedDataset::Subset& subset, unsigned long batchSize,
+                 unsigned long epoch);
+
+    // Mean per-sample error of the trained network over a subset, typically the validation split
+    double validate(const IndexedDataset::Subset& subset, unsigned long batchSize = 256);
+    static const char* modeName(Mode mode);
+
+private:
+    struct Replica
+    {
+        Network network;
+        std::span<const double> inputs;
+        std::span<const double> targets;
+        unsigned long samples = 0;
+
+        // Backing storage when the batch had to be parsed
+        std::vector<double> inputBuffer;
+        std::vector<double> targetBuffer;
+
+        // Hogwild only, the shared weights the replica's private copy was last pulled from
+        std::vector<double> snapshot;
+
+        // Loader slot the spans point into, held until the replica has trained on it
+        const DataLoader::Batch* batch = nullptr;
+    };
+
+    // Readers fill a replica with its next batch of at most n samples and return its size.
+    // Concurrent readers are thread safe on their own and may block, Hogwild replicas call them
+    // without holding the data lock.
+    template <typename Reader>
+    Report run(Reader&& read, unsigned long batchSize, unsigned long maxSamples,
+               bool concurrent = false);
+    template <typename Reader>
+    void trainSynchronous(Reader& read, unsigned long batchSize, unsigned long maxSamples,
+                          Report& report);
+    template <typename Reader>
+    void trainHogwild(Reader& read, unsigned long batchSize, unsigned long maxSamples,
+                      bool concurrent, Report& report);
+    unsigned long readBatch(TrainingData& data, Replica& replica, unsigned long batchSize);
+    void pull(Replica& replica);
+    void push(Replica& replica);
+    void truncate(Replica& replica, unsigned long samples);
+    void releaseBatch(Replica& replica);
+
+private:
+    Network& m_network;
+    Mode m_mode;
+    std::vector<Replica> m_replicas;
+    ThreadPool m_pool;
+    std::mutex m_dataMutex;
+    DataLoader* m_loader = nullptr; // while training from one
+    std::vector<unsigned long> m_order;
+};
+
+} // namespace Engine
@@ -0,0 +1,196 @@
+// clang-format off
+#include "Profiler.h"
+#include "Logging.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+namespace {
+
+struct Event
+{
+    const char* name;
+    long index;
+    std::int64_t start;
+    std::int64_t end;
+};
+
+// Written only by its thread. The count is published last, so whoever reads it sees every event
+// before it.
+struct ThreadBuffer
+{
+    std::unique_ptr<Event[]> events; // allocated by the first event the thread records
+    std::atomic<std::uint64_t> count = 0; // recorded in the session, overwritten ones included
+    std::atomic<std::uint64_t> session = 0;
+    std::atomic<bool> alive = true;
+    unsigned long id = 0;
+    std::string name; // guarded by s_mutex
+};
+
+std::mutex s_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> s_buffers;
+unsigned long s_threads = 0;
+std::atomic<std::uint64_t> s_session = 0;
+std::int64_t s_origin = 0;
+
+// The registry shares every buffer, what a thread recorded outlives the thread until the next
+// session starts
+struct ThreadHandle
+{
+    std::shared_ptr<ThreadBuffer> buffer;
+
+    ThreadBuffer& get()
+    {
+        if (!buffer)
+        {
+            buffer = std::make_shared<ThreadBuffer>();
+
+            std::lock_guard lock(s_mutex);
+            buffer->id = ++s_threads;
+            s_buffers.push_back(buffer);
+        }
+
+        return *buffer;
+    }
+
+    ~ThreadHandle()
+    {
+        if (buffer)
+            buffer->alive = false;
+    }
+};
+
+thread_local ThreadHandle t_thread;
+
+void writeString(std::ostream& out, const char* text)
+{
+    out << '"';
+    for (; *text; ++text)
+    {
+        if (*text == '"' || *text == '\\')
+            out << '\\';
+        out << *text;
+    }
+    out << '"';
+}
+
+} // namespace
+
+void Profiler::start()
+{
+    std::lock_guard lock(s_mutex);
+    std::erase_if(s_buffers, [](const auto& buffer) { return !buffer->alive; });
+
+    // Buffers notice the new session on their next event and start over
+    s_session.fetch_add(1, std::memory_order_relaxed);
+    s_origin = now();
+    s_recording.store(true, std::memory_order_release);
+}
+
+void Profiler::stop() { s_recording.store(false, std::memory_order_relaxed); }
+
+void Profiler::setThreadName(std::string name)
+{
+    auto& buffer = t_thread.get();
+
+    std::lock_guard lock(s_mutex);
+    buffer.name = std::move(name);
+}
+
+std::int64_t Profiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void Profiler::record(const char* name, long index, std::int64_t start, std::int64_t end)
+{
+    // The session may have stopped while the scope was open
+    if (!s_recording.load(std::memory_order_acquire))
+        return;
+
+    auto& buffer = t_thread.get();
+    const auto session = s_session.load(std::memory_order_relaxed);
+    if (buffer.session.load(std::memory_order_relaxed) != session)
+    {
+        buffer.count.store(0, std::memory_order_relaxed);
+        buffer.session.store(session, std::memory_order_relaxed);
+    }
+
+    if (!buffer.events)
+        buffer.events = std::make_unique<Event[]>(s_capacity);
+
+    const auto count = buffer.count.load(std::memory_order_relaxed);
+    buffer.events[count % s_capacity] = {name, index, start, end};
+    buffer.count.store(count + 1, std::memory_order_release);
+}
+
+bool Profiler::write(const std::filesystem::path& path)
+{
+    assert(!isRecording());
+
+    std::ofstream out(path, std::ios::trunc);
+    if (!out)
+    {
+        ENGINE_ERROR("Could not write trace {}", path.string());
+        return false;
+    }
+
+    std::lock_guard lock(s_mutex);
+    const auto session = s_session.load(std::memory_order_relaxed);
+
+    // Complete ("X") events in microseconds from the start of the session, one track per thread
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    auto first = true;
+    auto next = [&] {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    for (const auto& buffer : s_buffers)
+    {
+        const auto count = buffer->count.load(std::memory_order_acquire);
+        if (count == 0 || buffer->session.load(std::memory_order_relaxed) != session)
+            continue;
+
+        const auto name = buffer->name.empty() ? "thread " + std::to_string(buffer->id)
+                                               : buffer->name;
+        next();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+            << ",\"args\":{\"name\":";
+        writeString(out, name.c_str());
+        out << "}}";
+
+        // A scope that was closing as the session stopped can still be writing over the oldest
+        // event, which is left out
+        const auto begin = count > s_capacity ? count - s_capacity + 1 : 0;
+        for (auto i = begin; i < count; ++i)
+        {
+            const auto& event = buffer->events[i % s_capacity];
+            next();
+            out << "{\"name\":";
+            writeString(out, event.name);
+            out << ",\"cat\":\"engine\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+                << ",\"ts\":" << static_cast<double>(event.start - s_origin) / 1e3
+                << ",\"dur\":" << static_cast<double>(event.end - event.start) / 1e3;
+            if (event.index >= 0)
+                out << ",\"args\":{\"index\":" << event.index << '}';
+            out << '}';
+        }
+    }
+    out << "\n]}\n";
+
+    return static_cast<bool>(out);
+}
+
+} // namespace Engine
@@ -0,0 +1,96 @@
+/* Scope profiler. ENGINE_PROFILE_SCOPE() times the rest of the enclosing scope and, while a
+ * session is recording, appends it to a buffer owned by the calling thread, so recording takes
+ * no lock. Each thread keeps its most recent events in a ring, older ones are overwritten.
+ * Profiler::write() saves a stopped session as Chrome trace_event JSON, which chrome://tracing
+ * and Perfetto open.
+ *
+ * Without ENGINE_PROFILE the macros expand to nothing, the instrumented code is exactly what it
+ * was before. With it, a scope costs one relaxed load while nothing is recording. */
+#pragma once
+
+// clang-format off
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+// clang-format on
+
+namespace Engine {
+
+class Profiler
+{
+private:
+    Profiler() = default;
+
+public:
+#ifdef ENGINE_PROFILE
+    static constexpr bool s_enabled = true;
+#else
+    static constexpr bool s_enabled = false;
+#endif
+
+    // Events per thread kept by a session, the most recent ones
+    static constexpr unsigned long s_capacity = 1ul << 16;
+
+    // start() discards whatever the previous session recorded. write() needs the session
+    // stopped and must return before the next start().
+    static void start();
+    static void stop();
+    static bool write(const std::filesystem::path& path);
+    static inline bool isRecording() { return s_recording.load(std::memory_order_relaxed); }
+
+    // Names the calling thread's track in the trace
+    static void setThreadName(std::string name);
+
+    // Nanoseconds on the steady clock. The name is not copied, it has to outlive write().
+    static std::int64_t now();
+    static void record(const char* name, long index, std::int64_t start, std::int64_t end);
+
+private:
+    static inline std::atomic<bool> s_recording = false;
+};
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name, long index = -1)
+        : m_name(name)
+        , m_index(index)
+        , m_start(Profiler::isRecording() ? Profiler::now() : -1)
+    {
+    }
+
+    ~ProfileScope()
+    {
+        if (m_start >= 0)
+            Profiler::record(m_name, m_index, m_start, Profiler::now());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* m_name;
+    long m_index;
+    std::int64_t m_start;
+};
+
+} // namespace Engine
+
+#ifdef ENGINE_PROFILE
+#define ENGINE_PROFILE_JOIN_(a, b) a##b
+#define ENGINE_PROFILE_JOIN(a, b) ENGINE_PROFILE_JOIN_(a, b)
+#define ENGINE_PROFILE_SCOPE(name) \
+    Engine::ProfileScope ENGINE_PROFILE_JOIN(profileScope, __LINE__)(name)
+// Adds an index to the event, e.g. the shell a network pass is working on
+#define ENGINE_PROFILE_SCOPE_INDEX(name, index)                     \
+    Engine::ProfileScope ENGINE_PROFILE_JOIN(profileScope, __LINE__)( \
+        name, static_cast<long>(index))
+#define ENGINE_PROFILE_FUNCTION() ENGINE_PROFILE_SCOPE(__func__)
+#define ENGINE_PROFILE_THREAD(name) Engine::Profiler::setThreadName(name)
+#else
+#define ENGINE_PROFILE_SCOPE(name)
+#define ENGINE_PROFILE_SCOPE_INDEX(name, index)
+#define ENGINE_PROFILE_FUNCTION()
+#define ENGINE_PROFILE_THREAD(name)
+#endif
@@ -0,0 +1,339 @@
+// clang-format off
+#include "ReferenceNetwork.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+// clang-format on
+
+namespace Engine {
+
+ReferenceNetwork::ReferenceNetwork(Topology topology)
+    : m_topology(std::move(topology))
+    , m_activations(m_topology.size(), Activation::Tanh)
+{
+    assert(m_topology.size() >= 2);
+
+    for (auto l = 0ul; l < m_topology.size(); ++l)
+    {
+        m_shells.emplace_back();
+        const auto connections = l + 1 == m_topology.size() ? 0 : m_topology[l + 1];
+
+        // Appending an extra bias node to each shell
+        for (auto n = 0ul; n <= m_topology[l]; ++n)
+            m_shells[l].emplace_back(n, connections);
+
+        m_shells[l].back().output = 1.0;
+    }
+}
+
+void ReferenceNetwork::setActivation(unsigned long shell, Activation activation)
+{
+    assert(shell > 0 && shell < m_shells.size());
+    m_activations[shell] = activation;
+}
+
+void ReferenceNetwork::setOptimizer(const OptimizerOptions& options)
+{
+    m_options = options;
+    m_steps = 0;
+
+    for (auto& shell : m_shells)
+        for (auto& node : shell)
+            for (auto& connection : node.connections)
+                connection.first = connection.second = 0.0;
+}
+
+void ReferenceNetwork::setParameters(std::span<const double> parameters)
+{
+    auto offset = 0ul;
+    for (auto l = 1ul; l < m_shells.size(); ++l)
+    {
+        auto& prev = m_shells[l - 1];
+        const auto size = m_topology[l];
+        const auto fanIn = m_topology[l - 1];
+
+        for (auto n = 0ul; n < size; ++n)
+            for (auto i = 0ul; i < fanIn; ++i)
+                prev[i].connections[n].weight = parameters[offset + n * fanIn + i];
+
+        for (auto n = 0ul; n < size; ++n)
+            prev.back().connections[n].weight = parameters[offset + size * fanIn + n];
+
+        offset += size * (fanIn + 1);
+    }
+
+    assert(offset == parameters.size());
+}
+
+std::vector<double> ReferenceNetwork::parameters() const
+{
+    std::vector<double> parameters;
+    for (auto l = 1ul; l < m_shells.size(); ++l)
+    {
+        const auto& prev = m_shells[l - 1];
+        for (auto n = 0ul; n < m_topology[l]; ++n)
+            for (auto i = 0ul; i < m_topology[l - 1]; ++i)
+                parameters.push_back(prev[i].connections[n].weight);
+
+        for (auto n = 0ul; n < m_topology[l]; ++n)
+            parameters.push_back(prev.back().connections[n].weight);
+    }
+
+    return parameters;
+}
+
+std::vector<double> ReferenceNetwork::gradients() const
+{
+    std::vector<double> gradients;
+    for (auto l = 1ul; l < m_shells.size(); ++l)
+    {
+        const auto& prev = m_shells[l - 1];
+        for (auto n = 0ul; n < m_topology[l]; ++n)
+            for (auto i = 0ul; i < m_topology[l - 1]; ++i)
+                gradients.push_back(prev[i].connections[n].gradient);
+
+        for (auto n = 0ul; n < m_topology[l]; ++n)
+            gradients.push_back(prev.back().connections[n].gradient);
+    }
+
+    return gradients;
+}
+
+void ReferenceNetwork::forward(std::span<const double> input)
+{
+    assert(input.size() == m_topology.front());
+
+    for (auto i = 0ul; i < input.size(); ++i)
+        m_shells[0][i].output = input[i];
+
+    for (auto l = 1ul; l < m_shells.size(); ++l)
+    {
+        auto& shell = m_shells[l];
+        const auto size = m_topology[l];
+        for (auto n = 0ul; n < size; ++n)
+            shell[n].forward(m_shells[l - 1]);
+
+        if (m_activations[l] != Activation::Softmax)
+        {
+            for (auto n = 0ul; n < size; ++n)
+                shell[n].output = Node::activationFunction(m_activations[l], shell[n].sum);
+            continue;
+        }
+
+        // exp(sum - max) / sum(exp(sum - max)), which equals exp(sum) / sum(exp(sum))
+        auto max = shell[0].sum;
+        for (auto n = 1ul; n < size; ++n)
+            max = std::max(max, shell[n].sum);
+
+        auto total = 0.0;
+        for (auto n = 0ul; n < size; ++n)
+            total += std::exp(shell[n].sum - max);
+
+        for (auto n = 0ul; n < size; ++n)
+            shell[n].output = std::exp(shell[n].sum - max) / total;
+    }
+}
+
+std::vector<double> ReferenceNetwork::results() const
+{
+    std::vector<double> results;
+    for (auto n = 0ul; n < m_topology.back(); ++n)
+        results.push_back(m_shells.back()[n].output);
+
+    return results;
+}
+
+void ReferenceNetwork::backward(std::span<const double> target)
+{
+    for (auto& shell : m_shells)
+        for (auto& node : shell)
+            for (auto& connection : node.connections)
+                connection.gradient = 0.0;
+
+    accumulateGradients(target);
+    step(1.0);
+}
+
+void ReferenceNetwork::accumulateGradients(std::span<const double> target)
+{
+    assert(target.size() == m_topology.back());
+
+    auto& output = m_shells.back();
+    for (auto n = 0ul; n < m_topology.back(); ++n)
+        output[n].outputGradient(m_activations.back(), target[n]);
+
+    for (auto l = m_shells.size() - 2; l > 0; --l)
+        for (auto n = 0ul; n < m_topology[l]; ++n)
+            m_shells[l][n].hiddenGradient(m_activations[l], m_shells[l + 1]);
+
+    for (auto l = m_shells.size() - 1; l > 0; --l)
+        for (auto n = 0ul; n < m_topology[l]; ++n)
+            m_shells[l][n].accumulateInputGradients(m_shells[l - 1]);
+}
+
+void ReferenceNetwork::applyGradients(unsigned long samples)
+{
+    assert(samples > 0);
+
+    step(1.0 / static_cast<double>(samples));
+
+    for (auto& shell : m_shells)
+        for (auto& node : shell)
+            for (auto& connection : node.connections)
+                connection.gradient = 0.0;
+}
+
+double ReferenceNetwork::loss(std::span<const double> target) const
+{
+    const auto& output = m_shells.back();
+    auto loss = 0.0;
+    for (auto n = 0ul; n < m_topology.back(); ++n)
+    {
+        if (m_activations.back() == Activation::Softmax)
+        {
+            loss -= target[n] * std::log(output[n].output);
+        }
+        else
+        {
+            const auto delta = target[n] - output[n].output;
+            loss += 0.5 * delta * delta;
+        }
+    }
+
+    return loss;
+}
+
+void ReferenceNetwork::step(double scale)
+{
+    const auto rate = m_options.schedule.rate(m_options.learningRate, m_steps);
+    ++m_steps;
+
+    const auto t = static_cast<double>(m_steps);
+    const auto beta1Correction = 1.0 - std::pow(m_options.beta1, t);
+    const auto beta2Correction = 1.0 - std::pow(m_options.beta2, t);
+
+    for (auto l = 0ul; l + 1 < m_shells.size(); ++l)
+    {
+        for (auto& node : m_shells[l])
+        {
+            for (auto& connection : node.connections)
+            {
+                const auto g = scale * connection.gradient;
+                auto& w = connection.weight;
+                auto& first = connection.first;
+                auto& second = connection.second;
+
+                switch (m_options.type)
+                {
+                case OptimizerType::Momentum:
+                    first = rate * g + m_options.momentum * first;
+                    w += first;
+                    break;
+                case OptimizerType::Nesterov:
+                    first = m_options.momentum * first + rate * g;
+                    w += m_options.momentum * first + rate * g;
+                    break;
+                case OptimizerType::RmsProp:
+                    first = m_options.decay * first + (1.0 - m_options.decay) * g * g;
+                    w += rate * g / (std::sqrt(first) + m_options.epsilon);
+                    break;
+                case OptimizerType::Adam:
+                {
+                    first = m_options.beta1 * first + (1.0 - m_options.beta1) * g;
+                    second = m_options.beta2 * second + (1.0 - m_options.beta2) * g * g;
+                    const auto mean = first / beta1Correction;
+                    const auto variance = second / beta2Correction;
+                    w += rate * mean / (std::sqrt(variance) + m_options.epsilon);
+                    break;
+                }
+                }
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+ReferenceNetwork::Node::Node(unsigned long index, unsigned long connections)
+    : connections(connections, Connection{0.0})
+    , m_index(index)
+{
+}
+
+void ReferenceNetwork::Node::forward(const Shell& prev)
+{
+    sum = 0.0;
+    for (const auto& node : prev)
+        sum += node.output * node.connections[m_index].weight;
+}
+
+void ReferenceNetwork::Node::outputGradient(Activation activation, double target)
+{
+    // Through a softmax the cross-entropy gradient with respect to the sum is target - output
+    const auto delta = target - output;
+    gradient = activation == Activation::Softmax
+                   ? delta
+                   : delta * activationDerivative(activation, output);
+}
+
+void ReferenceNetwork::Node::hiddenGradient(Activation activation, const Shell& next)
+{
+    auto dow = 0.0;
+    for (auto n = 0ul; n + 1 < next.size(); ++n)
+        dow += connections[n].weight * next[n].gradient;
+
+    gradient = dow * activationDerivative(activation, output);
+}
+
+void ReferenceNetwork::Node::accumulateInputGradients(Shell& prev) const
+{
+    for (auto& node : prev)
+        node.connections[m_index].gradient += node.output * gradient;
+}
+
+double ReferenceNetwork::Node::activationFunction(Activation activation, double sum)
+{
+    // The fast variants approximate these, the reference computes them exactly
+    switch (activation)
+    {
+    case Activation::Tanh:
+    case Activation::FastTanh:
+        return std::tanh(sum);
+    case Activation::Sigmoid:
+    case Activation::FastSigmoid:
+        return 1.0 / (1.0 + std::exp(-sum));
+    case Activation::Relu:
+        return sum > 0.0 ? sum : 0.0;
+    case Activation::LeakyRelu:
+        return sum > 0.0 ? sum : s_leakySlope * sum;
+    case Activation::Linear:
+    case Activation::Softmax:
+        return sum;
+    }
+
+    return sum;
+}
+
+double ReferenceNetwork::Node::activationDerivative(Activation activation, double output)
+{
+    switch (activation)
+    {
+    case Activation::Tanh:
+    case Activation::FastTanh:
+        return 1.0 - output * output;
+    case Activation::Sigmoid:
+    case Activation::FastSigmoid:
+        return output * (1.0 - output);
+    case Activation::Relu:
+        return output > 0.0 ? 1.0 : 0.0;
+    case Activation::LeakyRelu:
+        return output > 0.0 ? 1.0 : s_leakySlope;
+    case Activation::Linear:
+    case Activation::Softmax:
+        return 1.0;
+    }
+
+    return 1.0;
+}
+
+} // namespace Engine
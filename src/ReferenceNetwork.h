@@ -0,0 +1,100 @@
+/* The original per-node network, kept as the golden reference the optimized engines are
+ * validated against. Every node owns its connections to the next shell and evaluates itself
+ * in plain scalar loops in double precision: no kernels, no batches, no threads, no
+ * approximations. Activations and optimizers are written out from their textbook definitions
+ * rather than shared with the engine, so a mistake in one shows up as a difference.
+ *
+ * It is slow on purpose and only meant for validation. Parameters and gradients are exchanged
+ * in Network's flat layout, so both can start from the same weights and be compared after any
+ * number of steps. */
+#pragma once
+
+// clang-format off
+#include "Activations.h"
+#include "Optimizer.h"
+#include <span>
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+class ReferenceNetwork
+{
+    using Topology = std::vector<unsigned long>;
+    class Node;
+    using Shell = std::vector<Node>; // A neural network layer, the last node is the bias node
+
+public:
+    explicit ReferenceNetwork(Topology topology);
+
+public:
+    void setActivation(unsigned long shell, Activation activation);
+    void setOptimizer(const OptimizerOptions& options);
+    inline const Topology& topology() const { return m_topology; }
+
+    // In Network's layout: shell after shell, a weight matrix followed by a bias vector
+    void setParameters(std::span<const double> parameters);
+    std::vector<double> parameters() const;
+
+    // Gradients summed since the last step, in the same layout
+    std::vector<double> gradients() const;
+
+    void forward(std::span<const double> input);
+    std::vector<double> results() const;
+
+    // Per-sample training, one optimizer step per sample
+    void backward(std::span<const double> target);
+
+    // Mini-batch training: gradients of every sample are summed, then applied as one step
+    // averaged over the samples
+    void accumulateGradients(std::span<const double> target);
+    void applyGradients(unsigned long samples);
+
+    // The loss whose negative gradient backward() follows: half the squared error, or the
+    // cross-entropy behind a softmax output
+    double loss(std::span<const double> target) const;
+
+private:
+    void step(double scale);
+
+private:
+    Topology m_topology;
+    std::vector<Shell> m_shells;
+    std::vector<Activation> m_activations;
+    OptimizerOptions m_options;
+    unsigned long m_steps = 0;
+
+    class Node
+    {
+    public:
+        explicit Node(unsigned long index, unsigned long connections);
+
+    public:
+        void forward(const Shell& prev);
+        void outputGradient(Activation activation, double target);
+        void hiddenGradient(Activation activation, const Shell& next);
+        void accumulateInputGradients(Shell& prev) const;
+
+        static double activationFunction(Activation activation, double sum);
+        static double activationDerivative(Activation activation, double output);
+
+    public:
+        struct Connection
+        {
+            double weight;
+            double gradient = 0.0; // summed since the last step
+            double first = 0.0;    // velocity, mean square or mean
+            double second = 0.0;   // Adam's variance
+        };
+
+        double sum = 0.0;
+        double output = 0.0;
+        double gradient = 0.0;
+        std::vector<Connection> connections;
+
+    private:
+        unsigned long m_index;
+    };
+};
+
+} // namespace Engine
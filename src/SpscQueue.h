@@ -0,0 +1,58 @@
+/* A bounded single-producer / single-consumer queue without locks. One thread pushes, one
+ * other thread pops, neither ever waits for the other: a push into a full queue fails and the
+ * value is dropped, a pop from an empty one fails. The two indices live on separate cache lines
+ * so producer and consumer do not contend for one. */
+#pragma once
+
+// clang-format off
+#include <array>
+#include <atomic>
+// clang-format on
+
+namespace Engine {
+
+template <typename T, unsigned long Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "capacity must be a power of two");
+
+public:
+    // Producer side
+    bool tryPush(const T& value)
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == Capacity)
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        m_items[head & (Capacity - 1)] = value;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool tryPop(T& value)
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire))
+            return false;
+
+        value = m_items[tail & (Capacity - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Values that did not fit because the consumer fell behind
+    inline unsigned long dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    alignas(64) std::atomic<unsigned long> m_head = 0;
+    alignas(64) std::atomic<unsigned long> m_tail = 0;
+    alignas(64) std::atomic<unsigned long> m_dropped = 0;
+    std::array<T, Capacity> m_items;
+};
+
+} // namespace Engine
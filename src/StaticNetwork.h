@@ -0,0 +1,372 @@
+/* A fully connected network whose topology is fixed at compile time, for tiny networks that are
+ * evaluated millions of times. Shell sizes and offsets are constants, all weights and biases
+ * live in one std::array and every loop over shells and nodes is unrolled, so a forward pass
+ * is straight-line code without a single allocation or indirection. Parameter updates are one
+ * pass of the network's optimizer over the whole parameter array.
+ *
+ * It follows the Network API and keeps its parameter layout, shell after shell, a row-major
+ * weight matrix followed by a bias vector, so parameters trained by either one can be copied
+ * into the other. Unrolling everything only pays off for small shells: large topologies belong
+ * in the dynamic Network. */
+#pragma once
+
+// clang-format off
+#include "Network.h"
+#include "Optimizer.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <span>
+#include <utility>
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+template <typename T, typename Acc, unsigned long... Sizes>
+class BasicStaticNetwork
+{
+    static_assert(sizeof...(Sizes) >= 2, "a network needs an input and an output shell");
+    static_assert(((Sizes > 0) && ...), "shells cannot be empty");
+
+    static constexpr std::size_t s_shells = sizeof...(Sizes);
+    static constexpr std::array<unsigned long, s_shells> s_sizes{Sizes...};
+
+    // Offset of each shell's outputs in the node buffer
+    static constexpr auto s_nodeOffsets = [] {
+        std::array<unsigned long, s_shells + 1> offsets{};
+        for (auto l = 0ul; l < s_shells; ++l)
+            offsets[l + 1] = offsets[l] + s_sizes[l];
+        return offsets;
+    }();
+
+    // Offset of each shell's weights in the parameter buffer, the input shell has none
+    static constexpr auto s_parameterOffsets = [] {
+        std::array<unsigned long, s_shells + 1> offsets{};
+        for (auto l = 1ul; l < s_shells; ++l)
+            offsets[l + 1] = offsets[l] + s_sizes[l] * (s_sizes[l - 1] + 1);
+        return offsets;
+    }();
+
+public:
+    using Scalar = T;
+    static constexpr unsigned long s_inputs = s_sizes.front();
+    static constexpr unsigned long s_outputs = s_sizes.back();
+    static constexpr unsigned long s_nodeCount = s_nodeOffsets.back();
+    static constexpr unsigned long s_parameterCount = s_parameterOffsets.back();
+
+    BasicStaticNetwork()
+    {
+        for (auto& p : m_parameters)
+            p = randomWeight();
+
+        m_optimizer.resize(s_parameterCount);
+    }
+
+    // Takes over the weights of a dynamic network with the same topology. Every shell here is
+    // tanh, a network with any other activation is not converted: isValid() is false and the
+    // weights stay random.
+    explicit BasicStaticNetwork(const BasicNetwork<T, Acc>& network)
+        : BasicStaticNetwork()
+    {
+        m_valid = convertible(network);
+        assert(m_valid);
+        if (!m_valid)
+            return;
+
+        const auto parameters = network.parameters();
+        std::copy(parameters.begin(), parameters.end(), m_parameters.begin());
+
+        m_optimizer.setOptions(network.optimizer().options());
+        m_optimizer.resize(s_parameterCount);
+    }
+
+public:
+    static bool convertible(const BasicNetwork<T, Acc>& network)
+    {
+        if (network.topology() != topology())
+            return false;
+
+        for (auto l = 1ul; l < s_shells; ++l)
+            if (network.activation(l) != Activation::Tanh)
+                return false;
+
+        return true;
+    }
+
+    // False after a failed conversion from a dynamic network
+    inline bool isValid() const { return m_valid; }
+
+    void forward(std::span<const T> input)
+    {
+        assert(input.size() == s_inputs);
+
+        std::copy(input.begin(), input.end(), m_nodes.begin());
+        propagate(m_parameters.data(), m_nodes.data());
+    }
+
+    void backward(std::span<const T> target)
+    {
+        assert(target.size() == s_outputs);
+
+        trackError(m_nodes.data() + s_nodeOffsets[s_shells - 1], target.data());
+        nodeGradients(m_nodes.data(), target.data(), m_nodeGradients.data());
+
+        // The per-sample gradients go through the same single optimizer pass as a batch's
+        m_gradients.fill(0.0);
+        accumulate(m_nodes.data(), m_nodeGradients.data(), m_gradients.data());
+        m_optimizer.beginStep();
+        m_optimizer.update(m_parameters.data(), 0, m_gradients.data(), 1.0, s_parameterCount);
+    }
+
+    inline std::vector<T> results() const
+    {
+        const auto out = outputs();
+        return {out.begin(), out.end()};
+    }
+
+    inline std::span<const T> outputs() const
+    {
+        return {m_nodes.data() + s_nodeOffsets[s_shells - 1], s_outputs};
+    }
+
+    static const std::vector<unsigned long>& topology()
+    {
+        static const std::vector<unsigned long> topology{Sizes...};
+        return topology;
+    }
+
+    inline double error() const { return m_error; }
+    inline double recentAverageError() const { return m_recentAvgError; }
+
+    // Mini-batch training, see Network. Every sample keeps its node outputs until the batch has
+    // been propagated back, which is the only storage that depends on the batch size.
+    void forwardBatch(std::span<const T> inputs, unsigned long batchSize)
+    {
+        assert(batchSize > 0);
+        assert(inputs.size() == batchSize * s_inputs);
+
+        if (batchSize != m_batchSize)
+        {
+            m_batchSize = batchSize;
+            m_batchNodes.assign(batchSize * s_nodeCount, 0.0);
+            m_batchOutputs.assign(batchSize * s_outputs, 0.0);
+        }
+
+        for (auto s = 0ul; s < batchSize; ++s)
+        {
+            auto* nodes = m_batchNodes.data() + s * s_nodeCount;
+            std::copy_n(inputs.data() + s * s_inputs, s_inputs, nodes);
+            propagate(m_parameters.data(), nodes);
+            std::copy_n(nodes + s_nodeOffsets[s_shells - 1], s_outputs,
+                        m_batchOutputs.data() + s * s_outputs);
+        }
+    }
+
+    void backwardBatch(std::span<const T> targets)
+    {
+        computeBatchGradients(targets);
+        applyGradients(m_batchSize);
+    }
+
+    inline std::vector<T> batchResults() const { return m_batchOutputs; }
+    inline std::span<const T> batchOutputs() const { return m_batchOutputs; }
+    inline unsigned long batchSize() const { return m_batchSize; }
+
+    double evaluate(std::span<const T> inputs, std::span<const T> targets,
+                    unsigned long batchSize)
+    {
+        assert(targets.size() == batchSize * s_outputs);
+
+        forwardBatch(inputs, batchSize);
+
+        auto total = 0.0;
+        for (auto s = 0ul; s < batchSize; ++s)
+            total += rmsError(m_batchOutputs.data() + s * s_outputs,
+                              targets.data() + s * s_outputs);
+
+        return total / static_cast<double>(batchSize);
+    }
+
+    void computeBatchGradients(std::span<const T> targets)
+    {
+        assert(m_batchSize > 0);
+        assert(targets.size() == m_batchSize * s_outputs);
+
+        m_gradients.fill(0.0);
+        for (auto s = 0ul; s < m_batchSize; ++s)
+        {
+            const auto* nodes = m_batchNodes.data() + s * s_nodeCount;
+            const auto* target = targets.data() + s * s_outputs;
+
+            trackError(nodes + s_nodeOffsets[s_shells - 1], target);
+            nodeGradients(nodes, target, m_nodeGradients.data());
+            accumulate(nodes, m_nodeGradients.data(), m_gradients.data());
+        }
+    }
+
+    void applyGradients(unsigned long samples)
+    {
+        assert(samples > 0);
+
+        m_optimizer.beginStep();
+        m_optimizer.update(m_parameters.data(), 0, m_gradients.data(),
+                           1.0 / static_cast<double>(samples), s_parameterCount);
+    }
+
+    inline void setOptimizer(const OptimizerOptions& options) { m_optimizer.setOptions(options); }
+    inline Optimizer<T>& optimizer() { return m_optimizer; }
+    inline const Optimizer<T>& optimizer() const { return m_optimizer; }
+
+    inline std::span<T> parameters() { return m_parameters; }
+    inline std::span<const T> parameters() const { return m_parameters; }
+    inline std::span<T> gradients() { return m_gradients; }
+    inline std::span<const T> gradients() const { return m_gradients; }
+
+private:
+    // Calls fn with std::integral_constant<std::size_t, 0> ... <Count - 1>, so every index is a
+    // constant expression inside fn and loops over it disappear.
+    template <std::size_t Count, typename Fn>
+    static inline void unroll(Fn&& fn)
+    {
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            (fn(std::integral_constant<std::size_t, I>{}), ...);
+        }(std::make_index_sequence<Count>{});
+    }
+
+    // The same, counting down from Count - 1
+    template <std::size_t Count, typename Fn>
+    static inline void unrollReverse(Fn&& fn)
+    {
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            (fn(std::integral_constant<std::size_t, Count - 1 - I>{}), ...);
+        }(std::make_index_sequence<Count>{});
+    }
+
+    // Fills in every shell's outputs behind the input shell's
+    static void propagate(const T* parameters, T* nodes)
+    {
+        unroll<s_shells - 1>([&](auto s) {
+            constexpr auto l = decltype(s)::value + 1;
+            constexpr auto size = s_sizes[l];
+            constexpr auto fanIn = s_sizes[l - 1];
+            const auto* weights = parameters + s_parameterOffsets[l];
+            const auto* biases = weights + size * fanIn;
+            const auto* prev = nodes + s_nodeOffsets[l - 1];
+            auto* out = nodes + s_nodeOffsets[l];
+
+            unroll<size>([&](auto n) {
+                auto sum = static_cast<Acc>(biases[n]);
+                unroll<fanIn>([&](auto i) {
+                    sum += static_cast<Acc>(weights[n * fanIn + i]) * static_cast<Acc>(prev[i]);
+                });
+                out[n] = activationFunction(static_cast<T>(sum));
+            });
+        });
+    }
+
+    // Gradient of every node behind the input shell, for one sample
+    void nodeGradients(const T* nodes, const T* target, T* gradients) const
+    {
+        const auto* output = nodes + s_nodeOffsets[s_shells - 1];
+        auto* outputGradients = gradients + s_nodeOffsets[s_shells - 1];
+        unroll<s_outputs>([&](auto n) {
+            outputGradients[n] = (target[n] - output[n]) * activationDerivative(output[n]);
+        });
+
+        // Hidden shells, back to front
+        unrollReverse<s_shells - 2>([&](auto s) {
+            constexpr auto l = decltype(s)::value + 1;
+            constexpr auto size = s_sizes[l];
+            constexpr auto nextSize = s_sizes[l + 1];
+            const auto* nextWeights = m_parameters.data() + s_parameterOffsets[l + 1];
+            const auto* nextGradients = gradients + s_nodeOffsets[l + 1];
+            const auto* out = nodes + s_nodeOffsets[l];
+            auto* hidden = gradients + s_nodeOffsets[l];
+
+            unroll<size>([&](auto n) {
+                Acc sum = 0.0;
+                unroll<nextSize>([&](auto r) {
+                    sum += static_cast<Acc>(nextWeights[r * size + n]) *
+                           static_cast<Acc>(nextGradients[r]);
+                });
+                hidden[n] = static_cast<T>(sum) * activationDerivative(out[n]);
+            });
+        });
+    }
+
+    // Adds one sample's weight and bias gradients to a parameter sized buffer
+    static void accumulate(const T* nodes, const T* gradients, T* parameterGradients)
+    {
+        unroll<s_shells - 1>([&](auto s) {
+            constexpr auto l = decltype(s)::value + 1;
+            constexpr auto size = s_sizes[l];
+            constexpr auto fanIn = s_sizes[l - 1];
+            auto* weightGradients = parameterGradients + s_parameterOffsets[l];
+            const auto* prev = nodes + s_nodeOffsets[l - 1];
+            const auto* shellGradients = gradients + s_nodeOffsets[l];
+
+            unroll<size>([&](auto n) {
+                unroll<fanIn>([&](auto i) {
+                    weightGradients[n * fanIn + i] += shellGradients[n] * prev[i];
+                });
+                weightGradients[size * fanIn + n] += shellGradients[n];
+            });
+        });
+    }
+
+    static double rmsError(const T* outputs, const T* target)
+    {
+        auto error = 0.0;
+        unroll<s_outputs>([&](auto n) {
+            const auto delta = static_cast<double>(target[n] - outputs[n]);
+            error += delta * delta;
+        });
+
+        return sqrt(error / static_cast<double>(s_outputs));
+    }
+
+    void trackError(const T* outputs, const T* target)
+    {
+        m_error = rmsError(outputs, target);
+        m_recentAvgError = (m_recentAvgError * m_recentAvgSmoothingFactor + m_error) /
+                           (m_recentAvgSmoothingFactor + 1.0);
+    }
+
+    static inline T activationFunction(T sum) { return std::tanh(sum); }
+    static inline T activationDerivative(T x) { return T(1) - x * x; }
+
+    static T randomWeight()
+    {
+        static std::random_device rd;
+        static std::mt19937 rng(rd());
+        static std::uniform_real_distribution<T> dist(0, 1);
+
+        return dist(rng);
+    }
+
+private:
+    std::array<T, s_parameterCount> m_parameters{};
+    std::array<T, s_parameterCount> m_gradients{};
+    std::array<T, s_nodeCount> m_nodes{};
+    std::array<T, s_nodeCount> m_nodeGradients{};
+    unsigned long m_batchSize = 0;
+    std::vector<T> m_batchNodes;
+    std::vector<T> m_batchOutputs;
+    double m_error = 0.0;
+    double m_recentAvgError = 0.0;
+    double m_recentAvgSmoothingFactor = 100.0;
+    Optimizer<T> m_optimizer;
+    bool m_valid = true;
+};
+
+template <unsigned long... Sizes>
+using StaticNetwork = BasicStaticNetwork<double, double, Sizes...>;
+template <unsigned long... Sizes>
+using StaticNetworkF32 = BasicStaticNetwork<float, float, Sizes...>;
+template <unsigned long... Sizes>
+using StaticNetworkMixed = BasicStaticNetwork<float, double, Sizes...>;
+
+} // namespace Engine
@@ -0,0 +1,105 @@
+// clang-format off
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include <algorithm>
+// clang-format on
+
+namespace Engine {
+
+ThreadPool::ThreadPool(unsigned int workers)
+{
+    m_threads.reserve(workers);
+    for (auto i = 0u; i < workers; ++i)
+        m_threads.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_wake.notify_all();
+    for (auto& t : m_threads)
+        t.join();
+}
+
+unsigned int ThreadPool::defaultWorkers()
+{
+    const auto hw = std::thread::hardware_concurrency();
+    return hw > 1 ? hw - 1 : 0;
+}
+
+void ThreadPool::run(unsigned long count, unsigned long grain, RangeFn fn, void* ctx)
+{
+    if (count == 0)
+        return;
+
+    grain = std::max(grain, 1ul);
+    const auto maxChunks = static_cast<unsigned long>(m_threads.size()) + 1;
+    const auto chunks = std::min(maxChunks, (count + grain - 1) / grain);
+
+    std::unique_lock submit(m_submitMutex, std::try_to_lock);
+    if (chunks <= 1 || !submit.owns_lock())
+    {
+        fn(ctx, 0, count);
+        return;
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_fn = fn;
+        m_ctx = ctx;
+        m_count = count;
+        m_chunk = (count + chunks - 1) / chunks;
+        m_next.store(0, std::memory_order_relaxed);
+        m_busy = static_cast<unsigned int>(m_threads.size());
+        ++m_generation;
+    }
+
+    m_wake.notify_all();
+    drainChunks();
+
+    std::unique_lock lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+}
+
+void ThreadPool::workerLoop()
+{
+    ENGINE_PROFILE_THREAD("pool worker");
+    std::uint64_t seen = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stopping || m_generation != seen; });
+            if (m_stopping)
+                return;
+
+            seen = m_generation;
+        }
+
+        drainChunks();
+
+        std::lock_guard lock(m_mutex);
+        if (--m_busy == 0)
+            m_done.notify_one();
+    }
+}
+
+void ThreadPool::drainChunks()
+{
+    while (true)
+    {
+        const auto begin = m_next.fetch_add(m_chunk, std::memory_order_relaxed);
+        if (begin >= m_count)
+            return;
+
+        ENGINE_PROFILE_SCOPE("chunk");
+        m_fn(m_ctx, begin, std::min(begin + m_chunk, m_count));
+    }
+}
+
+} // namespace Engine
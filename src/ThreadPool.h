@@ -0,0 +1,70 @@
+/* A fixed set of worker threads kept alive for the lifetime of the pool. Work is handed out as
+ * contiguous index ranges and the submitting thread always takes part, so a pool of N workers
+ * keeps N + 1 cores busy. Only one range job runs at a time, a submission made while the pool
+ * is busy (another network, or a nested call) runs inline on the caller instead of queueing. */
+#pragma once
+
+// clang-format off
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+class ThreadPool
+{
+public:
+    // Defaults to one worker per hardware thread besides the caller's
+    explicit ThreadPool(unsigned int workers = defaultWorkers());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+public:
+    // Calls fn(begin, end) over disjoint ranges covering [0, count) and blocks until all of them
+    // are done. Ranges are never smaller than grain, so small jobs stay on the calling thread.
+    template <typename Fn>
+    void parallelFor(unsigned long count, unsigned long grain, Fn&& fn)
+    {
+        auto invoke = [](void* ctx, unsigned long begin, unsigned long end) {
+            (*static_cast<std::remove_reference_t<Fn>*>(ctx))(begin, end);
+        };
+
+        run(count, grain, invoke, &fn);
+    }
+
+    inline unsigned int workers() const { return static_cast<unsigned int>(m_threads.size()); }
+    static unsigned int defaultWorkers();
+
+private:
+    using RangeFn = void (*)(void* ctx, unsigned long begin, unsigned long end);
+
+    void run(unsigned long count, unsigned long grain, RangeFn fn, void* ctx);
+    void workerLoop();
+    void drainChunks();
+
+private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_submitMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::uint64_t m_generation = 0;
+    unsigned int m_busy = 0;
+    bool m_stopping = false;
+
+    // Current job, only valid while m_busy is non-zero or the submitter is draining
+    RangeFn m_fn = nullptr;
+    void* m_ctx = nullptr;
+    unsigned long m_count = 0;
+    unsigned long m_chunk = 0;
+    std::atomic<unsigned long> m_next = 0;
+};
+
+} // namespace Engine
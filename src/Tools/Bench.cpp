@@ -0,0 +1,558 @@
+// Microbenchmarks of the engine in the style of Google Benchmark: forward and backward passes,
+// training steps, text parsing and checkpoint loading over a matrix of topologies, batch sizes
+// and thread counts.
+//
+//   bench [--benchmark_filter=regex] [--benchmark_min_time=seconds] [--benchmark_list_tests]
+//         [--benchmark_format=console|json] [--benchmark_out=file.json]
+//         [--benchmark_threads=1,4] [--benchmark_batches=1,32,256]
+//
+// Every benchmark reports time per iteration and, derived from what one iteration does:
+//   ns/sample     time per sample, a sample being one row of a batch, one parsed sample or one
+//                 loaded checkpoint
+//   GFLOP/s       multiply-adds count as two, a training step as three forward passes
+//   bytes/sample  the least memory traffic the work implies: parameters read once per pass over
+//                 a batch, read again and written with the optimizer state when training
+// The JSON output follows Google Benchmark's layout so the same tooling can compare two runs.
+
+// clang-format off
+#include "../Checkpoint.h"
+#include "../Kernels.h"
+#include "../Logging.h"
+#include "../Network.h"
+#include "../TrainingData.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+// clang-format on
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double cpuSeconds()
+{
+    timespec now{};
+    ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9;
+}
+
+// Runs the timed loop of one benchmark. Setup outside the loop is not timed, work inside it
+// can be left out with pauseTiming() and resumeTiming().
+class State
+{
+public:
+    explicit State(unsigned long iterations)
+        : m_iterations(iterations)
+    {
+    }
+
+    // while (state.keepRunning()) { ... } runs the body the requested number of times
+    bool keepRunning()
+    {
+        if (m_done == 0 && !m_running)
+            resumeTiming();
+
+        if (m_done++ < m_iterations)
+            return true;
+
+        pauseTiming();
+        return false;
+    }
+
+    // The CPU window sits inside the wall one, so the wall clock reads stay out of the CPU time
+    void pauseTiming()
+    {
+        m_cpuSeconds += cpuSeconds() - m_cpuStart;
+        m_seconds += std::chrono::duration<double>(Clock::now() - m_start).count();
+        m_running = false;
+    }
+
+    void resumeTiming()
+    {
+        m_running = true;
+        m_start = Clock::now();
+        m_cpuStart = cpuSeconds();
+    }
+
+    inline unsigned long iterations() const { return m_iterations; }
+    inline double seconds() const { return m_seconds; }
+    inline double cpuTime() const { return m_cpuSeconds; }
+
+    // What a single iteration does, for the derived rates
+    double samples = 1.0;
+    double flops = 0.0;
+    double bytes = 0.0;
+
+private:
+    unsigned long m_iterations;
+    unsigned long m_done = 0;
+    bool m_running = false;
+    Clock::time_point m_start;
+    double m_cpuStart = 0.0;
+    double m_seconds = 0.0;
+    double m_cpuSeconds = 0.0;
+};
+
+struct Benchmark
+{
+    std::string name;
+    std::function<void(State&)> run;
+};
+
+struct Result
+{
+    std::string name;
+    unsigned long iterations;
+    double realNs; // per iteration
+    double cpuNs;
+    double nsPerSample;
+    double gflops;
+    double bytesPerSample;
+    double samplesPerSecond;
+};
+
+struct Options
+{
+    std::regex filter{".*"};
+    double minTime = 0.2;
+    bool list = false;
+    bool json = false;
+    std::string out;
+    std::vector<unsigned int> threads;
+    std::vector<unsigned long> batches{1, 32, 256};
+};
+
+using Topology = std::vector<unsigned long>;
+
+std::string topologyName(const Topology& topology)
+{
+    std::string name;
+    for (auto size : topology)
+    {
+        if (!name.empty())
+            name += '-';
+        name += std::to_string(size);
+    }
+
+    return name;
+}
+
+// Multiply-adds of one forward pass of one sample, biases included
+double forwardFlops(const Topology& topology)
+{
+    auto flops = 0.0;
+    for (auto l = 1ul; l < topology.size(); ++l)
+        flops += 2.0 * static_cast<double>(topology[l] * (topology[l - 1] + 1));
+    return flops;
+}
+
+std::vector<double> randomValues(unsigned long count, double low, double high)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(low, high);
+    std::vector<double> values(count);
+    for (auto& value : values)
+        value = dist(rng);
+    return values;
+}
+
+void makeNetwork(Engine::Network& network, unsigned int threads)
+{
+    // The calling thread is one of them
+    if (threads > 1)
+        network.setThreads(threads - 1);
+}
+
+void addNetworkBenchmarks(std::vector<Benchmark>& benchmarks, const Topology& topology,
+                          const Options& options)
+{
+    const auto name = topologyName(topology);
+    const auto flops = forwardFlops(topology);
+
+    auto parameterBytes = 0.0;
+    for (auto l = 1ul; l < topology.size(); ++l)
+        parameterBytes += static_cast<double>(topology[l] * (topology[l - 1] + 1) * sizeof(double));
+    const auto ioBytes = static_cast<double>((topology.front() + topology.back()) * sizeof(double));
+
+    for (auto threads : options.threads)
+    {
+        const auto suffix = "/threads:" + std::to_string(threads);
+
+        benchmarks.push_back({"forward/" + name + suffix, [=](State& state) {
+                                  Engine::Network network(topology);
+                                  makeNetwork(network, threads);
+                                  const auto input = randomValues(topology.front(), -1.0, 1.0);
+
+                                  state.flops = flops;
+                                  state.bytes = parameterBytes + ioBytes;
+                                  while (state.keepRunning())
+                                      network.forward(input);
+                              }});
+
+        // Backward on its own, the forward pass it needs is not timed
+        benchmarks.push_back({"backward/" + name + suffix, [=](State& state) {
+                                  Engine::Network network(topology);
+                                  makeNetwork(network, threads);
+                                  const auto input = randomValues(topology.front(), -1.0, 1.0);
+                                  const auto target = randomValues(topology.back(), -0.5, 0.5);
+
+                                  state.flops = 2.0 * flops;
+                                  state.bytes = 2.0 * parameterBytes + ioBytes;
+                                  while (state.keepRunning())
+                                  {
+                                      state.pauseTiming();
+                                      network.forward(input);
+                                      state.resumeTiming();
+                                      network.backward(target);
+                                  }
+                              }});
+
+        for (auto batch : options.batches)
+        {
+            const auto batchSuffix = "/batch:" + std::to_string(batch) + suffix;
+            const auto samples = static_cast<double>(batch);
+
+            benchmarks.push_back(
+                {"forward_batch/" + name + batchSuffix, [=](State& state) {
+                     Engine::Network network(topology);
+                     makeNetwork(network, threads);
+                     const auto inputs = randomValues(batch * topology.front(), -1.0, 1.0);
+
+                     state.samples = samples;
+                     state.flops = flops * samples;
+                     state.bytes = parameterBytes + ioBytes * samples;
+                     while (state.keepRunning())
+                         network.forwardBatch(inputs, batch);
+                 }});
+
+            // A full training step: forward, backward and the optimizer's update. Batch 1 is
+            // the per-sample path the application trains with.
+            benchmarks.push_back(
+                {"train_step/" + name + batchSuffix, [=](State& state) {
+                     Engine::Network network(topology);
+                     makeNetwork(network, threads);
+                     const auto inputs = randomValues(batch * topology.front(), -1.0, 1.0);
+                     const auto targets = randomValues(batch * topology.back(), -0.5, 0.5);
+
+                     // Parameters are read by both passes, then read and written with the
+                     // momentum by the update
+                     state.samples = samples;
+                     state.flops = 3.0 * flops * samples;
+                     state.bytes = 5.0 * parameterBytes + ioBytes * samples;
+                     while (state.keepRunning())
+                     {
+                         if (batch == 1)
+                         {
+                             network.forward(inputs);
+                             network.backward(targets);
+                         }
+                         else
+                         {
+                             network.forwardBatch(inputs, batch);
+                             network.backwardBatch(targets);
+                         }
+                     }
+                 }});
+        }
+    }
+
+    benchmarks.push_back({"checkpoint_load/" + name, [=](State& state) {
+                              const auto path = std::filesystem::temp_directory_path() /
+                                                ("bench-" + name + ".ckpt");
+                              Engine::Network network(topology);
+                              std::string error;
+                              if (!Engine::Checkpoint::save(network, {}, path.string(), error))
+                              {
+                                  std::cerr << "could not write " << path << ": " << error
+                                            << '\n';
+                                  return;
+                              }
+
+                              // The file stays in the page cache, this is mapping, validation
+                              // and the copy into the network
+                              state.bytes = static_cast<double>(std::filesystem::file_size(path));
+                              while (state.keepRunning())
+                              {
+                                  const Engine::Checkpoint checkpoint(path.string());
+                                  checkpoint.restore(network);
+                              }
+
+                              std::filesystem::remove(path);
+                          }});
+}
+
+void addParsingBenchmark(std::vector<Benchmark>& benchmarks)
+{
+    static constexpr unsigned long s_samples = 20000;
+    static constexpr unsigned long s_inputs = 16;
+    static constexpr unsigned long s_targets = 4;
+
+    benchmarks.push_back({"training_data_parse/16-4", [](State& state) {
+                              const auto path =
+                                  std::filesystem::temp_directory_path() / "bench-parse.dat";
+                              {
+                                  const auto values =
+                                      randomValues(s_samples * (s_inputs + s_targets), -1, 1);
+                                  std::ofstream out(path);
+                                  for (auto i = 0ul; i < values.size(); ++i)
+                                  {
+                                      const auto column = i % (s_inputs + s_targets);
+                                      out << values[i]
+                                          << (column + 1 == s_inputs ||
+                                                      column + 1 == s_inputs + s_targets
+                                                  ? '\n'
+                                                  : ' ');
+                                  }
+                              }
+
+                              std::vector<double> inputs(s_inputs);
+                              std::vector<double> targets(s_targets);
+                              state.samples = static_cast<double>(s_samples);
+                              state.bytes = static_cast<double>(std::filesystem::file_size(path));
+                              while (state.keepRunning())
+                              {
+                                  Engine::TrainingData data(path.string());
+                                  while (data.readSample(inputs, targets))
+                                      ;
+                              }
+
+                              std::filesystem::remove(path);
+                          }});
+}
+
+// Grows the iteration count until a run takes at least the minimum time, as Google Benchmark
+// does, and reports the last run
+Result run(const Benchmark& benchmark, double minTime)
+{
+    auto iterations = 1ul;
+    while (true)
+    {
+        State state(iterations);
+        benchmark.run(state);
+
+        const auto seconds = state.seconds();
+        if (seconds >= minTime || iterations >= 1'000'000'000ul)
+        {
+            const auto perIteration = seconds / static_cast<double>(iterations);
+            const auto samplesPerSecond = state.samples / perIteration;
+            return {benchmark.name,
+                    iterations,
+                    perIteration * 1e9,
+                    state.cpuTime() / static_cast<double>(iterations) * 1e9,
+                    perIteration * 1e9 / state.samples,
+                    state.flops / perIteration * 1e-9,
+                    state.bytes / state.samples,
+                    samplesPerSecond};
+        }
+
+        // Aim a little past the minimum, but never grow more than tenfold from one short run
+        const auto factor = seconds > 0.0 ? 1.4 * minTime / seconds : 10.0;
+        iterations = static_cast<unsigned long>(
+            std::max(static_cast<double>(iterations) + 1.0,
+                     static_cast<double>(iterations) * std::min(factor, 10.0)));
+    }
+}
+
+void printConsoleHeader(unsigned long width)
+{
+    std::printf("Kernels: %s, %u hardware threads\n", Engine::Kernels::active().name,
+                std::thread::hardware_concurrency());
+    std::printf("%-*s %14s %14s %12s %12s %10s %14s\n", static_cast<int>(width), "Benchmark",
+                "Time", "CPU", "Iterations", "ns/sample", "GFLOP/s", "bytes/sample");
+    std::printf("%s\n", std::string(width + 84, '-').c_str());
+}
+
+void printConsole(const Result& result, unsigned long width)
+{
+    std::printf("%-*s %11.0f ns %11.0f ns %12lu %12.1f %10.3f %14.0f\n", static_cast<int>(width),
+                result.name.c_str(), result.realNs, result.cpuNs, result.iterations,
+                result.nsPerSample, result.gflops, result.bytesPerSample);
+    std::fflush(stdout);
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results)
+{
+    char date[64];
+    const auto now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+    char host[256] = {};
+    ::gethostname(host, sizeof(host) - 1);
+
+#ifdef DEBUG_BUILD
+    const auto buildType = "debug";
+#else
+    const auto buildType = "release";
+#endif
+
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+        << "    \"host_name\": \"" << host << "\",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+        << "    \"kernels\": \"" << Engine::Kernels::active().name << "\",\n"
+        << "    \"library_build_type\": \"" << buildType << "\"\n"
+        << "  },\n  \"benchmarks\": [";
+
+    for (auto i = 0ul; i < results.size(); ++i)
+    {
+        const auto& result = results[i];
+        out << (i ? "," : "") << "\n    {\n"
+            << "      \"name\": \"" << result.name << "\",\n"
+            << "      \"run_type\": \"iteration\",\n"
+            << "      \"iterations\": " << result.iterations << ",\n"
+            << "      \"real_time\": " << result.realNs << ",\n"
+            << "      \"cpu_time\": " << result.cpuNs << ",\n"
+            << "      \"time_unit\": \"ns\",\n"
+            << "      \"ns_per_sample\": " << result.nsPerSample << ",\n"
+            << "      \"samples_per_second\": " << result.samplesPerSecond << ",\n"
+            << "      \"gflops\": " << result.gflops << ",\n"
+            << "      \"bytes_per_sample\": " << result.bytesPerSample << "\n    }";
+    }
+
+    out << "\n  ]\n}\n";
+}
+
+template <typename T, typename Parse>
+bool parseList(const std::string& text, std::vector<T>& values, Parse&& parse)
+{
+    values.clear();
+    for (auto begin = 0ul; begin <= text.size();)
+    {
+        auto end = text.find(',', begin);
+        if (end == std::string::npos)
+            end = text.size();
+
+        const auto value = parse(text.substr(begin, end - begin));
+        if (value == 0)
+            return false;
+
+        values.push_back(static_cast<T>(value));
+        begin = end + 1;
+    }
+
+    return !values.empty();
+}
+
+bool parse(int argc, char** argv, Options& options)
+{
+    auto toNumber = [](const std::string& text) { return std::strtoul(text.c_str(), nullptr, 10); };
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        const auto equals = argument.find('=');
+        const auto flag = argument.substr(0, equals);
+        const auto value = equals == std::string::npos ? "" : argument.substr(equals + 1);
+
+        if (flag == "--benchmark_filter")
+            options.filter = std::regex(value);
+        else if (flag == "--benchmark_min_time" && std::strtod(value.c_str(), nullptr) > 0)
+            options.minTime = std::strtod(value.c_str(), nullptr);
+        else if (flag == "--benchmark_list_tests")
+            options.list = true;
+        else if (flag == "--benchmark_format" && (value == "console" || value == "json"))
+            options.json = value == "json";
+        else if (flag == "--benchmark_out" && !value.empty())
+            options.out = value;
+        else if (flag == "--benchmark_threads" && parseList(value, options.threads, toNumber))
+            continue;
+        else if (flag == "--benchmark_batches" && parseList(value, options.batches, toNumber))
+            continue;
+        else
+            return false;
+    }
+
+    // One thread, and every hardware thread if there is more than one
+    if (options.threads.empty())
+    {
+        options.threads.push_back(1);
+        if (std::thread::hardware_concurrency() > 1)
+            options.threads.push_back(std::thread::hardware_concurrency());
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Engine::Logger::init();
+
+    Options options;
+    if (!parse(argc, argv, options))
+    {
+        std::cerr << "usage: " << argv[0]
+                  << " [--benchmark_filter=regex] [--benchmark_min_time=seconds]"
+                     " [--benchmark_list_tests] [--benchmark_format=console|json]"
+                     " [--benchmark_out=file.json] [--benchmark_threads=1,4]"
+                     " [--benchmark_batches=1,32,256]\n";
+        return 1;
+    }
+
+    // From the smallest network up to shells thousands of nodes wide
+    const std::vector<Topology> topologies{
+        {2, 4, 1}, {16, 64, 64, 4}, {256, 512, 512, 10}, {1024, 2048, 2048, 10}};
+
+    std::vector<Benchmark> all;
+    for (const auto& topology : topologies)
+        addNetworkBenchmarks(all, topology, options);
+    addParsingBenchmark(all);
+
+    std::vector<Benchmark> selected;
+    std::copy_if(all.begin(), all.end(), std::back_inserter(selected),
+                 [&](const Benchmark& benchmark) {
+                     return std::regex_search(benchmark.name, options.filter);
+                 });
+
+    if (options.list)
+    {
+        for (const auto& benchmark : selected)
+            std::cout << benchmark.name << '\n';
+        return 0;
+    }
+
+    auto width = 10ul;
+    for (const auto& benchmark : selected)
+        width = std::max(width, benchmark.name.size());
+
+    if (!options.json)
+        printConsoleHeader(width);
+
+    std::vector<Result> results;
+    for (const auto& benchmark : selected)
+    {
+        results.push_back(run(benchmark, options.minTime));
+        if (!options.json)
+            printConsole(results.back(), width);
+    }
+
+    if (options.json)
+        writeJson(std::cout, results);
+
+    if (!options.out.empty())
+    {
+        std::ofstream out(options.out);
+        writeJson(out, results);
+        if (!out)
+        {
+            std::cerr << "could not write " << options.out << '\n';
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+// Converts a text training set into the binary format read by BinaryDataset.
+//
+//   dat2bin <input.dat> <output.bin> [--float32]
+
+// clang-format off
+#include "../BinaryDataset.h"
+#include "../Logging.h"
+#include <filesystem>
+#include <iostream>
+#include <string>
+// clang-format on
+
+int main(int argc, char** argv)
+{
+    Engine::Logger::init();
+
+    if (argc < 3 || argc > 4 || (argc == 4 && std::string(argv[3]) != "--float32"))
+    {
+        std::cerr << "usage: " << argv[0] << " <input.dat> <output.bin> [--float32]\n";
+        return 1;
+    }
+
+    if (!std::filesystem::exists(argv[1]))
+    {
+        std::cerr << argv[1] << " does not exist\n";
+        return 1;
+    }
+
+    const auto dtype =
+        argc == 4 ? Engine::BinaryDataset::DType::Float32 : Engine::BinaryDataset::DType::Float64;
+
+    std::string error;
+    if (!Engine::BinaryDataset::fromText(argv[1], argv[2], dtype, error))
+    {
+        std::cerr << "conversion failed: " << error << '\n';
+        return 1;
+    }
+
+    Engine::BinaryDataset dataset(argv[2]);
+    if (!dataset.isOpen())
+    {
+        std::cerr << "could not read back " << argv[2] << '\n';
+        return 1;
+    }
+
+    std::cout << "Wrote " << dataset.samples() << " samples (" << dataset.inputWidth()
+              << " inputs, " << dataset.targetWidth() << " targets) to " << argv[2] << '\n';
+
+    return 0;
+}
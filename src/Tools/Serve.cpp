@@ -0,0 +1,603 @@
+// Serves predictions of a checkpoint over a Unix domain socket. Requests arriving at the same
+// time, from any number of connections, are coalesced into one batch evaluated with a single
+// matrix-matrix forward pass.
+//
+//   serve <model.ckpt> [--socket path] [--max-batch n] [--max-delay-us n] [--workers n]
+//         [--report-seconds n]
+//
+// Protocol, all values little endian:
+//   on connect, server to client   u32 inputWidth, u32 outputWidth
+//   request, client to server      u64 id, f64 inputs[inputWidth]
+//   response, server to client     u64 id, f64 outputs[outputWidth]
+//
+// A connection may pipeline any number of requests. Responses carry the id of their request
+// and can come back out of order when more than one worker is running. Responses a client does
+// not read are buffered per connection, and a connection is dropped once too much of them has
+// piled up, so one stalled client never holds up the batches of the others.
+
+// clang-format off
+#include "../Checkpoint.h"
+#include "../InferenceModel.h"
+#include "../Logging.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+// clang-format on
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> s_stop = false;
+
+// Unsent responses a connection may hold before it is dropped
+constexpr unsigned long s_maxPending = 16ul << 20;
+
+void onSignal(int) { s_stop = true; }
+
+struct Options
+{
+    std::string checkpoint;
+    std::string socket = "/tmp/network.sock";
+    unsigned long maxBatch = 64;
+    std::chrono::microseconds maxDelay{500};
+    unsigned long workers = 1;
+    double reportSeconds = 5.0;
+};
+
+bool readFull(int fd, void* data, unsigned long size)
+{
+    auto* bytes = static_cast<char*>(data);
+    while (size > 0)
+    {
+        const auto received = ::recv(fd, bytes, size, 0);
+        if (received <= 0)
+            return false;
+
+        bytes += received;
+        size -= static_cast<unsigned long>(received);
+    }
+
+    return true;
+}
+
+bool writeFull(int fd, const void* data, unsigned long size)
+{
+    const auto* bytes = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        const auto sent = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent <= 0)
+            return false;
+
+        bytes += sent;
+        size -= static_cast<unsigned long>(sent);
+    }
+
+    return true;
+}
+
+struct Connection
+{
+    explicit Connection(int socket)
+        : fd(socket)
+    {
+    }
+
+    ~Connection() { ::close(fd); }
+
+    // Appends responses to the send buffer and sends as much of it as the socket takes without
+    // blocking. Drops the connection when sending fails or the buffer grows past its limit.
+    // Returns whether anything is left for the poll loop to flush. Callers hold writeMutex.
+    bool send(const char* data, unsigned long size)
+    {
+        if (dropped)
+            return false;
+
+        pending.insert(pending.end(), data, data + size);
+        return flush();
+    }
+
+    bool flush()
+    {
+        auto sent = 0ul;
+        while (sent < pending.size())
+        {
+            const auto result = ::send(fd, pending.data() + sent, pending.size() - sent,
+                                       MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if (result <= 0)
+            {
+                drop();
+                return false;
+            }
+
+            sent += static_cast<unsigned long>(result);
+        }
+
+        pending.erase(pending.begin(), pending.begin() + static_cast<long>(sent));
+        if (pending.size() > s_maxPending)
+        {
+            drop();
+            return false;
+        }
+
+        return !pending.empty();
+    }
+
+    // Also wakes the reader, which then returns
+    void drop()
+    {
+        dropped = true;
+        closed = true;
+        pending.clear();
+        ::shutdown(fd, SHUT_RDWR);
+    }
+
+    int fd;
+    std::mutex writeMutex; // responses of one connection may come from several workers
+    std::vector<char> pending; // responses the socket has not taken yet
+    std::atomic<bool> closed = false;   // no more requests are read
+    std::atomic<bool> dropped = false;  // no more responses are sent either
+    std::atomic<bool> finished = false; // the reader has returned
+    std::thread reader;
+};
+
+struct Request
+{
+    std::shared_ptr<Connection> connection;
+    std::uint64_t id;
+    std::vector<double> inputs;
+    Clock::time_point arrived;
+};
+
+// Latencies and batch sizes since the last report
+class Stats
+{
+public:
+    void record(unsigned long batchSize, Clock::time_point done, const Request* requests)
+    {
+        std::lock_guard lock(m_mutex);
+        for (auto i = 0ul; i < batchSize; ++i)
+            m_latencies.push_back(
+                std::chrono::duration<double, std::micro>(done - requests[i].arrived).count());
+        ++m_batches;
+    }
+
+    void report(double seconds)
+    {
+        std::vector<double> latencies;
+        unsigned long batches = 0;
+        {
+            std::lock_guard lock(m_mutex);
+            latencies.swap(m_latencies);
+            batches = m_batches;
+            m_batches = 0;
+        }
+
+        if (latencies.empty())
+            return;
+
+        // Nearest rank percentiles
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&](double p) {
+            const auto rank = static_cast<unsigned long>(p * static_cast<double>(latencies.size()));
+            return latencies[std::min(rank, latencies.size() - 1)];
+        };
+
+        const auto requests = static_cast<double>(latencies.size());
+        std::printf("%.0f requests/s, %.1f per batch, latency p50 %.0fus p99 %.0fus max %.0fus\n",
+                    requests / seconds, requests / static_cast<double>(batches),
+                    percentile(0.5), percentile(0.99), latencies.back());
+        std::fflush(stdout);
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<double> m_latencies;
+    unsigned long m_batches = 0;
+};
+
+template <typename Model>
+class Server
+{
+    using T = typename Model::Scalar;
+
+public:
+    // Workers write to wakeFd whenever a connection is left with responses to flush
+    Server(const Model& model, const Options& options, int wakeFd)
+        : m_model(model)
+        , m_options(options)
+        , m_wakeFd(wakeFd)
+    {
+    }
+
+    // Queues a request, the workers pick it up with whatever else has arrived by then
+    void submit(Request request)
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_queue.push_back(std::move(request));
+        }
+
+        m_arrived.notify_one();
+    }
+
+    // Runs until stop(), then answers what is still queued
+    void work()
+    {
+        const auto inputWidth = m_model.inputWidth();
+        const auto outputWidth = m_model.outputWidth();
+        auto scratch = m_model.makeScratch(m_options.maxBatch);
+        std::vector<Request> batch;
+        std::vector<T> inputs(m_options.maxBatch * inputWidth);
+        std::vector<char> response(sizeof(std::uint64_t) + outputWidth * sizeof(double));
+
+        while (take(batch))
+        {
+            if (batch.empty())
+                continue;
+
+            for (auto i = 0ul; i < batch.size(); ++i)
+                std::transform(batch[i].inputs.begin(), batch[i].inputs.end(),
+                               inputs.begin() + static_cast<long>(i * inputWidth),
+                               [](double value) { return static_cast<T>(value); });
+
+            const auto outputs = m_model.inferBatch(
+                {inputs.data(), batch.size() * inputWidth}, batch.size(), scratch);
+
+            for (auto i = 0ul; i < batch.size(); ++i)
+            {
+                auto& request = batch[i];
+                auto* values = reinterpret_cast<double*>(response.data() + sizeof(request.id));
+                std::memcpy(response.data(), &request.id, sizeof(request.id));
+                for (auto n = 0ul; n < outputWidth; ++n)
+                    values[n] = static_cast<double>(outputs[i * outputWidth + n]);
+
+                std::lock_guard lock(request.connection->writeMutex);
+                if (request.connection->send(response.data(), response.size()))
+                {
+                    const char wake = 0;
+                    [[maybe_unused]] const auto written = ::write(m_wakeFd, &wake, 1);
+                }
+            }
+
+            m_stats.record(batch.size(), Clock::now(), batch.data());
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+
+        m_arrived.notify_all();
+    }
+
+    inline Stats& stats() { return m_stats; }
+
+private:
+    // Waits for a full batch, or until the oldest request has waited the maximum delay. Never
+    // returns an empty batch unless it is stopping.
+    bool take(std::vector<Request>& batch)
+    {
+        batch.clear();
+
+        std::unique_lock lock(m_mutex);
+        auto count = 0ul;
+        while (count == 0)
+        {
+            m_arrived.wait(lock, [this] { return !m_queue.empty() || m_stopping; });
+            if (m_queue.empty())
+                return false;
+
+            const auto deadline = m_queue.front().arrived + m_options.maxDelay;
+            m_arrived.wait_until(lock, deadline, [this] {
+                return m_queue.size() >= m_options.maxBatch || m_stopping;
+            });
+
+            // Another worker may have taken the queue while this one was waiting
+            count = std::min(m_queue.size(), m_options.maxBatch);
+        }
+
+        for (auto i = 0ul; i < count; ++i)
+        {
+            batch.push_back(std::move(m_queue.front()));
+            m_queue.pop_front();
+        }
+
+        // Whatever is left already waited long enough to be worth another worker
+        if (!m_queue.empty())
+            m_arrived.notify_one();
+
+        return true;
+    }
+
+private:
+    const Model& m_model;
+    const Options& m_options;
+    int m_wakeFd;
+    std::mutex m_mutex;
+    std::condition_variable m_arrived;
+    std::deque<Request> m_queue;
+    bool m_stopping = false;
+    Stats m_stats;
+};
+
+template <typename Model>
+void readRequests(Server<Model>& server, std::shared_ptr<Connection> connection,
+                  unsigned long inputWidth)
+{
+    Request request;
+    request.connection = connection;
+    request.inputs.resize(inputWidth);
+
+    while (!connection->closed &&
+           readFull(connection->fd, &request.id, sizeof(request.id)) &&
+           readFull(connection->fd, request.inputs.data(), inputWidth * sizeof(double)))
+    {
+        request.arrived = Clock::now();
+        server.submit(request);
+    }
+
+    connection->closed = true;
+    connection->finished = true;
+}
+
+int listenOn(const std::string& path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "socket path " << path << " is too long\n";
+        return -1;
+    }
+
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    ::unlink(path.c_str());
+
+    const auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0)
+    {
+        std::cerr << "could not listen on " << path << ": " << std::strerror(errno) << '\n';
+        if (fd >= 0)
+            ::close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+template <typename Model>
+int serve(const Model& model, const Options& options)
+{
+    const auto listener = listenOn(options.socket);
+    if (listener < 0)
+        return 1;
+
+    // Non-blocking on both ends, a full pipe already means the poll loop will wake up
+    int wake[2];
+    if (::pipe(wake) != 0)
+    {
+        std::cerr << "could not create a pipe: " << std::strerror(errno) << '\n';
+        ::close(listener);
+        return 1;
+    }
+    for (auto fd : wake)
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    Server<Model> server(model, options, wake[1]);
+    std::vector<std::thread> workers;
+    for (auto i = 0ul; i < options.workers; ++i)
+        workers.emplace_back([&server] { server.work(); });
+
+    std::cout << "Serving " << options.checkpoint << " on " << options.socket << " ("
+              << model.inputWidth() << " inputs, " << model.outputWidth() << " outputs)\n";
+
+    const std::uint32_t widths[2] = {static_cast<std::uint32_t>(model.inputWidth()),
+                                     static_cast<std::uint32_t>(model.outputWidth())};
+
+    std::list<std::shared_ptr<Connection>> connections;
+    std::vector<pollfd> polled;
+    std::vector<Connection*> flushing;
+
+    // Polls the connections with buffered responses for room to send more
+    auto flushAll = [&](pollfd* first, int timeout) {
+        polled.assign(first, first + (first ? 2 : 0));
+        flushing.clear();
+        for (auto& connection : connections)
+        {
+            std::lock_guard lock(connection->writeMutex);
+            if (!connection->pending.empty())
+            {
+                polled.push_back({connection->fd, POLLOUT, 0});
+                flushing.push_back(connection.get());
+            }
+        }
+
+        if (polled.empty())
+            return 0;
+
+        const auto ready = ::poll(polled.data(), polled.size(), timeout);
+        const auto offset = polled.size() - flushing.size();
+        for (auto i = 0ul; ready > 0 && i < flushing.size(); ++i)
+        {
+            if (polled[offset + i].revents == 0)
+                continue;
+
+            std::lock_guard lock(flushing[i]->writeMutex);
+            flushing[i]->flush();
+        }
+
+        return ready;
+    };
+
+    auto lastReport = Clock::now();
+    while (!s_stop)
+    {
+        // Wakes up regularly to report and to notice a signal
+        pollfd events[2] = {{listener, POLLIN, 0}, {wake[0], POLLIN, 0}};
+        if (flushAll(events, 100) > 0 && polled[1].revents)
+        {
+            char drain[64];
+            while (::read(wake[0], drain, sizeof(drain)) > 0)
+            {
+            }
+        }
+
+        if (polled[0].revents)
+        {
+            const auto fd = ::accept(listener, nullptr, nullptr);
+            if (fd >= 0)
+            {
+                auto connection = std::make_shared<Connection>(fd);
+                if (writeFull(fd, widths, sizeof(widths)))
+                {
+                    connection->reader = std::thread(readRequests<Model>, std::ref(server),
+                                                     connection, model.inputWidth());
+                    connections.push_back(std::move(connection));
+                }
+            }
+        }
+
+        // Connections are dropped once their reader is done with them and their responses are
+        // out. Requests still queued keep a connection alive until they are answered.
+        for (auto it = connections.begin(); it != connections.end();)
+        {
+            std::unique_lock lock((*it)->writeMutex);
+            const auto done = (*it)->finished && (*it)->pending.empty();
+            lock.unlock();
+
+            if (done)
+            {
+                (*it)->reader.join();
+                it = connections.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        const auto now = Clock::now();
+        const auto elapsed = std::chrono::duration<double>(now - lastReport).count();
+        if (elapsed >= options.reportSeconds)
+        {
+            server.stats().report(elapsed);
+            lastReport = now;
+        }
+    }
+
+    ::close(listener);
+    ::unlink(options.socket.c_str());
+
+    // Readers stop at the next request, queued requests are still answered
+    for (auto& connection : connections)
+        ::shutdown(connection->fd, SHUT_RD);
+    for (auto& connection : connections)
+        connection->reader.join();
+
+    server.stop();
+    for (auto& worker : workers)
+        worker.join();
+
+    // Buffered responses get a last chance to go out
+    const auto deadline = Clock::now() + std::chrono::seconds(1);
+    while (Clock::now() < deadline && flushAll(nullptr, 100) >= 0 && !flushing.empty())
+    {
+    }
+
+    ::close(wake[0]);
+    ::close(wake[1]);
+
+    server.stats().report(std::chrono::duration<double>(Clock::now() - lastReport).count());
+    return 0;
+}
+
+bool parse(int argc, char** argv, Options& options)
+{
+    if (argc < 2)
+        return false;
+
+    options.checkpoint = argv[1];
+    for (auto i = 2; i < argc; ++i)
+    {
+        const std::string flag = argv[i];
+        if (i + 1 == argc)
+            return false;
+
+        const std::string value = argv[++i];
+        const auto number = std::strtod(value.c_str(), nullptr);
+        if (flag == "--socket")
+            options.socket = value;
+        else if (flag == "--max-batch" && number >= 1)
+            options.maxBatch = static_cast<unsigned long>(number);
+        else if (flag == "--max-delay-us" && number >= 0)
+            options.maxDelay = std::chrono::microseconds(static_cast<long>(number));
+        else if (flag == "--workers" && number >= 1)
+            options.workers = static_cast<unsigned long>(number);
+        else if (flag == "--report-seconds" && number > 0)
+            options.reportSeconds = number;
+        else
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Engine::Logger::init();
+
+    Options options;
+    if (!parse(argc, argv, options))
+    {
+        std::cerr << "usage: " << argv[0]
+                  << " <model.ckpt> [--socket path] [--max-batch n] [--max-delay-us n]"
+                     " [--workers n] [--report-seconds n]\n";
+        return 1;
+    }
+
+    auto checkpoint = std::make_shared<const Engine::Checkpoint>(options.checkpoint);
+    if (!checkpoint->isOpen())
+    {
+        std::cerr << "could not load " << options.checkpoint << '\n';
+        return 1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    // Weights are read from the mapping in place, in the precision they were saved in
+    if (checkpoint->dtype() == Engine::Checkpoint::DType::Float32)
+        return serve(Engine::InferenceModelF32(checkpoint), options);
+
+    return serve(Engine::InferenceModel(checkpoint), options);
+}
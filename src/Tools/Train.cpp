@@ -0,0 +1,320 @@
+// Trains a network without a window. Takes the same data as the application, text or binary,
+// and writes checkpoints while it trains, so an interrupted run can be resumed.
+//
+//   train --topology 2,4,1 --data <data.dat|data.bin> [--epochs n] [--batch n] [--threads n]
+//         [--checkpoint path] [--checkpoint-seconds n] [--resume] [--validation fraction]
+//         [--optimizer momentum|nesterov|rmsprop|adam] [--learning-rate r] [--profile path]
+//
+// --epochs 0 keeps training until the run is interrupted. --threads splits every shell across a
+// pool of that many workers, 0 trains on the calling thread only. --resume continues from the
+// checkpoint if there is one, with the epoch after the last one it completed. --profile writes a
+// Chrome trace of the run, in builds configured with ENGINE_PROFILE.
+
+// clang-format off
+#include "../BinaryDataset.h"
+#include "../Checkpoint.h"
+#include "../IndexedDataset.h"
+#include "../Logging.h"
+#include "../Network.h"
+#include "../Profiler.h"
+#include "../TrainingData.h"
+#include "../TrainingJob.h"
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+// clang-format on
+
+namespace {
+
+std::atomic<bool> s_stop = false;
+
+void onSignal(int) { s_stop = true; }
+
+struct Options
+{
+    std::vector<unsigned long> topology;
+    std::string data;
+    unsigned long epochs = 1;
+    unsigned long batchSize = 1;
+    unsigned int threads = 0;
+    std::string checkpoint = "network.ckpt";
+    double checkpointSeconds = 60.0;
+    bool resume = false;
+    double validation = 0.1;
+    std::optional<Engine::OptimizerType> optimizer;
+    std::optional<double> learningRate;
+    std::string profile;
+};
+
+// Numbers have to be the whole of their argument, so "abc", "-1" or "2.7" are not a count
+std::optional<unsigned long> parseCount(const std::string& text)
+{
+    auto count = 0ul;
+    const auto end = text.data() + text.size();
+    const auto [last, error] = std::from_chars(text.data(), end, count);
+    if (error != std::errc() || last != end)
+        return std::nullopt;
+
+    return count;
+}
+
+std::optional<double> parseReal(const std::string& text)
+{
+    auto real = 0.0;
+    const auto end = text.data() + text.size();
+    const auto [last, error] = std::from_chars(text.data(), end, real);
+    if (error != std::errc() || last != end)
+        return std::nullopt;
+
+    return real;
+}
+
+std::vector<unsigned long> parseTopology(const std::string& text)
+{
+    std::vector<unsigned long> topology;
+    for (auto begin = 0ul; begin <= text.size();)
+    {
+        auto end = text.find(',', begin);
+        if (end == std::string::npos)
+            end = text.size();
+
+        const auto size = parseCount(text.substr(begin, end - begin));
+        if (!size || *size == 0)
+            return {};
+
+        topology.push_back(*size);
+        begin = end + 1;
+    }
+
+    return topology.size() >= 2 ? topology : std::vector<unsigned long>{};
+}
+
+std::optional<Engine::OptimizerType> parseOptimizer(const std::string& name)
+{
+    if (name == "momentum")
+        return Engine::OptimizerType::Momentum;
+    if (name == "nesterov")
+        return Engine::OptimizerType::Nesterov;
+    if (name == "rmsprop")
+        return Engine::OptimizerType::RmsProp;
+    if (name == "adam")
+        return Engine::OptimizerType::Adam;
+
+    return std::nullopt;
+}
+
+bool parse(int argc, char** argv, Options& options)
+{
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::string flag = argv[i];
+        if (flag == "--resume")
+        {
+            options.resume = true;
+            continue;
+        }
+
+        if (i + 1 == argc)
+            return false;
+
+        const std::string value = argv[++i];
+        const auto count = parseCount(value);
+        const auto real = parseReal(value);
+        if (flag == "--topology")
+            options.topology = parseTopology(value);
+        else if (flag == "--data")
+            options.data = value;
+        else if (flag == "--epochs" && count)
+            options.epochs = *count;
+        else if (flag == "--batch" && count && *count >= 1)
+            options.batchSize = *count;
+        else if (flag == "--threads" && count && *count <= std::numeric_limits<unsigned int>::max())
+            options.threads = static_cast<unsigned int>(*count);
+        else if (flag == "--checkpoint")
+            options.checkpoint = value;
+        else if (flag == "--checkpoint-seconds" && real && *real > 0)
+            options.checkpointSeconds = *real;
+        else if (flag == "--validation" && real && *real >= 0 && *real < 1)
+            options.validation = *real;
+        else if (flag == "--optimizer" && parseOptimizer(value))
+            options.optimizer = parseOptimizer(value);
+        else if (flag == "--learning-rate" && real && *real > 0)
+            options.learningRate = *real;
+        else if (flag == "--profile")
+            options.profile = value;
+        else
+            return false;
+    }
+
+    return !options.topology.empty() && !options.data.empty();
+}
+
+// Binary data is used in place, text data is parsed once into memory
+std::unique_ptr<Engine::IndexedDataset> loadData(const Options& options,
+                                                 std::unique_ptr<Engine::BinaryDataset>& binary)
+{
+    const auto inputWidth = options.topology.front();
+    const auto targetWidth = options.topology.back();
+
+    if (std::filesystem::path(options.data).extension() == ".bin")
+    {
+        binary = std::make_unique<Engine::BinaryDataset>(options.data);
+        if (!binary->isOpen())
+            return nullptr;
+
+        if (binary->inputWidth() != inputWidth || binary->targetWidth() != targetWidth)
+        {
+            std::cerr << options.data << " holds " << binary->inputWidth() << " inputs and "
+                      << binary->targetWidth() << " targets per sample\n";
+            return nullptr;
+        }
+
+        return std::make_unique<Engine::IndexedDataset>(*binary);
+    }
+
+    Engine::TrainingData text(options.data);
+    auto data = std::make_unique<Engine::IndexedDataset>(text, inputWidth, targetWidth);
+    if (data->hasError())
+        std::cerr << "training data error: " << data->error() << '\n';
+
+    return data;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Engine::Logger::init();
+
+    Options options;
+    if (!parse(argc, argv, options))
+    {
+        std::cerr << "usage: " << argv[0]
+                  << " --topology 2,4,1 --data <data.dat|data.bin>"
+                     " [--epochs n, 0 until interrupted] [--batch n]"
+                     " [--threads n] [--checkpoint path] [--checkpoint-seconds n] [--resume]"
+                     " [--validation fraction] [--optimizer momentum|nesterov|rmsprop|adam]"
+                     " [--learning-rate r] [--profile path]\n";
+        return 1;
+    }
+
+    if (!std::filesystem::exists(options.data))
+    {
+        std::cerr << options.data << " does not exist\n";
+        return 1;
+    }
+
+    std::unique_ptr<Engine::BinaryDataset> binary;
+    const auto data = loadData(options, binary);
+    if (!data || data->samples() == 0)
+    {
+        std::cerr << "no samples in " << options.data << '\n';
+        return 1;
+    }
+
+    Engine::Network network(options.topology);
+    auto firstEpoch = 0ul;
+    if (options.resume && std::filesystem::exists(options.checkpoint))
+    {
+        const Engine::Checkpoint checkpoint(options.checkpoint);
+        if (!checkpoint.restore(network))
+        {
+            std::cerr << "could not resume from " << options.checkpoint << '\n';
+            return 1;
+        }
+
+        firstEpoch = checkpoint.cursor().epoch;
+        std::cout << "Resuming from " << options.checkpoint << " at epoch " << firstEpoch << '\n';
+    }
+
+    // Flags override what a resumed checkpoint was trained with
+    auto optimizer = network.optimizer().options();
+    if (options.optimizer && *options.optimizer != optimizer.type)
+    {
+        optimizer.type = *options.optimizer;
+        optimizer.learningRate = Engine::defaultLearningRate(optimizer.type);
+    }
+    if (options.learningRate)
+        optimizer.learningRate = *options.learningRate;
+    network.setOptimizer(optimizer);
+
+    if (options.threads > 0)
+        network.setThreads(options.threads);
+
+    auto [train, validation] = data->split(options.validation);
+    const auto hasValidation = validation.size() > 0;
+
+    Engine::CheckpointWriter checkpoints(options.checkpoint);
+    Engine::TrainingJob::Options jobOptions;
+    jobOptions.epochs = options.epochs;
+    jobOptions.batchSize = options.batchSize;
+    jobOptions.firstEpoch = firstEpoch;
+    jobOptions.checkpoints = &checkpoints;
+    jobOptions.checkpointSeconds = options.checkpointSeconds;
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::cout << "Training " << train.size() << " samples, " << validation.size()
+              << " for validation, " << Engine::optimizerName(optimizer.type) << " at "
+              << optimizer.learningRate << '\n';
+
+    if (!options.profile.empty())
+    {
+        if (!Engine::Profiler::s_enabled)
+            std::cerr << "built without ENGINE_PROFILE, " << options.profile << " will be empty\n";
+        Engine::Profiler::start();
+    }
+
+    Engine::TrainingJob job;
+    if (!job.start(network, train, hasValidation ? &validation : nullptr, jobOptions))
+        return 1;
+
+    // The job trains on its own thread, this one only reports and watches for a signal
+    auto reported = 0ul;
+    while (job.isActive())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (s_stop)
+            job.cancel();
+
+        // Epochs finishing between two looks are reported together
+        const auto progress = job.progress();
+        if (progress.epoch > reported)
+        {
+            reported = progress.epoch;
+            std::printf("epoch %lu: %lu passes, %.0f samples/s, recent avg. error %f, "
+                        "validation error %f\n",
+                        firstEpoch + reported - 1, progress.passes, progress.samplesPerSecond,
+                        progress.recentAvgError, progress.validationError);
+        }
+        std::fflush(stdout);
+    }
+
+    // The job has taken its final checkpoint, wait until it is on disk
+    checkpoints.wait();
+
+    if (!options.profile.empty())
+    {
+        Engine::Profiler::stop();
+        if (!Engine::Profiler::write(options.profile))
+            std::cerr << "could not write " << options.profile << '\n';
+    }
+
+    const auto progress = job.progress();
+    std::cout << Engine::TrainingJob::stateName(progress.state) << " after " << progress.epoch
+              << " epochs in " << progress.seconds << "s, checkpoint " << options.checkpoint
+              << '\n';
+
+    return checkpoints.failed() == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+// Runs every engine against the reference network, see Validation.h. Prints the checks that
+// fail, all of them with --verbose, and exits with 1 if any did. Registered with CTest.
+//
+//   validate [--steps n] [--batch n] [--threads n] [--ulps n] [--rtol r] [--atol a] [--verbose]
+
+// clang-format off
+#include "../Logging.h"
+#include "../Validation.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+// clang-format on
+
+namespace {
+
+struct Options
+{
+    bool verbose = false;
+    Engine::ValidationOptions checks;
+};
+
+bool parse(int argc, char** argv, Options& options)
+{
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::string flag = argv[i];
+        if (flag == "--verbose")
+        {
+            options.verbose = true;
+            continue;
+        }
+
+        if (i + 1 == argc)
+            return false;
+
+        const std::string value = argv[++i];
+        const auto number = std::strtod(value.c_str(), nullptr);
+        if (flag == "--steps" && number >= 1)
+            options.checks.steps = static_cast<unsigned long>(number);
+        else if (flag == "--batch" && number >= 1)
+            options.checks.batchSize = static_cast<unsigned long>(number);
+        else if (flag == "--threads" && number >= 0)
+            options.checks.threads = static_cast<unsigned int>(number);
+        else if (flag == "--ulps" && number >= 0)
+            options.checks.ulps = static_cast<unsigned long>(number);
+        else if (flag == "--rtol" && number >= 0)
+            options.checks.rtol = number;
+        else if (flag == "--atol" && number >= 0)
+            options.checks.atol = number;
+        else
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Engine::Logger::init();
+
+    Options options;
+    if (!parse(argc, argv, options))
+    {
+        std::cerr << "usage: " << argv[0]
+                  << " [--steps n] [--batch n] [--threads n] [--ulps n] [--rtol r] [--atol a]"
+                     " [--verbose]\n";
+        return 1;
+    }
+
+    auto checks = 0ul;
+    auto failures = 0ul;
+    const auto passed = Engine::validateEngines(options.checks, [&](const auto& check) {
+        ++checks;
+        if (!check.passed)
+            ++failures;
+
+        if (!check.passed || options.verbose)
+            std::printf("%s %s: %lu elements, max %.1f ulps, abs %.3g, rel %.3g at %lu\n",
+                        check.passed ? "ok  " : "FAIL", check.name.c_str(), check.elements,
+                        check.maxUlps, check.maxAbsolute, check.maxRelative, check.worst);
+    });
+
+    std::printf("%lu of %lu checks passed\n", checks - failures, checks);
+    return passed ? 0 : 1;
+}
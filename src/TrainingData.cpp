@@ -0,0 +1,223 @@
+// clang-format off
+#include "TrainingData.h"
+#include "Logging.h"
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+// clang-format on
+
+namespace Engine {
+
+// Large enough that reads are dominated by transfer time rather than syscall overhead
+static constexpr unsigned long s_chunkSize = 1ul << 20;
+
+static inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static inline const char* skipSpace(const char* p, const char* end)
+{
+    while (p != end && isSpace(*p))
+        ++p;
+
+    return p;
+}
+
+TrainingData::TrainingData(std::string_view path)
+    : m_buffer(s_chunkSize)
+{
+    const std::string file(path);
+    m_fd = ::open(file.c_str(), O_RDONLY);
+    if (m_fd < 0)
+    {
+        fail("could not open " + file);
+        return;
+    }
+
+    ::posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+TrainingData::~TrainingData()
+{
+    if (m_fd >= 0)
+        ::close(m_fd);
+}
+
+bool TrainingData::isEof()
+{
+    if (hasError())
+        return true;
+
+    // Skip trailing blank lines so a final newline does not count as another sample
+    while (true)
+    {
+        if (m_begin == m_end && !refill())
+            return true;
+
+        const auto* p = skipSpace(m_buffer.data() + m_begin, m_buffer.data() + m_end);
+        if (p == m_buffer.data() + m_end)
+        {
+            m_begin = m_end;
+            continue;
+        }
+
+        if (*p != '\n')
+            return false;
+
+        m_begin = static_cast<unsigned long>(p - m_buffer.data()) + 1;
+        ++m_line;
+    }
+}
+
+bool TrainingData::refill()
+{
+    if (m_drained || m_fd < 0)
+        return false;
+
+    // Keep the unfinished line, and grow the buffer if a single line fills all of it
+    const auto pending = m_end - m_begin;
+    std::memmove(m_buffer.data(), m_buffer.data() + m_begin, pending);
+    m_begin = 0;
+    m_end = pending;
+
+    if (m_end == m_buffer.size())
+        m_buffer.resize(m_buffer.size() * 2);
+
+    const auto bytes = ::read(m_fd, m_buffer.data() + m_end, m_buffer.size() - m_end);
+    if (bytes <= 0)
+    {
+        if (bytes < 0)
+            fail("read error");
+
+        m_drained = true;
+        return false;
+    }
+
+    m_end += static_cast<unsigned long>(bytes);
+    return true;
+}
+
+bool TrainingData::nextLine(std::string_view& line)
+{
+    while (true)
+    {
+        const auto* begin = m_buffer.data() + m_begin;
+        const auto* newline = static_cast<const char*>(std::memchr(begin, '\n', m_end - m_begin));
+
+        if (newline || (m_drained && m_begin != m_end))
+        {
+            const auto* end = newline ? newline : m_buffer.data() + m_end;
+            line = {begin, static_cast<unsigned long>(end - begin)};
+            m_begin = static_cast<unsigned long>(end - m_buffer.data()) + (newline ? 1 : 0);
+            ++m_line;
+
+            if (skipSpace(line.data(), line.data() + line.size()) != line.data() + line.size())
+                return true;
+
+            continue;
+        }
+
+        if (!refill() && m_begin == m_end)
+            return false;
+    }
+}
+
+bool TrainingData::parseInto(std::string_view line, std::span<double> values, const char* what)
+{
+    const auto* p = line.data();
+    const auto* end = line.data() + line.size();
+    auto count = 0ul;
+
+    while ((p = skipSpace(p, end)) != end)
+    {
+        if (count == values.size())
+        {
+            fail("line " + std::to_string(m_line) + ": expected " +
+                 std::to_string(values.size()) + " " + what + ", found more");
+            return false;
+        }
+
+        // from_chars does not accept a leading '+', which the old stream parser did
+        if (*p == '+')
+            ++p;
+
+        const auto [next, ec] = std::from_chars(p, end, values[count]);
+        if (ec != std::errc{} || (next != end && !isSpace(*next)))
+        {
+            const auto* tokenEnd = p;
+            while (tokenEnd != end && !isSpace(*tokenEnd))
+                ++tokenEnd;
+
+            fail("line " + std::to_string(m_line) + ": invalid number '" +
+                 std::string(p, tokenEnd) + "'");
+            return false;
+        }
+
+        p = next;
+        ++count;
+    }
+
+    if (count != values.size())
+    {
+        fail("line " + std::to_string(m_line) + ": expected " + std::to_string(values.size()) +
+             " " + what + ", found " + std::to_string(count));
+        return false;
+    }
+
+    return true;
+}
+
+bool TrainingData::readSample(std::span<double> inputs, std::span<double> targets)
+{
+    if (hasError())
+        return false;
+
+    std::string_view line;
+    if (!nextLine(line))
+        return false;
+
+    if (!parseInto(line, inputs, "inputs"))
+        return false;
+
+    if (!nextLine(line))
+    {
+        fail("line " + std::to_string(m_line) + ": inputs without targets at end of file");
+        return false;
+    }
+
+    return parseInto(line, targets, "targets");
+}
+
+unsigned long TrainingData::getNextInputs(std::vector<double>& inputVals)
+{
+    inputVals.clear();
+
+    std::string_view line;
+    if (hasError() || !nextLine(line))
+        return 0;
+
+    // Count first so the values can be parsed in place
+    auto count = 0ul;
+    for (auto p = skipSpace(line.data(), line.data() + line.size()); p != line.data() + line.size();
+         p = skipSpace(p, line.data() + line.size()))
+    {
+        while (p != line.data() + line.size() && !isSpace(*p))
+            ++p;
+        ++count;
+    }
+
+    inputVals.resize(count);
+    return parseInto(line, inputVals, "values") ? count : 0;
+}
+
+unsigned long TrainingData::getTargetOutputs(std::vector<double>& targetOutputVals)
+{
+    return getNextInputs(targetOutputVals);
+}
+
+void TrainingData::fail(std::string message)
+{
+    ENGINE_ERROR("[TrainingData] {}", message);
+    m_error = std::move(message);
+}
+
+} // namespace Engine
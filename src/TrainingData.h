@@ -0,0 +1,59 @@
+/* Reader for the whitespace separated text training format: one line of input values followed
+ * by one line of target values per sample. Blank lines are ignored.
+ *
+ * The file is read in large chunks and numbers are parsed in place with std::from_chars, so
+ * reading a sample neither allocates nor copies lines. A malformed line stops the reader and is
+ * reported through error() together with its line number. */
+#pragma once
+
+// clang-format off
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+class TrainingData
+{
+public:
+    explicit TrainingData(std::string_view path);
+    ~TrainingData();
+
+    TrainingData(const TrainingData&) = delete;
+    TrainingData& operator=(const TrainingData&) = delete;
+
+public:
+    // True once every line has been consumed, or after an error
+    bool isEof();
+    inline bool hasError() const { return !m_error.empty(); }
+    inline const std::string& error() const { return m_error; }
+    inline unsigned long line() const { return m_line; }
+
+    // Parses one sample straight into caller storage. The lines must hold exactly as many values
+    // as the spans are wide. Returns false at the end of the data or on a malformed sample.
+    bool readSample(std::span<double> inputs, std::span<double> targets);
+
+    // Returns the number of input values read from the file. The vectors keep their capacity,
+    // so these only allocate while they grow to the widest line seen.
+    unsigned long getNextInputs(std::vector<double>& inputVals);
+    unsigned long getTargetOutputs(std::vector<double>& targetOutputVals);
+
+private:
+    bool nextLine(std::string_view& line);
+    bool refill();
+    bool parseInto(std::string_view line, std::span<double> values, const char* what);
+    void fail(std::string message);
+
+private:
+    int m_fd = -1;
+    std::vector<char> m_buffer;
+    unsigned long m_begin = 0;
+    unsigned long m_end = 0;
+    bool m_drained = false;
+    unsigned long m_line = 0;
+    std::string m_error;
+};
+
+} // namespace Engine
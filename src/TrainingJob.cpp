@@ -0,0 +1,308 @@
+// clang-format off
+#include "TrainingJob.h"
+#include "Checkpoint.h"
+#include "DataLoader.h"
+#include "Logging.h"
+#include "Metrics.h"
+#include "Network.h"
+#include "Profiler.h"
+#include "TrainingLog.h"
+#include <cassert>
+#include <algorithm>
+#include <chrono>
+// clang-format on
+
+namespace Engine {
+
+// Samples between two progress snapshots in per-sample mode, a snapshot is far cheaper than
+// a pass but there is no point in publishing faster than anyone can look
+static constexpr unsigned long s_publishInterval = 256;
+
+// Metrics are sampled by time rather than by pass, so plots look alike at any throughput
+static constexpr std::chrono::milliseconds s_metricsInterval{10};
+
+TrainingJob::~TrainingJob() { cancel(); }
+
+const char* TrainingJob::stateName(State state)
+{
+    switch (state)
+    {
+    case State::Idle:
+        return "Idle";
+    case State::Running:
+        return "Running";
+    case State::Paused:
+        return "Paused";
+    case State::Finished:
+        return "Finished";
+    case State::Cancelled:
+        return "Cancelled";
+    }
+
+    return "Unknown";
+}
+
+bool TrainingJob::start(Network& network, const IndexedDataset::Subset& train,
+                        const IndexedDataset::Subset* validation, Options options)
+{
+    assert(options.batchSize > 0);
+
+    if (isActive())
+        return false;
+
+    join();
+    m_cancel = false;
+    m_pause = false;
+    publish({});
+    m_state = State::Running;
+    m_thread = std::thread(&TrainingJob::run, this, std::ref(network), std::cref(train),
+                           validation, options);
+
+    return true;
+}
+
+void TrainingJob::pause()
+{
+    std::lock_guard lock(m_pauseMutex);
+    auto expected = State::Running;
+    if (m_state.compare_exchange_strong(expected, State::Paused))
+        m_pause = true;
+}
+
+void TrainingJob::resume()
+{
+    {
+        std::lock_guard lock(m_pauseMutex);
+        auto expected = State::Paused;
+        if (!m_state.compare_exchange_strong(expected, State::Running))
+            return;
+
+        m_pause = false;
+    }
+
+    m_resumed.notify_all();
+}
+
+void TrainingJob::cancel()
+{
+    {
+        std::lock_guard lock(m_pauseMutex);
+        m_cancel = true;
+    }
+
+    m_resumed.notify_all();
+    join();
+}
+
+void TrainingJob::join()
+{
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+TrainingJob::Progress TrainingJob::progress() const
+{
+    Progress progress;
+    while (true)
+    {
+        const auto before = m_sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            continue;
+
+        progress.epoch = m_epoch.load(std::memory_order_relaxed);
+        progress.passes = m_passes.load(std::memory_order_relaxed);
+        progress.recentAvgError = m_recentAvgError.load(std::memory_order_relaxed);
+        progress.validationError = m_validationError.load(std::memory_order_relaxed);
+        progress.samplesPerSecond = m_samplesPerSecond.load(std::memory_order_relaxed);
+        progress.seconds = m_seconds.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) == before)
+            break;
+    }
+
+    progress.state = state();
+    return progress;
+}
+
+void TrainingJob::publish(const Progress& progress)
+{
+    // Only the worker (or start(), before the worker exists) ever writes
+    const auto sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_epoch.store(progress.epoch, std::memory_order_relaxed);
+    m_passes.store(progress.passes, std::memory_order_relaxed);
+    m_recentAvgError.store(progress.recentAvgError, std::memory_order_relaxed);
+    m_validationError.store(progress.validationError, std::memory_order_relaxed);
+    m_samplesPerSecond.store(progress.samplesPerSecond, std::memory_order_relaxed);
+    m_seconds.store(progress.seconds, std::memory_order_relaxed);
+
+    m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool TrainingJob::checkpoint()
+{
+    if (m_pause.load(std::memory_order_relaxed))
+    {
+        ENGINE_INFO("Training paused");
+        std::unique_lock lock(m_pauseMutex);
+        m_resumed.wait(lock, [this] { return !m_pause || m_cancel; });
+    }
+
+    return !m_cancel.load(std::memory_order_relaxed);
+}
+
+void TrainingJob::run(Network& network, const IndexedDataset::Subset& train,
+                      const IndexedDataset::Subset* validation, Options options)
+{
+    ENGINE_PROFILE_THREAD("training");
+    const auto inputWidth = train.data().inputWidth();
+    const auto targetWidth = train.data().targetWidth();
+    const auto start = std::chrono::steady_clock::now();
+
+    Progress progress;
+    progress.state = State::Running;
+
+    // Time spent paused does not count towards throughput
+    auto paused = std::chrono::steady_clock::duration::zero();
+    auto lastMetric = start;
+    auto lastMetricPasses = 0ul;
+    auto lastCheckpoint = start;
+    const std::chrono::duration<double> checkpointInterval(options.checkpointSeconds);
+    network.setShellTiming(options.metrics != nullptr);
+
+    auto sendMetrics = [&](std::chrono::steady_clock::time_point now) {
+        const auto passes = progress.passes - lastMetricPasses;
+        const auto seconds = std::chrono::duration<double>(now - lastMetric).count();
+        const auto perPass = passes > 0 ? 1e6 / static_cast<double>(passes) : 0.0;
+
+        MetricSample sample;
+        sample.seconds = progress.seconds;
+        sample.error = network.error();
+        sample.recentAvgError = progress.recentAvgError;
+        sample.samplesPerSecond = seconds > 0.0 ? static_cast<double>(passes) / seconds : 0.0;
+        sample.shells = std::min(network.topology().size(), MetricSample::s_maxShells);
+        for (auto l = 0ul; l < sample.shells; ++l)
+            sample.shellMicroseconds[l] = network.takeShellSeconds(l) * perPass;
+
+        // A full channel drops the sample, training never waits for the viewer
+        options.metrics->tryPush(sample);
+        lastMetric = now;
+        lastMetricPasses = progress.passes;
+    };
+
+    // Resuming from a checkpoint taken mid-epoch starts that epoch over
+    auto cursor = [&] {
+        return TrainingCursor{options.firstEpoch + progress.epoch, progress.passes,
+                              progress.recentAvgError};
+    };
+
+    auto update = [&] {
+        const auto now = std::chrono::steady_clock::now();
+        progress.seconds = std::chrono::duration<double>(now - start - paused).count();
+        progress.samplesPerSecond =
+            progress.seconds > 0.0 ? static_cast<double>(progress.passes) / progress.seconds : 0.0;
+        progress.recentAvgError = network.recentAverageError();
+        publish(progress);
+
+        if (options.metrics && now - lastMetric >= s_metricsInterval)
+            sendMetrics(now);
+
+        // Skipped while the previous checkpoint is still being written, tried again next time
+        if (options.checkpoints && now - lastCheckpoint >= checkpointInterval &&
+            options.checkpoints->trySave(network, cursor()))
+            lastCheckpoint = now;
+    };
+
+    auto proceed = [&] {
+        const auto before = std::chrono::steady_clock::now();
+        const auto result = checkpoint();
+        const auto waited = std::chrono::steady_clock::now() - before;
+        paused += waited;
+        lastMetric += waited;
+        return result;
+    };
+
+    auto cancelled = false;
+    for (auto epoch = 0ul; !cancelled && (options.epochs == 0 || epoch < options.epochs); ++epoch)
+    {
+        DataLoader::Options loaderOptions;
+        loaderOptions.batchSize = options.batchSize > 1 ? options.batchSize : options.loaderBatch;
+        DataLoader loader(train, options.firstEpoch + epoch, loaderOptions);
+
+        while (const auto* batch = loader.acquire())
+        {
+            if (options.batchSize > 1)
+            {
+                network.forwardBatch(batch->inputs, batch->samples);
+                if (options.log)
+                {
+                    // Outputs are logged before the update, as they were when the error was made
+                    const auto outputs = network.batchOutputs();
+                    for (auto sample = 0ul; sample < batch->samples; ++sample)
+                        options.log->record(
+                            {batch->inputs.data() + sample * inputWidth, inputWidth},
+                            outputs.subspan(sample * targetWidth, targetWidth),
+                            {batch->targets.data() + sample * targetWidth, targetWidth},
+                            network.recentAverageError());
+                }
+
+                network.backwardBatch(batch->targets);
+                progress.passes += batch->samples;
+                update();
+            }
+            else
+            {
+                for (auto sample = 0ul; sample < batch->samples; ++sample)
+                {
+                    const std::span<const double> inputs(
+                        batch->inputs.data() + sample * inputWidth, inputWidth);
+                    const std::span<const double> targets(
+                        batch->targets.data() + sample * targetWidth, targetWidth);
+
+                    network.forward(inputs);
+                    network.backward(targets);
+                    if (options.log)
+                        options.log->record(inputs, network.outputs(), targets,
+                                            network.recentAverageError());
+
+                    if (++progress.passes % s_publishInterval == 0)
+                        update();
+                }
+            }
+
+            loader.release(batch);
+            if (!proceed())
+            {
+                cancelled = true;
+                break;
+            }
+        }
+
+        if (cancelled)
+            break;
+
+        if (validation)
+            progress.validationError = network.evaluate(*validation, options.validationBatch);
+
+        ++progress.epoch;
+        update();
+    }
+
+    update();
+    network.setShellTiming(false);
+
+    // The network is only handed back once it has been captured
+    if (options.checkpoints)
+        options.checkpoints->save(network, cursor());
+
+    m_state = cancelled ? State::Cancelled : State::Finished;
+
+    ENGINE_INFO("Training {} after {} epochs, {} samples in {:.1f}s ({:.0f} samples/s)",
+                cancelled ? "cancelled" : "finished", progress.epoch, progress.passes,
+                progress.seconds, progress.samplesPerSecond);
+}
+
+} // namespace Engine
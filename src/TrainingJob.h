@@ -0,0 +1,109 @@
+/* Training on a background thread. A job runs epochs over a training subset on its own worker
+ * thread and can be paused, resumed and cancelled from any thread. Progress is published as a
+ * snapshot the UI can poll every frame without taking a lock, the training loop never waits on
+ * a reader.
+ *
+ * The network belongs to the job while it runs: nothing else may touch it until the job has
+ * finished, was cancelled, or is paused. */
+#pragma once
+
+// clang-format off
+#include "IndexedDataset.h"
+#include "Metrics.h"
+#include "Network.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+// clang-format on
+
+namespace Engine {
+
+class CheckpointWriter;
+class TrainingLog;
+
+class TrainingJob
+{
+public:
+    enum class State { Idle, Running, Paused, Finished, Cancelled };
+
+    struct Options
+    {
+        unsigned long epochs = 1;        // 0 keeps training until cancelled
+        unsigned long batchSize = 1;     // 1 updates after every sample
+        unsigned long firstEpoch = 0;    // epoch number of the first epoch, picks its shuffle
+        unsigned long loaderBatch = 64;  // samples prefetched per batch when batchSize is 1
+        unsigned long validationBatch = 256;
+        TrainingLog* log = nullptr; // receives every pass, must outlive the job
+        MetricsChannel* metrics = nullptr; // sampled metrics, the job is its only producer
+        CheckpointWriter* checkpoints = nullptr; // periodic and final saves, must outlive the job
+        double checkpointSeconds = 60.0;         // between two periodic saves
+    };
+
+    struct Progress
+    {
+        State state = State::Idle;
+        unsigned long epoch = 0;  // epochs completed
+        unsigned long passes = 0; // samples trained on
+        double recentAvgError = 0.0;
+        double validationError = 0.0; // after the last completed epoch
+        double samplesPerSecond = 0.0;
+        double seconds = 0.0;
+    };
+
+public:
+    TrainingJob() = default;
+    ~TrainingJob();
+
+    TrainingJob(const TrainingJob&) = delete;
+    TrainingJob& operator=(const TrainingJob&) = delete;
+
+public:
+    // Starts training on the worker thread. Does nothing while a previous job is still running
+    // or paused. The network and the subsets must outlive the job. validation may be null.
+    bool start(Network& network, const IndexedDataset::Subset& train,
+               const IndexedDataset::Subset* validation, Options options);
+    void pause();
+    void resume();
+
+    // Stops after the current batch and waits for the worker to exit
+    void cancel();
+
+    // Latest published progress, safe to call from any thread at any rate
+    Progress progress() const;
+    inline State state() const { return m_state.load(std::memory_order_acquire); }
+    inline bool isActive() const
+    {
+        const auto current = state();
+        return current == State::Running || current == State::Paused;
+    }
+
+    static const char* stateName(State state);
+
+private:
+    void run(Network& network, const IndexedDataset::Subset& train,
+             const IndexedDataset::Subset* validation, Options options);
+    bool checkpoint(); // blocks while paused, returns false once cancelled
+    void publish(const Progress& progress);
+    void join();
+
+private:
+    std::thread m_thread;
+    std::atomic<State> m_state = State::Idle;
+    std::atomic<bool> m_cancel = false;
+    std::atomic<bool> m_pause = false;
+    std::mutex m_pauseMutex;
+    std::condition_variable m_resumed;
+
+    // Seqlock around the published progress: odd while the worker is writing. Readers retry
+    // instead of blocking the worker, which only ever does a handful of plain stores.
+    std::atomic<unsigned long> m_sequence = 0;
+    std::atomic<unsigned long> m_epoch = 0;
+    std::atomic<unsigned long> m_passes = 0;
+    std::atomic<double> m_recentAvgError = 0.0;
+    std::atomic<double> m_validationError = 0.0;
+    std::atomic<double> m_samplesPerSecond = 0.0;
+    std::atomic<double> m_seconds = 0.0;
+};
+
+} // namespace Engine
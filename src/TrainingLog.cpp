@@ -0,0 +1,95 @@
+// clang-format off
+#include "TrainingLog.h"
+#include <cassert>
+#include <cmath>
+// clang-format on
+
+namespace Engine {
+
+TrainingLog::TrainingLog(unsigned long inputWidth, unsigned long outputWidth,
+                         unsigned long capacity, unsigned long interval)
+    : m_inputWidth(inputWidth)
+    , m_outputWidth(outputWidth)
+    , m_capacity(capacity)
+    , m_interval(interval > 0 ? interval : 1)
+    , m_sequence(new std::atomic<unsigned long>[capacity])
+    , m_values(new std::atomic<double>[capacity * stride()])
+{
+    assert(capacity > 0);
+
+    for (auto i = 0ul; i < capacity; ++i)
+        m_sequence[i].store(0, std::memory_order_relaxed);
+}
+
+void TrainingLog::record(std::span<const double> inputs, std::span<const double> outputs,
+                         std::span<const double> targets, double recentAvgError)
+{
+    assert(inputs.size() == m_inputWidth);
+    assert(outputs.size() == m_outputWidth && targets.size() == m_outputWidth);
+
+    const auto pass = m_passes.load(std::memory_order_relaxed);
+    m_passes.store(pass + 1, std::memory_order_relaxed);
+    if (pass % interval() != 0)
+        return;
+
+    auto error = 0.0;
+    for (auto n = 0ul; n < m_outputWidth; ++n)
+        error += (targets[n] - outputs[n]) * (targets[n] - outputs[n]);
+    error = std::sqrt(error / static_cast<double>(m_outputWidth));
+
+    const auto index = m_stored.load(std::memory_order_relaxed);
+    const auto slot = index % m_capacity;
+    auto* values = m_values.get() + slot * stride();
+
+    m_sequence[slot].store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto store = [&values](double value) { (values++)->store(value, std::memory_order_relaxed); };
+    store(static_cast<double>(pass));
+    store(error);
+    store(recentAvgError);
+    for (auto value : inputs)
+        store(value);
+    for (auto value : outputs)
+        store(value);
+    for (auto value : targets)
+        store(value);
+
+    m_sequence[slot].store(index + 1, std::memory_order_release);
+    m_stored.store(index + 1, std::memory_order_release);
+}
+
+TrainingLog::Reader::Reader(const TrainingLog& log)
+    : m_log(log)
+    , m_values(new double[log.stride()])
+{
+}
+
+bool TrainingLog::Reader::read(unsigned long index, Record& record)
+{
+    const auto slot = index % m_log.m_capacity;
+    const auto& sequence = m_log.m_sequence[slot];
+    if (sequence.load(std::memory_order_acquire) != index + 1)
+        return false;
+
+    const auto* values = m_log.m_values.get() + slot * m_log.stride();
+    for (auto i = 0ul; i < m_log.stride(); ++i)
+        m_values[i] = values[i].load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence.load(std::memory_order_relaxed) != index + 1)
+        return false;
+
+    const auto inputWidth = m_log.m_inputWidth;
+    const auto outputWidth = m_log.m_outputWidth;
+    record.pass = static_cast<unsigned long>(m_values[0]);
+    record.error = m_values[1];
+    record.recentAvgError = m_values[2];
+    record.inputs = {m_values.get() + 3, inputWidth};
+    record.outputs = {m_values.get() + 3 + inputWidth, outputWidth};
+    record.targets = {m_values.get() + 3 + inputWidth + outputWidth, outputWidth};
+
+    return true;
+}
+
+} // namespace Engine
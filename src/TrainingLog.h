@@ -0,0 +1,88 @@
+/* A bounded log of training passes. Every recorded pass is stored as a fixed size binary record
+ * (pass number, errors, inputs, outputs and targets) in a ring buffer, the oldest records are
+ * overwritten once it is full. Nothing is formatted when a pass is recorded, viewers format
+ * only the records they actually show, so memory and cost per frame stay the same however long
+ * training runs. Only every interval()-th pass is kept, to thin out long runs further.
+ *
+ * One thread records, any number of threads may read. Readers never block the writer: a read
+ * of a record that is overwritten meanwhile simply fails. */
+#pragma once
+
+// clang-format off
+#include <atomic>
+#include <memory>
+#include <span>
+// clang-format on
+
+namespace Engine {
+
+class TrainingLog
+{
+public:
+    struct Record
+    {
+        unsigned long pass = 0;
+        double error = 0.0;
+        double recentAvgError = 0.0;
+        std::span<const double> inputs;
+        std::span<const double> outputs;
+        std::span<const double> targets;
+    };
+
+public:
+    TrainingLog(unsigned long inputWidth, unsigned long outputWidth, unsigned long capacity = 4096,
+                unsigned long interval = 1);
+
+    TrainingLog(const TrainingLog&) = delete;
+    TrainingLog& operator=(const TrainingLog&) = delete;
+
+public:
+    // Writer side. Counts a pass and stores it if it falls on the sampling interval.
+    void record(std::span<const double> inputs, std::span<const double> outputs,
+                std::span<const double> targets, double recentAvgError);
+
+    // Reader side. Records are numbered from 0 in the order they were stored, the log holds
+    // the numbers [first(), end()). Reader::read() copies one into the reader's own scratch and
+    // returns false if it has been overwritten in the meantime.
+    inline unsigned long end() const { return m_stored.load(std::memory_order_acquire); }
+    inline unsigned long first() const { return end() > m_capacity ? end() - m_capacity : 0; }
+    inline unsigned long passes() const { return m_passes.load(std::memory_order_relaxed); }
+    inline unsigned long capacity() const { return m_capacity; }
+
+    inline unsigned long interval() const { return m_interval.load(std::memory_order_relaxed); }
+    inline void setInterval(unsigned long interval)
+    {
+        m_interval.store(interval > 0 ? interval : 1, std::memory_order_relaxed);
+    }
+
+    // Per-reader scratch, so reads do not allocate
+    class Reader
+    {
+    public:
+        explicit Reader(const TrainingLog& log);
+        bool read(unsigned long index, Record& record);
+
+    private:
+        const TrainingLog& m_log;
+        std::unique_ptr<double[]> m_values;
+    };
+
+private:
+    inline unsigned long stride() const { return 3 + m_inputWidth + 2 * m_outputWidth; }
+
+private:
+    unsigned long m_inputWidth;
+    unsigned long m_outputWidth;
+    unsigned long m_capacity;
+    std::atomic<unsigned long> m_interval;
+    std::atomic<unsigned long> m_passes = 0;
+    std::atomic<unsigned long> m_stored = 0;
+
+    // Every slot carries the record number it holds plus one, or 0 while it is being written.
+    // Values are relaxed atomics so concurrent reads are well defined, on x86 they are plain
+    // loads and stores.
+    std::unique_ptr<std::atomic<unsigned long>[]> m_sequence;
+    std::unique_ptr<std::atomic<double>[]> m_values;
+};
+
+} // namespace Engine
@@ -0,0 +1,666 @@
+// clang-format off
+#include "Validation.h"
+#include "InferenceModel.h"
+#include "Kernels.h"
+#include "Network.h"
+#include "ReferenceNetwork.h"
+#include "StaticNetwork.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+#include <type_traits>
+#include <vector>
+// clang-format on
+
+namespace Engine {
+
+namespace {
+
+using Topology = std::vector<unsigned long>;
+
+struct Case
+{
+    const char* name;
+    Topology topology;
+    std::vector<Activation> activations; // of every shell but the input shell
+    bool allOptimizers;
+    double learningRate; // of SGD with momentum, small enough not to diverge in a few steps
+};
+
+// The original all-tanh network first, it is also the one the static network is built for.
+// The third one is wide enough for its shells to be split across threads.
+const std::vector<Case> s_cases{
+    {"tanh", {4, 16, 8, 3}, {Activation::Tanh, Activation::Tanh, Activation::Tanh}, true, 0.15},
+    {"relu-sigmoid-softmax",
+     {8, 32, 32, 5},
+     {Activation::Relu, Activation::Sigmoid, Activation::Softmax},
+     true,
+     0.15},
+    {"leaky-tanh-linear",
+     {128, 320, 256, 10},
+     {Activation::LeakyRelu, Activation::Tanh, Activation::Linear},
+     false,
+     0.01},
+    {"fast-tanh-sigmoid",
+     {6, 24, 12, 4},
+     {Activation::FastTanh, Activation::FastSigmoid, Activation::Tanh},
+     false,
+     0.15},
+};
+
+using StaticCase = BasicStaticNetwork<double, double, 4, 16, 8, 3>;
+using StaticCaseF32 = BasicStaticNetwork<float, float, 4, 16, 8, 3>;
+
+struct Tolerance
+{
+    unsigned long ulps;
+    double rtol;
+    double atol;
+};
+
+struct Data
+{
+    std::vector<double> inputs;
+    std::vector<double> targets;
+};
+
+// What ReferenceNetwork computes, everything an engine is compared against
+struct Expected
+{
+    std::vector<double> outputs;      // of the first sample, before any training
+    std::vector<double> batchOutputs; // of the first batch
+    std::vector<double> gradients;    // summed over the first batch
+    std::vector<double> perSample;    // parameters after one step per sample
+    std::vector<double> perBatch;     // parameters after one step per batch
+};
+
+template <typename T>
+struct Actual
+{
+    std::vector<T> outputs;
+    std::vector<T> batchOutputs;
+    std::vector<T> gradients;
+    std::vector<T> perSample;
+    std::vector<T> perBatch;
+};
+
+std::vector<OptimizerOptions> optimizers(const Case& c)
+{
+    std::vector<OptimizerOptions> all(1); // SGD with momentum, the original update
+    all.front().learningRate = c.learningRate;
+    if (!c.allOptimizers)
+        return all;
+
+    OptimizerOptions nesterov;
+    nesterov.type = OptimizerType::Nesterov;
+    nesterov.learningRate = 0.05;
+    nesterov.momentum = 0.9;
+
+    OptimizerOptions rmsProp;
+    rmsProp.type = OptimizerType::RmsProp;
+    rmsProp.learningRate = 0.01;
+
+    // With a schedule, so the per-step rate is checked as well
+    OptimizerOptions adam;
+    adam.type = OptimizerType::Adam;
+    adam.learningRate = 0.01;
+    adam.schedule.type = LearningRateSchedule::Type::Cosine;
+    adam.schedule.warmupSteps = 4;
+    adam.schedule.decaySteps = 16;
+    adam.schedule.minRate = 0.001;
+
+    all.insert(all.end(), {nesterov, rmsProp, adam});
+    return all;
+}
+
+std::vector<double> initialParameters(const Topology& topology)
+{
+    std::mt19937 rng(7);
+    std::vector<double> parameters;
+    for (auto l = 1ul; l < topology.size(); ++l)
+    {
+        // Scaled by the fan-in, so wide shells do not start out saturated
+        const auto scale = 1.0 / std::sqrt(static_cast<double>(topology[l - 1] + 1));
+        std::uniform_real_distribution<double> dist(-scale, scale);
+        for (auto i = 0ul; i < topology[l] * (topology[l - 1] + 1); ++i)
+            parameters.push_back(dist(rng));
+    }
+
+    return parameters;
+}
+
+Data makeData(const Case& c, unsigned long samples)
+{
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> input(-1.0, 1.0);
+    const auto output = c.activations.back();
+    const auto sigmoid = output == Activation::Sigmoid || output == Activation::FastSigmoid;
+    std::uniform_real_distribution<double> target(sigmoid ? 0.1 : -0.5, sigmoid ? 0.9 : 0.5);
+
+    const auto inputWidth = c.topology.front();
+    const auto targetWidth = c.topology.back();
+
+    Data data;
+    data.inputs.resize(samples * inputWidth);
+    data.targets.resize(samples * targetWidth);
+    for (auto& value : data.inputs)
+        value = input(rng);
+
+    for (auto s = 0ul; s < samples; ++s)
+    {
+        auto* row = data.targets.data() + s * targetWidth;
+        if (output == Activation::Softmax)
+            row[rng() % targetWidth] = 1.0; // one-hot
+        else
+            for (auto n = 0ul; n < targetWidth; ++n)
+                row[n] = target(rng);
+    }
+
+    return data;
+}
+
+// Loss of one sample, as ReferenceNetwork::loss() defines it
+template <typename T>
+double sampleLoss(Activation output, const T* outputs, const double* targets, unsigned long n)
+{
+    auto loss = 0.0;
+    for (auto i = 0ul; i < n; ++i)
+    {
+        const auto value = static_cast<double>(outputs[i]);
+        if (output == Activation::Softmax)
+            loss -= targets[i] * std::log(value);
+        else
+            loss += 0.5 * (targets[i] - value) * (targets[i] - value);
+    }
+
+    return loss;
+}
+
+ReferenceNetwork makeReference(const Case& c, const OptimizerOptions& optimizer,
+                               const std::vector<double>& parameters)
+{
+    ReferenceNetwork reference(c.topology);
+    for (auto l = 1ul; l < c.topology.size(); ++l)
+        reference.setActivation(l, c.activations[l - 1]);
+    reference.setOptimizer(optimizer);
+    reference.setParameters(parameters);
+    return reference;
+}
+
+Expected runReference(const Case& c, const OptimizerOptions& optimizer, const Data& data,
+                      const std::vector<double>& parameters, const ValidationOptions& options)
+{
+    const auto inputWidth = c.topology.front();
+    const auto targetWidth = c.topology.back();
+    auto input = [&](unsigned long s) {
+        return std::span<const double>(data.inputs.data() + s * inputWidth, inputWidth);
+    };
+    auto target = [&](unsigned long s) {
+        return std::span<const double>(data.targets.data() + s * targetWidth, targetWidth);
+    };
+
+    Expected expected;
+    auto reference = makeReference(c, optimizer, parameters);
+    for (auto s = 0ul; s < options.steps; ++s)
+    {
+        reference.forward(input(s));
+        if (s == 0)
+            expected.outputs = reference.results();
+        reference.backward(target(s));
+    }
+    expected.perSample = reference.parameters();
+
+    reference = makeReference(c, optimizer, parameters);
+    for (auto b = 0ul; b < options.steps; ++b)
+    {
+        for (auto s = b * options.batchSize; s < (b + 1) * options.batchSize; ++s)
+        {
+            reference.forward(input(s));
+            reference.accumulateGradients(target(s));
+
+            if (b == 0)
+            {
+                const auto outputs = reference.results();
+                expected.batchOutputs.insert(expected.batchOutputs.end(), outputs.begin(),
+                                             outputs.end());
+            }
+        }
+
+        if (b == 0)
+            expected.gradients = reference.gradients();
+        reference.applyGradients(options.batchSize);
+    }
+    expected.perBatch = reference.parameters();
+
+    return expected;
+}
+
+template <typename N>
+void configure(N& network, const Case& c, const OptimizerOptions& optimizer,
+               const std::vector<double>& parameters, unsigned int threads)
+{
+    using T = typename N::Scalar;
+
+    // The static network only knows tanh, which is all its case uses
+    if constexpr (requires { network.setActivation(1ul, Activation::Tanh); })
+    {
+        for (auto l = 1ul; l < c.topology.size(); ++l)
+            network.setActivation(l, c.activations[l - 1]);
+
+        if (threads > 1)
+            network.setThreads(threads - 1);
+    }
+
+    network.setOptimizer(optimizer);
+    std::transform(parameters.begin(), parameters.end(), network.parameters().begin(),
+                   [](double value) { return static_cast<T>(value); });
+}
+
+template <typename N, typename Make>
+Actual<typename N::Scalar> runEngine(Make&& make, const Case& c,
+                                     const OptimizerOptions& optimizer, const Data& data,
+                                     const std::vector<double>& parameters,
+                                     const ValidationOptions& options, unsigned int threads)
+{
+    using T = typename N::Scalar;
+
+    const auto inputWidth = c.topology.front();
+    const auto targetWidth = c.topology.back();
+    const std::vector<T> inputs(data.inputs.begin(), data.inputs.end());
+    const std::vector<T> targets(data.targets.begin(), data.targets.end());
+    auto rows = [](const std::vector<T>& values, unsigned long first, unsigned long count,
+                   unsigned long width) {
+        return std::span<const T>(values.data() + first * width, count * width);
+    };
+
+    Actual<T> actual;
+    {
+        auto network = make();
+        configure(network, c, optimizer, parameters, threads);
+        for (auto s = 0ul; s < options.steps; ++s)
+        {
+            network.forward(rows(inputs, s, 1, inputWidth));
+            if (s == 0)
+                actual.outputs = network.results();
+            network.backward(rows(targets, s, 1, targetWidth));
+        }
+
+        const auto trained = network.parameters();
+        actual.perSample.assign(trained.begin(), trained.end());
+    }
+
+    {
+        // The first batch in two halves, to look at its gradients before they are applied
+        const auto batch = options.batchSize;
+        auto network = make();
+        configure(network, c, optimizer, parameters, threads);
+        for (auto b = 0ul; b < options.steps; ++b)
+        {
+            network.forwardBatch(rows(inputs, b * batch, batch, inputWidth), batch);
+            if (b == 0)
+            {
+                actual.batchOutputs = network.batchResults();
+                network.computeBatchGradients(rows(targets, 0, batch, targetWidth));
+
+                const auto gradients = network.gradients();
+                actual.gradients.assign(gradients.begin(), gradients.end());
+                network.applyGradients(batch);
+            }
+            else
+            {
+                network.backwardBatch(rows(targets, b * batch, batch, targetWidth));
+            }
+        }
+
+        const auto trained = network.parameters();
+        actual.perBatch.assign(trained.begin(), trained.end());
+    }
+
+    return actual;
+}
+
+template <typename T>
+double ulpDistance(T a, T b)
+{
+    if (std::isnan(a) || std::isnan(b))
+        return std::numeric_limits<double>::infinity();
+
+    // Maps the sign-magnitude bit patterns onto a monotonic integer line
+    using Bits = std::conditional_t<sizeof(T) == sizeof(std::int64_t), std::int64_t, std::int32_t>;
+    auto ordered = [](T value) {
+        const auto bits = std::bit_cast<Bits>(value);
+        return bits < 0 ? static_cast<double>(std::numeric_limits<Bits>::min()) -
+                              static_cast<double>(bits)
+                        : static_cast<double>(bits);
+    };
+
+    return std::abs(ordered(a) - ordered(b));
+}
+
+template <typename T>
+ValidationCheck compare(std::string name, const std::vector<T>& actual,
+                        const std::vector<double>& expected, const Tolerance& tolerance)
+{
+    ValidationCheck check;
+    check.name = std::move(name);
+    check.elements = expected.size();
+    if (actual.size() != expected.size())
+    {
+        check.passed = false;
+        return check;
+    }
+
+    for (auto i = 0ul; i < expected.size(); ++i)
+    {
+        const auto value = static_cast<double>(actual[i]);
+        const auto absolute = std::abs(value - expected[i]);
+        const auto relative = absolute / std::max(std::abs(expected[i]), 1e-300);
+        const auto ulps = ulpDistance(actual[i], static_cast<T>(expected[i]));
+
+        if (absolute > check.maxAbsolute)
+            check.worst = i;
+        check.maxAbsolute = std::max(check.maxAbsolute, absolute);
+        check.maxRelative = std::max(check.maxRelative, relative);
+        check.maxUlps = std::max(check.maxUlps, ulps);
+
+        const auto within = ulps <= static_cast<double>(tolerance.ulps) ||
+                            absolute <= tolerance.atol + tolerance.rtol * std::abs(expected[i]);
+        if (!within)
+            check.passed = false;
+    }
+
+    return check;
+}
+
+template <typename T>
+void compareAll(const std::string& prefix, const Actual<T>& actual, const Expected& expected,
+                const Tolerance& tolerance, const ValidationOptions& options,
+                const std::function<void(const ValidationCheck&)>& report, bool& passed)
+{
+    const auto steps = std::to_string(options.steps);
+    const auto batch = std::to_string(options.batchSize);
+    auto check = [&](const char* quantity, const std::vector<T>& values,
+                     const std::vector<double>& reference) {
+        const auto result = compare(prefix + " / " + quantity, values, reference, tolerance);
+        passed = passed && result.passed;
+        report(result);
+    };
+
+    check("outputs", actual.outputs, expected.outputs);
+    check("parameters after per-sample steps", actual.perSample, expected.perSample);
+    check("batch outputs", actual.batchOutputs, expected.batchOutputs);
+    check("batch gradients", actual.gradients, expected.gradients);
+    check("parameters after batch steps", actual.perBatch, expected.perBatch);
+}
+
+// Central differences of the loss over one batch against the analytic gradients, which are
+// the loss's negative gradient
+ValidationCheck finiteDifferences(std::string name, std::vector<double>& parameters,
+                                  const std::vector<double>& gradients,
+                                  const std::function<double()>& loss,
+                                  const ValidationOptions& options)
+{
+    ValidationCheck check;
+    check.name = std::move(name);
+
+    const auto stride = std::max(parameters.size() / options.fdParameters, 1ul);
+    for (auto i = stride / 2; i < parameters.size(); i += stride)
+    {
+        const auto original = parameters[i];
+        parameters[i] = original + options.fdEpsilon;
+        const auto above = loss();
+        parameters[i] = original - options.fdEpsilon;
+        const auto below = loss();
+        parameters[i] = original;
+
+        const auto numeric = -(above - below) / (2.0 * options.fdEpsilon);
+        const auto absolute = std::abs(numeric - gradients[i]);
+        const auto relative = absolute / std::max(std::abs(gradients[i]), 1e-300);
+
+        if (absolute > check.maxAbsolute)
+            check.worst = i;
+        check.maxAbsolute = std::max(check.maxAbsolute, absolute);
+        check.maxRelative = std::max(check.maxRelative, relative);
+        ++check.elements;
+
+        if (absolute > options.fdTolerance * std::max(std::abs(gradients[i]), 1.0))
+            check.passed = false;
+    }
+
+    return check;
+}
+
+ValidationCheck referenceFiniteDifferences(const Case& c, const Data& data,
+                                           const ValidationOptions& options)
+{
+    auto parameters = initialParameters(c.topology);
+    auto reference = makeReference(c, {}, parameters);
+
+    const auto inputWidth = c.topology.front();
+    const auto targetWidth = c.topology.back();
+    auto batchLoss = [&](bool accumulate) {
+        auto loss = 0.0;
+        for (auto s = 0ul; s < options.batchSize; ++s)
+        {
+            reference.forward({data.inputs.data() + s * inputWidth, inputWidth});
+            const std::span<const double> target(data.targets.data() + s * targetWidth,
+                                                 targetWidth);
+            if (accumulate)
+                reference.accumulateGradients(target);
+            loss += reference.loss(target);
+        }
+        return loss;
+    };
+
+    batchLoss(true);
+    const auto gradients = reference.gradients();
+
+    return finiteDifferences(
+        std::string("reference / ") + c.name + " / finite differences", parameters, gradients,
+        [&] {
+            reference.setParameters(parameters);
+            return batchLoss(false);
+        },
+        options);
+}
+
+ValidationCheck engineFiniteDifferences(const std::string& prefix, const Case& c,
+                                        const Data& data, const ValidationOptions& options)
+{
+    auto parameters = initialParameters(c.topology);
+    Network network(c.topology);
+    configure(network, c, {}, parameters, 1);
+
+    const auto batch = options.batchSize;
+    const std::span<const double> inputs(data.inputs.data(), batch * c.topology.front());
+    const std::span<const double> targets(data.targets.data(), batch * c.topology.back());
+
+    network.forwardBatch(inputs, batch);
+    network.computeBatchGradients(targets);
+    const std::vector<double> gradients(network.gradients().begin(), network.gradients().end());
+
+    const auto width = c.topology.back();
+    return finiteDifferences(
+        prefix + " / finite differences", parameters, gradients,
+        [&] {
+            std::copy(parameters.begin(), parameters.end(), network.parameters().begin());
+            network.forwardBatch(inputs, batch);
+
+            const auto outputs = network.batchOutputs();
+            auto loss = 0.0;
+            for (auto s = 0ul; s < batch; ++s)
+                loss += sampleLoss(c.activations.back(), outputs.data() + s * width,
+                                   targets.data() + s * width, width);
+            return loss;
+        },
+        options);
+}
+
+template <typename M, typename N>
+void checkInference(const std::string& prefix, const Case& c, const Data& data,
+                    const std::vector<double>& parameters, const Expected& expected,
+                    const Tolerance& tolerance, const ValidationOptions& options,
+                    const std::function<void(const ValidationCheck&)>& report, bool& passed)
+{
+    using T = typename N::Scalar;
+
+    N network(c.topology);
+    configure(network, c, {}, parameters, 1);
+    const M model(network);
+
+    const std::vector<T> inputs(data.inputs.begin(),
+                                data.inputs.begin() +
+                                    static_cast<long>(options.batchSize * c.topology.front()));
+    auto scratch = model.makeScratch(options.batchSize);
+
+    const auto single = model.infer({inputs.data(), c.topology.front()}, scratch);
+    const auto outputs = compare(prefix + " / outputs",
+                                 std::vector<T>(single.begin(), single.end()), expected.outputs,
+                                 tolerance);
+    passed = passed && outputs.passed;
+    report(outputs);
+
+    const auto batch = model.inferBatch(inputs, options.batchSize, scratch);
+    const auto batchOutputs = compare(prefix + " / batch outputs",
+                                      std::vector<T>(batch.begin(), batch.end()),
+                                      expected.batchOutputs, tolerance);
+    passed = passed && batchOutputs.passed;
+    report(batchOutputs);
+}
+
+// The mixed precision product over a fan-in of several depth blocks, against the double sum
+// of the same float operands. Summing in double throughout leaves only the final narrowing, so
+// every element must be within one unit in the last place of the float-rounded reference.
+ValidationCheck checkMixedGemm(const std::string& prefix)
+{
+    constexpr auto m = 16ul;
+    constexpr auto n = 64ul;
+    constexpr auto k = 1000ul;
+
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> a(m * k);
+    std::vector<float> b(n * k);
+    for (auto& value : a)
+        value = dist(rng);
+    for (auto& value : b)
+        value = dist(rng);
+
+    std::vector<double> expected(m * n, 0.0);
+    for (auto i = 0ul; i < m; ++i)
+        for (auto j = 0ul; j < n; ++j)
+            for (auto p = 0ul; p < k; ++p)
+                expected[i * n + j] +=
+                    static_cast<double>(a[i * k + p]) * static_cast<double>(b[j * k + p]);
+
+    std::vector<float> actual(m * n);
+    Kernels::gemmNT<float, double>(a.data(), b.data(), actual.data(), m, n, k);
+
+    return compare(prefix + " / mixed gemm fan-in:" + std::to_string(k), actual, expected,
+                   {1, 0.0, 0.0});
+}
+
+} // namespace
+
+bool validateEngines(const ValidationOptions& options,
+                     const std::function<void(const ValidationCheck&)>& report)
+{
+    auto passed = true;
+    auto record = [&](const ValidationCheck& check) {
+        passed = passed && check.passed;
+        report(check);
+    };
+
+    // The reference itself first, nothing else is worth comparing with a wrong reference
+    for (const auto& c : s_cases)
+        record(referenceFiniteDifferences(c, makeData(c, options.batchSize), options));
+
+    const auto threads = std::max(options.threads, 2u);
+    for (auto isa : {Kernels::Isa::Scalar, Kernels::Isa::SSE2, Kernels::Isa::AVX2,
+                     Kernels::Isa::AVX512})
+    {
+        if (!Kernels::isSupported(isa))
+            continue;
+
+        Kernels::select(isa);
+        const std::string isaName = Kernels::table(isa).name;
+        record(checkMixedGemm(isaName));
+
+        for (auto index = 0ul; index < s_cases.size(); ++index)
+        {
+            const auto& c = s_cases[index];
+            const auto data = makeData(c, options.steps * options.batchSize);
+            const auto parameters = initialParameters(c.topology);
+            const auto caseName = isaName + " / " + c.name;
+
+            const auto fast = std::any_of(c.activations.begin(), c.activations.end(),
+                                          [](Activation a) {
+                                              return a == Activation::FastTanh ||
+                                                     a == Activation::FastSigmoid;
+                                          });
+            const auto extra = fast ? options.atolFast : 0.0;
+            const Tolerance exact{options.ulps, options.rtol, options.atol + extra};
+            const Tolerance single{options.ulps, options.rtolF32, options.atolF32 + extra};
+
+            record(engineFiniteDifferences(caseName, c, data, options));
+
+            for (const auto& optimizer : optimizers(c))
+            {
+                const auto expected = runReference(c, optimizer, data, parameters, options);
+                const auto prefix = caseName + " / " + optimizerName(optimizer.type);
+
+                for (auto t : {1u, threads})
+                {
+                    const auto suffix = t > 1 ? " threads:" + std::to_string(t) : "";
+                    auto run = [&](auto make) {
+                        using N = decltype(make());
+                        return runEngine<N>(make, c, optimizer, data, parameters, options, t);
+                    };
+
+                    compareAll(prefix + " / double" + suffix,
+                               run([&] { return Network(c.topology); }), expected, exact,
+                               options, record, passed);
+                    compareAll(prefix + " / float" + suffix,
+                               run([&] { return NetworkF32(c.topology); }), expected, single,
+                               options, record, passed);
+                    compareAll(prefix + " / mixed" + suffix,
+                               run([&] { return NetworkMixed(c.topology); }), expected, single,
+                               options, record, passed);
+                }
+
+                if (index == 0)
+                {
+                    auto run = [&](auto make) {
+                        using N = decltype(make());
+                        return runEngine<N>(make, c, optimizer, data, parameters, options, 1);
+                    };
+
+                    compareAll(prefix + " / static double", run([] { return StaticCase(); }),
+                               expected, exact, options, record, passed);
+                    compareAll(prefix + " / static float", run([] { return StaticCaseF32(); }),
+                               expected, single, options, record, passed);
+                }
+
+                // Inference does not train, once per network is enough
+                if (optimizer.type == OptimizerType::Momentum)
+                {
+                    checkInference<InferenceModel, Network>(caseName + " / inference double", c,
+                                                            data, parameters, expected, exact,
+                                                            options, record, passed);
+                    checkInference<InferenceModelF32, NetworkF32>(
+                        caseName + " / inference float", c, data, parameters, expected, single,
+                        options, record, passed);
+                }
+            }
+        }
+    }
+
+    Kernels::select(Kernels::detectIsa());
+    return passed;
+}
+
+} // namespace Engine
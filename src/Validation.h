@@ -0,0 +1,54 @@
+/* Numerical validation of the optimized engines. Every fast path, each vector instruction set,
+ * per-sample and mini-batch training, single precision and mixed precision, threads, the
+ * static network and inference, is run side by side with ReferenceNetwork from the same
+ * weights and data and compared element by element: outputs of the first pass, summed
+ * gradients of a batch and every parameter after a number of training steps. Finite
+ * differences check the gradients of both the engine and the reference against the loss.
+ *
+ * An element matches when it is within a number of units in the last place of the reference,
+ * or within atol + rtol * |reference|. Single precision engines and the approximated
+ * activations get their own, looser bounds. */
+#pragma once
+
+// clang-format off
+#include <functional>
+#include <string>
+// clang-format on
+
+namespace Engine {
+
+struct ValidationOptions
+{
+    unsigned long steps = 16;    // training steps compared, per sample or per batch
+    unsigned long batchSize = 8;
+    unsigned int threads = 4;    // of the threaded engines, the calling thread included
+
+    unsigned long ulps = 16;
+    double rtol = 1e-9;
+    double atol = 1e-12;
+    double rtolF32 = 1e-3;
+    double atolF32 = 1e-4;
+    double atolFast = 1e-5; // added for FastTanh and FastSigmoid, which are approximations
+
+    double fdEpsilon = 1e-6;
+    double fdTolerance = 1e-6;      // relative to the gradient, at least absolute
+    unsigned long fdParameters = 64; // checked per network, spread over all shells
+};
+
+struct ValidationCheck
+{
+    std::string name; // instruction set / network / optimizer / engine / quantity
+    bool passed = true;
+    unsigned long elements = 0;
+    unsigned long worst = 0; // index of the element furthest from the reference
+    double maxUlps = 0.0;
+    double maxAbsolute = 0.0;
+    double maxRelative = 0.0;
+};
+
+// Runs every check on every instruction set this CPU supports and reports each one as it
+// completes. Returns whether all of them passed. Leaves the widest kernels selected.
+bool validateEngines(const ValidationOptions& options,
+                     const std::function<void(const ValidationCheck&)>& report);
+
+} // namespace Engine
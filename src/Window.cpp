@@ -3,6 +3,7 @@
 #include "Events/KeyEvents.h"
 #include "Events/WindowEvents.h"
 #include "Events/MouseEvents.h"
+#include "Profiler.h"
 #include <utility>
 // clang-format on
 
@@ -129,9 +130,15 @@ Window::~Window()
     glfwTerminate();
 }
 
-void Window::update()
+void Window::swapBuffers()
 {
+    ENGINE_PROFILE_SCOPE("swap buffers");
     glfwSwapBuffers(m_context);
+}
+
+void Window::pollEvents()
+{
+    ENGINE_PROFILE_SCOPE("poll events");
     glfwPollEvents();
 }
 
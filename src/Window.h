@@ -20,7 +20,9 @@ public:
     ~Window();
 
 public:
-    void update();
+    // Separate, so the frame statistics can tell presenting from input handling
+    void swapBuffers();
+    void pollEvents();
     void setCallbackFunction(const CallbackFn& fn);
     inline GLFWwindow* context() { return m_context; }
 